@@ -106,6 +106,12 @@ namespace Genode {
 			 */
 			size_t max_caps() const override { return 10000; }
 
+			/*
+			 * RAM dataspaces are backed by files that are zero-initialized
+			 * by the Linux kernel
+			 */
+			bool supports_background_zeroing() const override { return false; }
+
 			void wait_for_exit();
 	};
 }
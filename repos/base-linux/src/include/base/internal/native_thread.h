@@ -48,6 +48,19 @@ struct Genode::Native_thread
 
 	Socket_pair socket_pair;
 
+	/**
+	 * Reply channel used when the thread acts as RPC client
+	 *
+	 * The socket pair is created at the first RPC of the thread and reused
+	 * for all subsequent RPCs. The remote socket is passed along with each
+	 * request.
+	 */
+	struct Reply_channel
+	{
+		int local_sd  = -1;
+		int remote_sd = -1;
+	} reply_channel;
+
 	Native_thread() { }
 };
 
@@ -349,6 +349,60 @@ static inline void lx_reply(int reply_socket, Rpc_exception_code exception_code,
  ** IPC client **
  ****************/
 
+namespace {
+
+	/**
+	 * Persistent reply channel of the calling thread
+	 */
+	class Reply_channel
+	{
+		private:
+
+			Native_thread::Reply_channel &_sds;
+
+			static Native_thread::Reply_channel &_sds_of_myself()
+			{
+				/* the main thread has no 'Thread' object */
+				static Native_thread::Reply_channel main_thread_sds;
+
+				Thread * const myself = Thread::myself();
+				return myself ? myself->native_thread().reply_channel
+				              : main_thread_sds;
+			}
+
+		public:
+
+			Reply_channel() : _sds(_sds_of_myself())
+			{
+				if (_sds.local_sd != -1)
+					return;
+
+				int sd[2] = { -1, -1 };
+				int ret = lx_socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, sd);
+				if (ret < 0) {
+					PRAW("[%d] lx_socketpair failed with %d", lx_getpid(), ret);
+					throw Genode::Ipc_error();
+				}
+				_sds.local_sd  = sd[0];
+				_sds.remote_sd = sd[1];
+			}
+
+			int local_socket()  const { return _sds.local_sd;  }
+			int remote_socket() const { return _sds.remote_sd; }
+
+			/**
+			 * Close channel, a new one is created at the next call
+			 */
+			void discard()
+			{
+				lx_close(_sds.local_sd);
+				lx_close(_sds.remote_sd);
+				_sds.local_sd = _sds.remote_sd = -1;
+			}
+	};
+}
+
+
 Rpc_exception_code Genode::ipc_call(Native_capability dst,
                                     Msgbuf_base &snd_msgbuf, Msgbuf_base &rcv_msgbuf,
                                     size_t)
@@ -360,36 +414,13 @@ Rpc_exception_code Genode::ipc_call(Native_capability dst,
 	                sizeof(Protocol_header) + snd_msgbuf.data_size());
 
 	/*
-	 * Create reply channel
+	 * Obtain reply channel of the calling thread
 	 *
-	 * The reply channel will be closed when leaving the scope of 'lx_call'.
+	 * The reply channel is kept across calls. It gets discarded if a call
+	 * fails to receive its reply so that a late reply cannot be mistaken
+	 * for the reply of a subsequent call.
 	 */
-	struct Reply_channel
-	{
-		enum { LOCAL_SOCKET = 0, REMOTE_SOCKET = 1 };
-		int sd[2];
-
-		Reply_channel()
-		{
-			sd[LOCAL_SOCKET] = -1; sd[REMOTE_SOCKET] = -1;
-
-			int ret = lx_socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, sd);
-			if (ret < 0) {
-				PRAW("[%d] lx_socketpair failed with %d", lx_getpid(), ret);
-				throw Genode::Ipc_error();
-			}
-		}
-
-		~Reply_channel()
-		{
-			if (sd[LOCAL_SOCKET]  != -1) lx_close(sd[LOCAL_SOCKET]);
-			if (sd[REMOTE_SOCKET] != -1) lx_close(sd[REMOTE_SOCKET]);
-		}
-
-		int local_socket()  const { return sd[LOCAL_SOCKET];  }
-		int remote_socket() const { return sd[REMOTE_SOCKET]; }
-
-	} reply_channel;
+	Reply_channel reply_channel;
 
 	/* assemble message */
 
@@ -421,11 +452,14 @@ Rpc_exception_code Genode::ipc_call(Native_capability dst,
 	int const recv_ret = lx_recvmsg(reply_channel.local_socket(), rcv_msg.msg(), 0);
 
 	/* system call got interrupted by a signal */
-	if (recv_ret == -LX_EINTR)
+	if (recv_ret == -LX_EINTR) {
+		reply_channel.discard();
 		throw Genode::Blocking_canceled();
+	}
 
 	if (recv_ret < 0) {
 		PRAW("[%d] lx_recvmsg failed with %d in lx_call()", lx_getpid(), recv_ret);
+		reply_channel.discard();
 		throw Genode::Ipc_error();
 	}
 
@@ -129,6 +129,11 @@ void Thread::_deinit_platform_thread()
 		lx_nanosleep(&ts, 0);
 	}
 
+	/* release reply channel used by the thread for its RPCs */
+	Native_thread::Reply_channel &reply_channel = native_thread().reply_channel;
+	if (reply_channel.local_sd  != -1) lx_close(reply_channel.local_sd);
+	if (reply_channel.remote_sd != -1) lx_close(reply_channel.remote_sd);
+
 	/* inform core about the killed thread */
 	_cpu_session->kill_thread(_thread_cap);
 }
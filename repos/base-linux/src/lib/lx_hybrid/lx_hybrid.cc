@@ -543,6 +543,11 @@ Thread::~Thread()
 			        "with ", ret, " (errno=", errno, ")");
 	}
 
+	/* release reply channel used by the thread for its RPCs */
+	Native_thread::Reply_channel &reply_channel = native_thread().reply_channel;
+	if (reply_channel.local_sd  != -1) lx_close(reply_channel.local_sd);
+	if (reply_channel.remote_sd != -1) lx_close(reply_channel.remote_sd);
+
 	Thread_meta_data_created *meta_data =
 		dynamic_cast<Thread_meta_data_created *>(native_thread().meta_data);
 
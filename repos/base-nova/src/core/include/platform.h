@@ -80,6 +80,12 @@ namespace Genode {
 			bool supports_unmap() override { return true; }
 			bool supports_direct_unmap() const override { return true; }
 
+			/*
+			 * Core threads are local ECs without scheduling context and
+			 * cannot run in the background
+			 */
+			bool supports_background_zeroing() const override { return false; }
+
 
 			Affinity::Space affinity_space() const override { return _cpus; }
 
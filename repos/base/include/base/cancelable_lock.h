@@ -67,6 +67,18 @@ class Genode::Cancelable_lock
 		Applicant* volatile _last_applicant;
 		Applicant  _owner;
 
+		/**
+		 * Acquire lock if free
+		 */
+		bool _try_lock(Applicant &myself);
+
+		/**
+		 * Spin for a contended lock to become free
+		 *
+		 * \return  true if the lock was acquired
+		 */
+		bool _spin(Applicant &myself);
+
 	public:
 
 		enum State { LOCKED, UNLOCKED };
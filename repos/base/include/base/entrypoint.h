@@ -19,11 +19,13 @@
 #include <base/rpc_server.h>
 #include <base/signal.h>
 #include <base/thread.h>
+#include <base/allocator.h>
 
 
 namespace Genode {
 	class Startup;
 	class Entrypoint;
+	class Entrypoint_pool;
 	class Env;
 }
 
@@ -48,12 +50,27 @@ class Genode::Entrypoint : Genode::Noncopyable
 		struct Signal_proxy_component :
 			Rpc_object<Signal_proxy, Signal_proxy_component>
 		{
+			/*
+			 * Number of pending signals dispatched per 'signal' call at
+			 * most, which bounds the delay of RPC requests
+			 */
+			enum { MAX_SIGNALS_PER_CALL = 32 };
+
 			Entrypoint &ep;
 			Signal_proxy_component(Entrypoint &ep) : ep(ep) { }
 
 			void signal();
 		};
 
+		/*
+		 * The entrypoint cannot block for RPC requests and signals at the
+		 * same time because the generic IPC interface has no such
+		 * combined wait. Hence, a proxy thread blocks for signals and
+		 * forwards them to the entrypoint via the 'Signal_proxy' RPC. Each
+		 * signal still costs the round trip through the proxy thread
+		 * unless it is dispatched along with other pending signals, up to
+		 * 'MAX_SIGNALS_PER_CALL' per RPC.
+		 */
 		struct Signal_proxy_thread : Thread
 		{
 			enum { STACK_SIZE = 2*1024*sizeof(long) };
@@ -206,4 +223,102 @@ class Genode::Entrypoint : Genode::Noncopyable
 		}
 };
 
+
+/**
+ * Pool of RPC entrypoints that serve RPC objects by multiple threads
+ *
+ * Each RPC object managed by the pool is assigned to one of the pool's
+ * threads, which dispatches all RPC requests for the object. The threads
+ * are pinned to distinct CPUs. The pool is meant for servers with many
+ * sessions that are independent from each other, e.g., a ROM service.
+ *
+ * The following rules apply to the objects of a server using the pool:
+ *
+ * - The state of an RPC object is confined to the thread serving it.
+ *   Its RPC functions need no locking as long as they access only the
+ *   object's own state.
+ *
+ * - State shared by RPC objects, e.g., a registry that sessions look up
+ *   data from, is accessed by several threads concurrently and must be
+ *   synchronized by the server.
+ *
+ * - Signal handlers and the root interface are still executed by the
+ *   component's 'Entrypoint'. They may create and destroy RPC objects of
+ *   the pool. Destroying an object waits until its current RPC is finished.
+ *   Any other access to the state of an RPC object from a signal handler
+ *   must be synchronized with the pool thread serving the object.
+ */
+class Genode::Entrypoint_pool : Genode::Noncopyable
+{
+	public:
+
+		enum { MAX_THREADS = 32 };
+
+	private:
+
+		Allocator      &_alloc;
+		unsigned const  _num_threads;
+		Rpc_entrypoint *_eps[MAX_THREADS];
+
+		Lock     _lock;
+		unsigned _next = 0;
+
+		/**
+		 * Select entrypoint for a new RPC object
+		 */
+		Rpc_entrypoint &_select()
+		{
+			Lock::Guard guard(_lock);
+			Rpc_entrypoint &ep = *_eps[_next];
+			_next = (_next + 1) % _num_threads;
+			return ep;
+		}
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param num_threads  number of entrypoint threads, limited to
+		 *                     'MAX_THREADS'
+		 * \param cpus         CPUs to distribute the threads over, the
+		 *                     whole affinity space of the component by
+		 *                     default
+		 */
+		Entrypoint_pool(Env &env, Allocator &alloc, unsigned num_threads,
+		                size_t stack_size, char const *name,
+		                Affinity::Location cpus = Affinity::Location());
+
+		~Entrypoint_pool();
+
+		unsigned num_threads() const { return _num_threads; }
+
+		/**
+		 * Associate RPC object with one of the pool's entrypoints
+		 */
+		template <typename RPC_INTERFACE, typename RPC_SERVER>
+		Capability<RPC_INTERFACE>
+		manage(Rpc_object<RPC_INTERFACE, RPC_SERVER> &obj)
+		{
+			return _select().manage(&obj);
+		}
+
+		/**
+		 * Return entrypoint that serves the RPC object of the capability
+		 *
+		 * If no entrypoint of the pool knows the capability, the first
+		 * entrypoint is returned, on which an 'apply' yields a null pointer.
+		 */
+		Rpc_entrypoint &ep_of(Untyped_capability cap)
+		{
+			for (unsigned i = 0; i < _num_threads; i++) {
+				bool const managed = _eps[i]->apply(cap, [] (Rpc_object_base *obj) {
+					return obj != nullptr; });
+				if (managed)
+					return *_eps[i];
+			}
+			return *_eps[0];
+		}
+};
+
 #endif /* _INCLUDE__BASE__ENTRYPOINT_H_ */
@@ -34,6 +34,11 @@ namespace Genode {
  * The heap class provides an allocator that uses a list of dataspaces of a RAM
  * allocator as backing store. One dataspace may be used for holding multiple
  * blocks.
+ *
+ * Optionally, small blocks are served by a front end of size classes, see
+ * 'size_classes'. Each size class manages its blocks as slots of dedicated
+ * dataspaces, which are returned to the RAM allocator once they become
+ * completely free.
  */
 class Genode::Heap : public Allocator
 {
@@ -78,6 +83,13 @@ class Genode::Heap : public Allocator
 		size_t                         _quota_used;
 		size_t                         _chunk_size;
 
+		/*
+		 * State of the size-class front end, allocated when the front end
+		 * gets enabled for the first time
+		 */
+		struct Size_classes;
+		Size_classes                  *_size_classes = nullptr;
+
 		/**
 		 * Allocate a new dataspace of the specified size
 		 *
@@ -133,6 +145,15 @@ class Genode::Heap : public Allocator
 		void reassign_resources(Ram_allocator *ram, Region_map *rm) {
 			_ds_pool.reassign_resources(ram, rm); }
 
+		/**
+		 * Enable or disable the size-class front end for small blocks
+		 *
+		 * Blocks allocated via the front end are accounted with the slot
+		 * size of their size class. Disabling the front end affects new
+		 * allocations only.
+		 */
+		void size_classes(bool enabled);
+
 
 		/*************************
 		 ** Allocator interface **
@@ -107,6 +107,20 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 		 */
 		Rpc_entrypoint *_ep;
 
+		/*
+		 * Optional pool of entry points that manages the session
+		 * objects instead of '_ep'
+		 */
+		Entrypoint_pool *_ep_pool = nullptr;
+
+		/**
+		 * Return entry point that manages the specified session
+		 */
+		Rpc_entrypoint &_session_ep(Session_capability session)
+		{
+			return _ep_pool ? _ep_pool->ep_of(session) : *_ep;
+		}
+
 		/*
 		 * Allocator for allocating session objects.
 		 * This allocator must be used by the derived
@@ -198,8 +212,10 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 			 * Consider that the session-object constructor may already have
 			 * called 'manage'.
 			 */
-			if (!s->cap().valid())
-				_ep->manage(s);
+			if (!s->cap().valid()) {
+				if (_ep_pool) _ep_pool->manage(*s);
+				else          _ep->manage(s);
+			}
 
 			aquire_guard.ack = true;
 			return *s;
@@ -289,6 +305,21 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 			_ep(&ep.rpc_ep()), _md_alloc(&md_alloc)
 		{ }
 
+		/**
+		 * Constructor
+		 *
+		 * \param ep        entry point that serves the root interface
+		 * \param ep_pool   pool of entry points that manages the sessions
+		 *                  of this root interface
+		 * \param md_alloc  meta-data allocator providing the backing store
+		 *                  for session objects
+		 */
+		Root_component(Entrypoint &ep, Entrypoint_pool &ep_pool,
+		               Allocator &md_alloc)
+		:
+			_ep(&ep.rpc_ep()), _ep_pool(&ep_pool), _md_alloc(&md_alloc)
+		{ }
+
 		/**
 		 * Constructor
 		 *
@@ -342,7 +373,7 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 		{
 			if (!args.valid_string()) throw Service_denied();
 
-			_ep->apply(session, [&] (SESSION_TYPE *s) {
+			_session_ep(session).apply(session, [&] (SESSION_TYPE *s) {
 				if (!s) return;
 
 				_upgrade_session(s, args.string());
@@ -353,11 +384,13 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 		{
 			SESSION_TYPE * session;
 
-			_ep->apply(session_cap, [&] (SESSION_TYPE *s) {
+			Rpc_entrypoint &ep = _session_ep(session_cap);
+
+			ep.apply(session_cap, [&] (SESSION_TYPE *s) {
 				session = s;
 
 				/* let the entry point forget the session object */
-				if (session) _ep->dissolve(session);
+				if (session) ep.dissolve(session);
 			});
 
 			if (!session) return;
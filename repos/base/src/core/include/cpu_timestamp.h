@@ -0,0 +1,41 @@
+/*
+ * \brief  CPU timestamp for core-internal statistics
+ * \author agent
+ * \date   2026-10-19
+ *
+ * Core cannot use 'Trace::timestamp' because the per-architecture headers
+ * are not part of every base-* source archive. Statistics that only need
+ * relative durations use the timestamp counter where it is accessible
+ * and report zero otherwise.
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _CORE__INCLUDE__CPU_TIMESTAMP_H_
+#define _CORE__INCLUDE__CPU_TIMESTAMP_H_
+
+namespace Genode {
+
+	typedef unsigned long long Cpu_timestamp;
+
+	/**
+	 * Return CPU timestamp, or zero if not supported by the architecture
+	 */
+	inline Cpu_timestamp cpu_timestamp()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		unsigned lo, hi;
+		asm volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+		return ((Cpu_timestamp)hi << 32) | lo;
+#else
+		return 0;
+#endif
+	}
+}
+
+#endif /* _CORE__INCLUDE__CPU_TIMESTAMP_H_ */
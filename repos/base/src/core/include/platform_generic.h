@@ -109,6 +109,14 @@ namespace Genode {
 			 * Return true if the core component relies on a 'Platform_pd' object
 			 */
 			virtual bool core_needs_platform_pd() const { return true; }
+
+			/**
+			 * Return true if core may clear RAM in the background
+			 *
+			 * This is the case if core can run a thread that is not
+			 * bound to an RPC entrypoint.
+			 */
+			virtual bool supports_background_zeroing() const { return true; }
 	};
 
 
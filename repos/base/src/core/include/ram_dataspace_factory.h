@@ -36,6 +36,12 @@ class Genode::Ram_dataspace_factory : public Ram_allocator,
 
 		static Phys_range any_phys_range() { return { 0UL, ~0UL }; }
 
+		/*
+		 * Alignment of dataspaces that are large enough to be mapped with
+		 * superpages (2 MiB on x86, which covers the 1 MiB sections on ARM)
+		 */
+		enum { SUPERPAGE_SIZE_LOG2 = 21 };
+
 		/*
 		 * Dimension '_ds_slab' such that slab blocks (including the
 		 * meta-data overhead of the sliced-heap blocks) are page sized.
@@ -73,20 +79,30 @@ class Genode::Ram_dataspace_factory : public Ram_allocator,
 		 *
 		 * \throw Core_virtual_memory_exhausted
 		 */
-		void _export_ram_ds(Dataspace_component *ds);
+		static void _export_ram_ds(Dataspace_component *ds);
 
 		/**
 		 * Revert export of RAM dataspace
 		 */
-		void _revoke_ram_ds(Dataspace_component *ds);
+		static void _revoke_ram_ds(Dataspace_component *ds);
 
 		/**
 		 * Zero-out content of dataspace
 		 */
-		void _clear_ds(Dataspace_component *ds);
+		static void _clear_ds(Dataspace_component *ds);
 
 	public:
 
+		/**
+		 * Zero-out physical memory range
+		 *
+		 * This function is used by the pool of pre-zeroed memory, which
+		 * clears memory outside the context of a dataspace.
+		 *
+		 * \return  false if the range could not be exported
+		 */
+		static bool clear_phys(addr_t phys, size_t size);
+
 		Ram_dataspace_factory(Rpc_entrypoint  &ep,
 		                      Range_allocator &phys_alloc,
 		                      Phys_range       phys_range,
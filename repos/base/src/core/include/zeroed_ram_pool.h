@@ -0,0 +1,327 @@
+/*
+ * \brief  Pool of pre-zeroed physical memory
+ * \author Norman Feske
+ * \date   2017-07-14
+ *
+ * RAM dataspaces must be cleared before they are handed out. Instead of
+ * clearing the backing store of a new dataspace within the RPC call of the
+ * client, core keeps a pool of physical memory that is cleared in advance
+ * by a background thread. The memory of the pool is allocated at core's
+ * physical-memory allocator. A dataspace served by the pool takes over the
+ * needed part of a pool chunk, the rest of the chunk stays in the pool.
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _CORE__INCLUDE__ZEROED_RAM_POOL_H_
+#define _CORE__INCLUDE__ZEROED_RAM_POOL_H_
+
+/* Genode includes */
+#include <base/allocator.h>
+#include <base/lock.h>
+#include <base/log.h>
+#include <base/semaphore.h>
+#include <base/thread.h>
+#include <util/misc_math.h>
+#include <util/reconstructible.h>
+
+/* core includes */
+#include <cpu_timestamp.h>
+
+namespace Genode {
+
+	class Zeroed_ram_pool;
+
+	Zeroed_ram_pool &zeroed_ram_pool();
+}
+
+
+class Genode::Zeroed_ram_pool
+{
+	public:
+
+		enum {
+			CHUNK_SIZE  = 4*1024*1024,
+			POOL_SIZE   = 4*CHUNK_SIZE,  /* upper bound of zeroed memory */
+
+			/* do not take memory for the pool if less is free */
+			MIN_FREE_FOR_REFILL = 4*POOL_SIZE,
+		};
+
+		/* accumulated 'cpu_timestamp' differences */
+		typedef unsigned long long Ticks;
+
+		/**
+		 * Function used for clearing a physical-memory range
+		 *
+		 * \return  false if the range could not be cleared
+		 */
+		typedef bool (*Clear_fn)(addr_t phys, size_t size);
+
+		typedef unsigned long long Bytes;
+
+		struct Stats
+		{
+			unsigned long hits;          /* allocations served by the pool  */
+			unsigned long misses;        /* allocations cleared on demand   */
+			Bytes         hit_bytes;
+			Bytes         sync_bytes;    /* bytes cleared on demand         */
+			Ticks         sync_ticks;    /* ticks spent clearing on demand  */
+			Bytes         refill_bytes;  /* bytes cleared in the background */
+			Ticks         refill_ticks;
+
+			/**
+			 * Estimate clearing time saved by the pool
+			 */
+			Ticks saved_ticks() const
+			{
+				Bytes const sync_pages = sync_bytes / 4096;
+				return sync_pages ? hit_bytes / 4096 * (sync_ticks / sync_pages) : 0;
+			}
+		};
+
+	private:
+
+		enum { MAX_CHUNKS = 64 };
+
+		struct Chunk { addr_t addr; size_t size; };
+
+		Range_allocator *_phys_alloc = nullptr;
+		Clear_fn         _clear      = nullptr;
+
+		Lock      _lock;
+		Chunk     _chunks[MAX_CHUNKS];
+		unsigned  _num_chunks = 0;
+		size_t    _avail      = 0;     /* number of zeroed bytes */
+		Stats     _stats { };
+
+		Semaphore _refill_sem;
+
+		struct Refill_thread : Thread_deprecated<2048*sizeof(long)>
+		{
+			Zeroed_ram_pool &pool;
+
+			Refill_thread(Zeroed_ram_pool &pool)
+			: Thread_deprecated("zeroed_ram"), pool(pool) { start(); }
+
+			void entry() override
+			{
+				for (;;) {
+					pool._refill_sem.down();
+					while (pool._refill_one_chunk());
+				}
+			}
+		};
+
+		Constructible<Refill_thread> _refill_thread;
+
+		/**
+		 * Must be called with '_lock' held
+		 */
+		void _add_chunk(addr_t addr, size_t size)
+		{
+			_chunks[_num_chunks++] = Chunk { addr, size };
+			_avail += size;
+		}
+
+		/**
+		 * Must be called with '_lock' held
+		 */
+		void _remove_chunk(unsigned i)
+		{
+			_avail -= _chunks[i].size;
+			_chunks[i] = _chunks[--_num_chunks];
+		}
+
+		bool _refill_one_chunk()
+		{
+			{
+				Lock::Guard guard(_lock);
+				if (_avail + CHUNK_SIZE > POOL_SIZE || _num_chunks == MAX_CHUNKS)
+					return false;
+			}
+
+			if (_phys_alloc->avail() < MIN_FREE_FOR_REFILL)
+				return false;
+
+			/* prefer naturally aligned chunks in high memory, see 'alloc' */
+			addr_t const high_start = (sizeof(void *) == 4 ? 3UL : 4UL) << 30;
+
+			void *addr = nullptr;
+			if (_phys_alloc->alloc_aligned(CHUNK_SIZE, &addr, log2((size_t)CHUNK_SIZE),
+			                               high_start, ~0UL).error() &&
+			    _phys_alloc->alloc_aligned(CHUNK_SIZE, &addr,
+			                               log2((size_t)CHUNK_SIZE)).error())
+				return false;
+
+			Cpu_timestamp const start = cpu_timestamp();
+
+			if (!_clear((addr_t)addr, CHUNK_SIZE)) {
+				_phys_alloc->free(addr);
+				return false;
+			}
+
+			Lock::Guard guard(_lock);
+
+			_stats.refill_bytes += CHUNK_SIZE;
+			_stats.refill_ticks += cpu_timestamp() - start;
+
+			_add_chunk((addr_t)addr, CHUNK_SIZE);
+			return true;
+		}
+
+		/**
+		 * Log statistics whenever the number of hits reaches a power of two
+		 *
+		 * Must be called with '_lock' held
+		 */
+		void _report()
+		{
+			unsigned long const hits = _stats.hits;
+			if (!hits || (hits & (hits - 1)))
+				return;
+
+			log("zeroed RAM pool: ", hits, " hits (", _stats.hit_bytes / 1024, " KiB), ",
+			    _stats.misses, " misses (", _stats.sync_bytes / 1024, " KiB cleared in ",
+			    _stats.sync_ticks, " ticks), ~", _stats.saved_ticks(), " ticks saved, ",
+			    _stats.refill_bytes / 1024, " KiB cleared in background in ",
+			    _stats.refill_ticks, " ticks");
+		}
+
+	public:
+
+		/**
+		 * Start refilling the pool in the background
+		 *
+		 * \param phys_alloc  core's physical-memory allocator
+		 * \param clear       function for clearing physical memory
+		 */
+		void start(Range_allocator &phys_alloc, Clear_fn clear)
+		{
+			_phys_alloc = &phys_alloc;
+			_clear      = clear;
+
+			_refill_thread.construct(*this);
+			_refill_sem.up();
+		}
+
+		/**
+		 * Allocate zeroed physical memory within [range_start, range_end]
+		 *
+		 * \return  true if the allocation was served by the pool
+		 */
+		bool alloc(size_t size, addr_t range_start, addr_t range_end, void **out_addr)
+		{
+			Lock::Guard guard(_lock);
+
+			if (!_phys_alloc)
+				return false;
+
+			/*
+			 * Dataspaces must not lose their natural alignment, which
+			 * enables the use of large mappings. Chunks are aligned to their
+			 * size at most.
+			 */
+			size_t const align_log2 = min(log2(size), log2((size_t)CHUNK_SIZE));
+			addr_t const align_mask = (1UL << align_log2) - 1;
+
+			/* select best-fitting chunk */
+			unsigned best = _num_chunks;
+			for (unsigned i = 0; i < _num_chunks; i++) {
+
+				Chunk const &c = _chunks[i];
+
+				if (c.size < size || c.addr < range_start || c.addr + size - 1 > range_end)
+					continue;
+
+				if (c.addr & align_mask)
+					continue;
+
+				if (best == _num_chunks || c.size < _chunks[best].size)
+					best = i;
+			}
+
+			if (best == _num_chunks) {
+				_stats.misses++;
+				return false;
+			}
+
+			Chunk const c = _chunks[best];
+			_remove_chunk(best);
+
+			if (_avail < POOL_SIZE / 2)
+				_refill_sem.up();
+
+			/*
+			 * Hand over the first part of the chunk to the dataspace by
+			 * re-allocating the chunk at the physical-memory allocator. If
+			 * the allocator meanwhile handed out the memory to someone else,
+			 * the zeroed content is lost.
+			 */
+			if (c.size != size) {
+				_phys_alloc->free((void *)c.addr);
+
+				if (_phys_alloc->alloc_addr(size, c.addr).error()) {
+					_stats.misses++;
+					return false;
+				}
+
+				if (_phys_alloc->alloc_addr(c.size - size, c.addr + size).ok()) {
+					if (_num_chunks < MAX_CHUNKS)
+						_add_chunk(c.addr + size, c.size - size);
+					else
+						_phys_alloc->free((void *)(c.addr + size));
+				}
+			}
+
+			*out_addr = (void *)c.addr;
+
+			_stats.hits++;
+			_stats.hit_bytes += size;
+			_report();
+
+			return true;
+		}
+
+		/**
+		 * Return zeroed memory to the physical-memory allocator
+		 *
+		 * \return  true if any memory was released
+		 */
+		bool release()
+		{
+			Lock::Guard guard(_lock);
+
+			bool const released = _num_chunks > 0;
+
+			while (_num_chunks) {
+				_phys_alloc->free((void *)_chunks[_num_chunks - 1].addr);
+				_remove_chunk(_num_chunks - 1);
+			}
+			return released;
+		}
+
+		/**
+		 * Account memory cleared within an allocation
+		 */
+		void account_sync_clear(size_t size, Ticks ticks)
+		{
+			Lock::Guard guard(_lock);
+
+			_stats.sync_bytes += size;
+			_stats.sync_ticks += ticks;
+		}
+
+		Stats stats()
+		{
+			Lock::Guard guard(_lock);
+			return _stats;
+		}
+};
+
+#endif /* _CORE__INCLUDE__ZEROED_RAM_POOL_H_ */
@@ -39,6 +39,8 @@
 #include <irq_root.h>
 #include <trace/root.h>
 #include <platform_services.h>
+#include <ram_dataspace_factory.h>
+#include <zeroed_ram_pool.h>
 
 using namespace Genode;
 
@@ -281,7 +283,17 @@ int main()
 	size_t const avail_ram_quota = core_pd.avail_ram().value;
 	size_t const avail_cap_quota = core_pd.avail_caps().value;
 
-	size_t const preserved_ram_quota = 224*1024;
+	/*
+	 * The pool of pre-zeroed RAM holds up to 'POOL_SIZE' bytes of physical
+	 * memory, which must not be promised to init. The pool is used only if
+	 * the platform has plenty of RAM.
+	 */
+	bool const background_zeroing =
+		platform()->supports_background_zeroing()
+		&& avail_ram_quota >= Zeroed_ram_pool::MIN_FREE_FOR_REFILL;
+
+	size_t const preserved_ram_quota = 224*1024
+	                                 + (background_zeroing ? Zeroed_ram_pool::POOL_SIZE : 0);
 	size_t const preserved_cap_quota = 1000;
 
 	if (avail_ram_quota < preserved_ram_quota) {
@@ -306,6 +318,11 @@ int main()
 	log("", init_ram_quota.value / (1024*1024), " MiB RAM and ", init_cap_quota, " caps "
 	    "assigned to init");
 
+	/* clear RAM for future dataspaces while init is starting up */
+	if (background_zeroing)
+		zeroed_ram_pool().start(*platform()->ram_alloc(),
+		                        Ram_dataspace_factory::clear_phys);
+
 	static Reconstructible<Core_child>
 		init(services, local_rm,  core_pd,  core_pd_cap, core_cpu, core_cpu_cap,
 		     init_cap_quota, init_ram_quota);
@@ -16,10 +16,32 @@
 
 /* core includes */
 #include <ram_dataspace_factory.h>
+#include <zeroed_ram_pool.h>
 
 using namespace Genode;
 
 
+Zeroed_ram_pool &Genode::zeroed_ram_pool()
+{
+	static Zeroed_ram_pool inst;
+	return inst;
+}
+
+
+bool Ram_dataspace_factory::clear_phys(addr_t phys, size_t size)
+{
+	/* temporary dataspace, not owned by any factory */
+	Dataspace_component ds(size, phys, CACHED, true, nullptr);
+
+	try { _export_ram_ds(&ds); }
+	catch (Core_virtual_memory_exhausted) { return false; }
+
+	_clear_ds(&ds);
+	_revoke_ram_ds(&ds);
+	return true;
+}
+
+
 Ram_dataspace_capability
 Ram_dataspace_factory::alloc(size_t ds_size, Cache_attribute cached)
 {
@@ -35,20 +57,34 @@ Ram_dataspace_factory::alloc(size_t ds_size, Cache_attribute cached)
 	 * As an optimization for the use of large mapping sizes, we try to
 	 * align the dataspace in physical memory naturally (size-aligned).
 	 * If this does not work, we subsequently weaken the alignment constraint
-	 * until the allocation succeeds.
+	 * until the allocation succeeds. Dataspaces that can be mapped with
+	 * superpages prefer a superpage-aligned location over the high
+	 * physical memory.
 	 */
 	void *ds_addr = 0;
 	bool alloc_succeeded = false;
 
+	/*
+	 * Take memory that was cleared in the background if available. The
+	 * pool holds cached memory only because the clearing of non-cached
+	 * memory involves flushing the caches of the dataspace range.
+	 */
+	bool const zeroed = (cached == CACHED)
+	                 && zeroed_ram_pool().alloc(ds_size, _phys_range.start,
+	                                            _phys_range.end, &ds_addr);
+	alloc_succeeded = zeroed;
+
 	/*
 	 * If no physical constraint exists, try to allocate physical memory at
 	 * high locations (3G for 32-bit / 4G for 64-bit platforms) in order to
 	 * preserve lower physical regions for device drivers, which may have DMA
 	 * constraints.
 	 */
-	if (_phys_range.start == 0 && _phys_range.end == ~0UL) {
+	if (!alloc_succeeded && _phys_range.start == 0 && _phys_range.end == ~0UL) {
 		addr_t const high_start = (sizeof(void *) == 4 ? 3UL : 4UL) << 30;
-		for (size_t align_log2 = log2(ds_size); align_log2 >= 12; align_log2--) {
+		size_t const min_align_log2 = ds_size >= (1UL << SUPERPAGE_SIZE_LOG2)
+		                            ? SUPERPAGE_SIZE_LOG2 : 12;
+		for (size_t align_log2 = log2(ds_size); align_log2 >= min_align_log2; align_log2--) {
 			if (_phys_alloc.alloc_aligned(ds_size, &ds_addr, align_log2,
 			                              high_start, _phys_range.end).ok()) {
 				alloc_succeeded = true;
@@ -57,8 +93,16 @@ Ram_dataspace_factory::alloc(size_t ds_size, Cache_attribute cached)
 		}
 	}
 
-	/* apply constraints or re-try because higher memory allocation failed */
-	if (!alloc_succeeded) {
+	/*
+	 * Apply constraints or re-try because higher memory allocation failed.
+	 * Should the physical memory be exhausted, return the pre-zeroed memory
+	 * to the allocator and try again.
+	 */
+	for (unsigned attempt = 0; !alloc_succeeded && attempt < 2; attempt++) {
+
+		if (attempt && !zeroed_ram_pool().release())
+			break;
+
 		for (size_t align_log2 = log2(ds_size); align_log2 >= 12; align_log2--) {
 			if (_phys_alloc.alloc_aligned(ds_size, &ds_addr, align_log2,
 			                              _phys_range.start, _phys_range.end).ok()) {
@@ -123,7 +167,11 @@ Ram_dataspace_factory::alloc(size_t ds_size, Cache_attribute cached)
 	 * function must also make sure to flush all cache lines related to the
 	 * address range used by the dataspace.
 	 */
-	_clear_ds(ds);
+	if (!zeroed) {
+		Cpu_timestamp const start = cpu_timestamp();
+		_clear_ds(ds);
+		zeroed_ram_pool().account_sync_clear(ds_size, cpu_timestamp() - start);
+	}
 
 	Dataspace_capability result = _ep.manage(ds);
 
@@ -29,6 +29,52 @@ static const bool verbose             = false;
 static const bool verbose_page_faults = false;
 
 
+/**
+ * Core-wide statistics about the sizes of page-fault mappings
+ *
+ * Mappings larger than a page reduce the TLB footprint of a component.
+ * Whenever the number of such mappings reaches a power of two, the
+ * statistics are logged.
+ */
+struct Mapping_stats
+{
+	enum { HUGE_LOG2 = 30 };
+
+	Genode::Lock  lock;
+	unsigned long total;   /* all mappings */
+	unsigned long large;   /* mappings larger than a page */
+	unsigned long huge;    /* mappings of at least 1 GiB */
+
+	void record(Genode::size_t map_size_log2)
+	{
+		using namespace Genode;
+
+		Lock::Guard guard(lock);
+
+		total++;
+		if (map_size_log2 <= get_page_size_log2())
+			return;
+
+		large++;
+		if (map_size_log2 >= HUGE_LOG2)
+			huge++;
+
+		if (large & (large - 1))
+			return;
+
+		log("mappings: ", total, " total, ", large, " larger than a page, ",
+		    huge, " of at least 1 GiB");
+	}
+};
+
+
+static Mapping_stats &mapping_stats()
+{
+	static Mapping_stats inst;
+	return inst;
+}
+
+
 struct Genode::Region_map_component::Fault_area
 {
 	addr_t _fault_addr;
@@ -227,6 +273,8 @@ int Rm_client::pager(Ipc_pager &pager)
 		if (!src_fault_area.valid() || !dst_fault_area.valid())
 			error("invalid mapping");
 
+		mapping_stats().record(map_size_log2);
+
 		/*
 		 * Check if dataspace is compatible with page-fault type
 		 */
@@ -377,24 +425,23 @@ Region_map_component::attach(Dataspace_capability ds_cap, size_t size,
 				Range_allocator::Alloc_return alloc_return =
 					_map.alloc_aligned(size, &r, align_log2);
 
-				if (!alloc_return.ok())
-					_map.free(r);
-
 				typedef Range_allocator::Alloc_return Alloc_return;
 
+				/*
+				 * If no free range with the alignment exists, retry with
+				 * a weaker alignment constraint.
+				 */
 				switch (alloc_return.value) {
 				case Alloc_return::OK:              break; /* switch */
 				case Alloc_return::OUT_OF_METADATA: throw Out_of_ram();
-				case Alloc_return::RANGE_CONFLICT:  throw Region_conflict();
+				case Alloc_return::RANGE_CONFLICT:  continue;
 				}
 
 				break; /* for loop */
 			}
 
-			if (align_log2 < get_page_size_log2()) {
-				_map.free(r);
+			if (align_log2 < get_page_size_log2())
 				throw Region_conflict();
-			}
 		}
 
 		/* store attachment info in meta data */
@@ -0,0 +1,195 @@
+/*
+ * \brief  Contention statistics of locks
+ * \author Norman Feske
+ * \date   2017-07-11
+ *
+ * The statistics are recorded only if the base library is built with
+ * 'GENODE_LOCK_STATS' defined, which is the case when 'LOCK_STATS = yes'
+ * is set in the build configuration. The counters are kept in a global
+ * table indexed by the lock address so that the layout of 'Lock' objects
+ * does not depend on the build option. Whenever the number of contended
+ * acquisitions of a lock reaches a power of two, the statistics of the lock
+ * are written to the trace buffer of the thread that releases it.
+ *
+ * The table is a 4-way set-associative cache of 'NUM_ENTRIES' entries,
+ * not a set of per-lock counters. If more locks map to a set than it has
+ * ways, the least-used entry is taken over and the counters of its lock
+ * start from zero once it gets recorded again. Hence, the statistics are
+ * accurate for the busiest locks only.
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__BASE__INTERNAL__LOCK_STATS_H_
+#define _INCLUDE__BASE__INTERNAL__LOCK_STATS_H_
+
+/* Genode includes */
+#include <base/thread.h>
+#include <cpu/atomic.h>
+#include <cpu/memory_barrier.h>
+#include <util/string.h>
+
+namespace Genode { struct Lock_stats; }
+
+
+struct Genode::Lock_stats
+{
+	typedef unsigned long long Timestamp;
+
+	/**
+	 * Return CPU timestamp, or zero if not supported by the architecture
+	 */
+	static Timestamp timestamp()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		unsigned lo, hi;
+		asm volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+		return ((Timestamp)hi << 32) | lo;
+#else
+		return 0;
+#endif
+	}
+
+	enum { NUM_ENTRIES = 256 };
+
+	struct Entry
+	{
+		void const   *lock;
+		unsigned long acquisitions;    /* all acquisitions */
+		unsigned long contended;       /* acquisitions not free at first try */
+		unsigned long spun;            /* contended but acquired by spinning */
+		Timestamp     wait;            /* timestamp ticks spent in contention */
+		bool          report_pending;
+	};
+
+	/*
+	 * The object is meant to be zero-initialized as static object. Hence,
+	 * it is usable by locks acquired before the static constructors ran.
+	 * For this reason, the meta lock is free when zero.
+	 */
+	Entry        entries[NUM_ENTRIES];
+	volatile int meta_locked;
+
+	/*
+	 * The critical sections of the meta lock are short. Hence, it is
+	 * acquired by spinning, which does not depend on the kernel-specific
+	 * 'thread_yield', which base-nova does not provide.
+	 */
+	void _meta_lock()
+	{
+		while (!cmpxchg(&meta_locked, 0, 1))
+			memory_barrier();
+	}
+
+	void _meta_unlock()
+	{
+		memory_barrier();
+		meta_locked = 0;
+	}
+
+	enum { WAYS = 4 };
+
+	static unsigned _bucket(void const *lock)
+	{
+		return (((unsigned long)lock >> 4) * WAYS) % NUM_ENTRIES;
+	}
+
+	Entry *_lookup(void const *lock)
+	{
+		unsigned const first = _bucket(lock);
+		for (unsigned i = first; i < first + WAYS; i++)
+			if (entries[i].lock == lock)
+				return &entries[i];
+		return nullptr;
+	}
+
+	/**
+	 * Return entry of 'lock', taking over the least-used entry of its
+	 * bucket if needed
+	 *
+	 * Must be called with the meta lock held.
+	 */
+	Entry &_entry(void const *lock)
+	{
+		if (Entry *e = _lookup(lock))
+			return *e;
+
+		unsigned const first = _bucket(lock);
+
+		Entry *victim = &entries[first];
+		for (unsigned i = first; i < first + WAYS; i++)
+			if (entries[i].acquisitions < victim->acquisitions)
+				victim = &entries[i];
+
+		*victim = Entry { lock, 0, 0, 0, 0, false };
+		return *victim;
+	}
+
+	static bool _power_of_two(unsigned long v) { return v && !(v & (v - 1)); }
+
+	/**
+	 * Account acquisition of 'lock'
+	 *
+	 * \param contended  lock was not free at the first attempt
+	 * \param spun       lock was acquired by spinning
+	 * \param wait       ticks spent until the lock was acquired
+	 */
+	void record(void const *lock, bool contended, bool spun, Timestamp wait)
+	{
+		_meta_lock();
+
+		Entry &e = _entry(lock);
+		e.acquisitions++;
+		if (contended) {
+			e.contended++;
+			e.wait += wait;
+			if (spun)
+				e.spun++;
+			if (_power_of_two(e.contended))
+				e.report_pending = true;
+		}
+
+		_meta_unlock();
+	}
+
+	/**
+	 * Write pending report about 'lock' to the trace buffer
+	 *
+	 * Must be called without holding 'lock' because tracing may acquire
+	 * other locks.
+	 */
+	void report(void const *lock)
+	{
+		/* skip the meta lock in the common case of no pending report */
+		Entry *e = _lookup(lock);
+		if (!e || !e->report_pending)
+			return;
+
+		_meta_lock();
+
+		e = _lookup(lock);
+		if (!e || !e->report_pending) {
+			_meta_unlock();
+			return;
+		}
+
+		e->report_pending = false;
+		Entry const snapshot = *e;
+
+		_meta_unlock();
+
+		typedef String<160> Message;
+		Thread::trace(Message("lock ", snapshot.lock, ": "
+		                      "acquisitions=", snapshot.acquisitions, " "
+		                      "contended=",    snapshot.contended,    " "
+		                      "spun=",         snapshot.spun,         " "
+		                      "wait=",         snapshot.wait).string());
+	}
+};
+
+#endif /* _INCLUDE__BASE__INTERNAL__LOCK_STATS_H_ */
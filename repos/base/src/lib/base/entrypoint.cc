@@ -48,11 +48,18 @@ static char const *initial_ep_name() { return "ep"; }
 
 void Entrypoint::Signal_proxy_component::signal()
 {
-	/* XXX introduce while-pending loop */
-	try {
-		Signal sig = ep._sig_rec->pending_signal();
-		ep._dispatch_signal(sig);
-	} catch (Signal_receiver::Signal_not_pending) { }
+	/*
+	 * Dispatch all signals that are pending at once instead of bouncing each
+	 * signal separately from the proxy thread into the entrypoint. The
+	 * number of signals per call is bounded to keep RPC requests from
+	 * starving if handlers trigger each other continuously.
+	 */
+	for (unsigned i = 0; i < MAX_SIGNALS_PER_CALL && !ep._suspended; i++) {
+		try {
+			Signal sig = ep._sig_rec->pending_signal();
+			ep._dispatch_signal(sig);
+		} catch (Signal_receiver::Signal_not_pending) { break; }
+	}
 
 	ep._execute_post_signal_hook();
 	ep._process_deferred_signals();
@@ -113,6 +120,16 @@ void Entrypoint::_process_incoming_signals()
 				success = cmpxchg(&_signal_recipient, NONE, SIGNAL_PROXY);
 			}
 
+			/*
+			 * The signal may have been dispatched already by a preceding
+			 * proxy call that processed all pending signals at once. In
+			 * this case, there is no need to call the entrypoint.
+			 */
+			if (success && !_sig_rec->pending()) {
+				cmpxchg(&_signal_recipient, SIGNAL_PROXY, NONE);
+				continue;
+			}
+
 			/* common case, entrypoint is not in 'wait_and_dispatch_one_io_signal' */
 			if (success) {
 				/*
@@ -323,3 +340,39 @@ Entrypoint::Entrypoint(Env &env, size_t stack_size, char const *name)
 	_signal_proxy_thread.construct(env, *this);
 }
 
+
+
+Entrypoint_pool::Entrypoint_pool(Env &env, Allocator &alloc,
+                                 unsigned num_threads, size_t stack_size,
+                                 char const *name, Affinity::Location cpus)
+:
+	_alloc(alloc),
+	_num_threads(max(1U, min(num_threads, (unsigned)MAX_THREADS)))
+{
+	if (!cpus.valid()) {
+		Affinity::Space const space = env.cpu().affinity_space();
+		cpus = Affinity::Location(0, 0, space.width(), space.height());
+	}
+
+	unsigned const num_cpus = max(1U, cpus.width()*cpus.height());
+
+	for (unsigned i = 0; i < _num_threads; i++) {
+
+		unsigned const cpu = i % num_cpus;
+		Affinity::Location const location(cpus.xpos() + cpu % max(1U, cpus.width()),
+		                                  cpus.ypos() + cpu / max(1U, cpus.width()),
+		                                  1, 1);
+
+		String<64> const ep_name(name, "_", i);
+
+		_eps[i] = new (alloc) Rpc_entrypoint(&env.pd(), stack_size,
+		                                     ep_name.string(), true, location);
+	}
+}
+
+
+Entrypoint_pool::~Entrypoint_pool()
+{
+	for (unsigned i = 0; i < _num_threads; i++)
+		destroy(_alloc, _eps[i]);
+}
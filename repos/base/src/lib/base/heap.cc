@@ -11,6 +11,7 @@
  * under the terms of the GNU Affero General Public License version 3.
  */
 
+#include <util/avl_tree.h>
 #include <util/construct_at.h>
 #include <base/env.h>
 #include <base/log.h>
@@ -31,8 +32,27 @@ namespace {
 		 * to smaller allocations, this memory is released to
 		 * the RAM session when 'free()' is called.
 		 */
-		BIG_ALLOCATION_THRESHOLD = 64*1024 /* in bytes */
+		BIG_ALLOCATION_THRESHOLD = 64*1024, /* in bytes */
+
+		/*
+		 * Dataspace sizes of the chunks of the size-class front end. The
+		 * size doubles with each chunk of a size class.
+		 */
+		MIN_SLAB_CHUNK_SIZE =  16*1024,
+		MAX_SLAB_CHUNK_SIZE = 256*1024,
+
+		NUM_SIZE_CLASSES = 12,
 	};
+
+	/*
+	 * Slot sizes of the size-class front end, which are multiples of the
+	 * 16-byte alignment of heap blocks
+	 */
+	size_t const slot_sizes[] = { 16, 32, 48, 64, 96, 128, 192, 256,
+	                              384, 512, 768, 1024 };
+
+	static_assert(sizeof(slot_sizes)/sizeof(slot_sizes[0]) == NUM_SIZE_CLASSES,
+	              "mismatching number of heap size classes");
 }
 
 
@@ -70,6 +90,315 @@ Heap::Dataspace_pool::~Dataspace_pool()
 }
 
 
+/**************************
+ ** Size-class front end **
+ **************************/
+
+/**
+ * State of the size-class front end
+ *
+ * The state is kept outside of the 'Heap' object, which merely refers to
+ * it. It resides at the beginning of a dedicated dataspace so that it is
+ * not accounted as consumed by the heap.
+ */
+struct Heap::Size_classes
+{
+	/**
+	 * Dataspace that holds the slots of one size class
+	 *
+	 * The meta data is located at the beginning of the dataspace.
+	 */
+	struct Chunk : Avl_node<Chunk>
+	{
+		struct Slot { Slot *next; };
+
+		Ram_dataspace_capability const cap;
+		size_t                   const size;        /* of dataspace  */
+		unsigned                 const size_class;
+		addr_t                   const slots;       /* first slot    */
+		size_t                   const slot_size;
+		unsigned                 const capacity;    /* number of slots */
+
+		unsigned    used       = 0;
+		unsigned    carved     = 0;        /* slots ever handed out    */
+		Slot       *free_slots = nullptr;  /* slots released by 'free' */
+
+		/*
+		 * A chunk is a member of the list of its size class as long
+		 * as it has free slots.
+		 */
+		Chunk *next = nullptr;
+		Chunk *prev = nullptr;
+
+		Chunk(Ram_dataspace_capability cap, size_t size,
+		      unsigned size_class, size_t slot_size)
+		:
+			cap(cap), size(size), size_class(size_class),
+			slots(align_addr((addr_t)this + sizeof(Chunk), log2(16))),
+			slot_size(slot_size),
+			capacity((size - (slots - (addr_t)this)) / slot_size)
+		{ }
+
+		bool higher(Chunk *c) { return (addr_t)c > (addr_t)this; }
+
+		/**
+		 * Return chunk that contains 'addr'
+		 */
+		Chunk *find_by_address(addr_t addr)
+		{
+			if (addr >= (addr_t)this && addr < (addr_t)this + size)
+				return this;
+
+			Chunk *c = child(addr > (addr_t)this);
+			return c ? c->find_by_address(addr) : nullptr;
+		}
+
+		void *alloc()
+		{
+			void *addr = nullptr;
+
+			if (free_slots) {
+				addr       = free_slots;
+				free_slots = free_slots->next;
+
+			} else if (carved < capacity) {
+
+				/* hand out slots in order to leave untouched pages untouched */
+				addr = (void *)(slots + carved*slot_size);
+				carved++;
+
+			} else {
+				return nullptr;
+			}
+
+			used++;
+			return addr;
+		}
+
+		bool free_slot(void *addr)
+		{
+			addr_t const offset = (addr_t)addr - slots;
+
+			if ((addr_t)addr < slots || offset % slot_size || offset / slot_size >= carved)
+				return false;
+
+			free_slots = construct_at<Slot>(addr, Slot { free_slots });
+			used--;
+			return true;
+		}
+	};
+
+	Dataspace_pool &ds_pool;
+
+	Ram_dataspace_capability const cap;  /* dataspace holding this object */
+
+	bool         enabled = false;
+	Avl_tree<Chunk> chunks { };
+	Chunk       *partial_chunks[NUM_SIZE_CLASSES] { };
+	unsigned     num_chunks[NUM_SIZE_CLASSES] { };
+
+	Size_classes(Dataspace_pool &ds_pool, Ram_dataspace_capability cap)
+	: ds_pool(ds_pool), cap(cap) { }
+
+	/**
+	 * Return size class for blocks of 'size' bytes, or NUM_SIZE_CLASSES
+	 * if the block is too large for the size-class front end
+	 */
+	static unsigned size_class(size_t size)
+	{
+		unsigned i = 0;
+		for (; i < NUM_SIZE_CLASSES && slot_sizes[i] < size; i++);
+		return i;
+	}
+
+	static size_t slot_size(unsigned size_class) { return slot_sizes[size_class]; }
+
+	void list_chunk(Chunk &chunk)
+	{
+		Chunk *&head = partial_chunks[chunk.size_class];
+
+		chunk.prev = nullptr;
+		chunk.next = head;
+		if (head)
+			head->prev = &chunk;
+		head = &chunk;
+	}
+
+	void unlist_chunk(Chunk &chunk)
+	{
+		if (chunk.prev)
+			chunk.prev->next = chunk.next;
+		else
+			partial_chunks[chunk.size_class] = chunk.next;
+
+		if (chunk.next)
+			chunk.next->prev = chunk.prev;
+
+		chunk.next = chunk.prev = nullptr;
+	}
+
+	/**
+	 * Allocate and attach dataspace of 'size' bytes
+	 *
+	 * \return  local address, or nullptr if the RAM allocator is exhausted
+	 */
+	static void *attach_dataspace(Dataspace_pool &ds_pool, size_t size,
+	                              Ram_dataspace_capability &cap)
+	{
+		try {
+			cap = ds_pool.ram_alloc->alloc(size);
+			return ds_pool.region_map->attach(cap);
+		}
+		catch (Out_of_ram) {
+			return nullptr;
+		}
+		catch (Region_map::Invalid_dataspace) {
+			warning("heap: attempt to attach invalid dataspace");
+		}
+		catch (Region_map::Region_conflict) {
+			warning("heap: region conflict while allocating dataspace");
+		}
+		ds_pool.ram_alloc->free(cap);
+		return nullptr;
+	}
+
+	/**
+	 * Allocate dataspace for a new chunk of the given size class
+	 *
+	 * \return  new chunk, or nullptr if the RAM allocator is exhausted
+	 */
+	Chunk *allocate_chunk(unsigned size_class)
+	{
+		size_t const size = min((size_t)MAX_SLAB_CHUNK_SIZE,
+		                        (size_t)MIN_SLAB_CHUNK_SIZE << min(num_chunks[size_class], 4U));
+
+		Ram_dataspace_capability cap;
+		void * const local_addr = attach_dataspace(ds_pool, size, cap);
+		if (!local_addr)
+			return nullptr;
+
+		Chunk *chunk = construct_at<Chunk>(local_addr, cap, size, size_class,
+		                                   slot_size(size_class));
+		chunks.insert(chunk);
+		list_chunk(*chunk);
+		num_chunks[size_class]++;
+
+		return chunk;
+	}
+
+	void release_chunk(Chunk &chunk)
+	{
+		if (chunk.used < chunk.capacity)
+			unlist_chunk(chunk);
+
+		chunks.remove(&chunk);
+		num_chunks[chunk.size_class]--;
+
+		/* keep capability until the meta data is destructed, see 'remove_and_free' */
+		Ram_dataspace_capability const cap = chunk.cap;
+		chunk.~Chunk();
+
+		ds_pool.region_map->detach(&chunk);
+		ds_pool.ram_alloc->free(cap);
+	}
+
+	/**
+	 * Allocate slot of size class
+	 */
+	bool alloc(unsigned size_class, void **out_addr)
+	{
+		Chunk *chunk = partial_chunks[size_class];
+		if (!chunk)
+			chunk = allocate_chunk(size_class);
+		if (!chunk)
+			return false;
+
+		*out_addr = chunk->alloc();
+
+		if (chunk->used == chunk->capacity)
+			unlist_chunk(*chunk);
+
+		return true;
+	}
+
+	/**
+	 * Release slot at 'addr' if it belongs to a chunk
+	 *
+	 * \param out_slot_size  size of the released slot
+	 * \return               false if 'addr' is not located within a chunk
+	 */
+	bool free(void *addr, size_t &out_slot_size)
+	{
+		out_slot_size = 0;
+
+		Chunk *chunk = chunks.first()
+		             ? chunks.first()->find_by_address((addr_t)addr)
+		             : nullptr;
+		if (!chunk)
+			return false;
+
+		if (!chunk->free_slot(addr)) {
+			warning("heap could not free memory block");
+			return true;
+		}
+
+		out_slot_size = chunk->slot_size;
+
+		/* chunk was full before */
+		if (chunk->used == chunk->capacity - 1)
+			list_chunk(*chunk);
+
+		/* return empty chunk to the RAM allocator but keep one per size class */
+		if (chunk->used == 0 && num_chunks[chunk->size_class] > 1)
+			release_chunk(*chunk);
+
+		return true;
+	}
+
+	/**
+	 * Release all chunks and the dataspace of 'size_classes'
+	 */
+	static void destroy(Size_classes &size_classes)
+	{
+		while (Chunk *chunk = size_classes.chunks.first())
+			size_classes.release_chunk(*chunk);
+
+		Dataspace_pool           &ds_pool = size_classes.ds_pool;
+		Ram_dataspace_capability  cap     = size_classes.cap;
+
+		size_classes.~Size_classes();
+
+		ds_pool.region_map->detach(&size_classes);
+		ds_pool.ram_alloc->free(cap);
+	}
+};
+
+
+void Heap::size_classes(bool enabled)
+{
+	Lock::Guard lock_guard(_lock);
+
+	if (!_size_classes) {
+
+		if (!enabled)
+			return;
+
+		Ram_dataspace_capability cap;
+		void * const local_addr =
+			Size_classes::attach_dataspace(_ds_pool, sizeof(Size_classes), cap);
+
+		if (!local_addr) {
+			warning("heap: could not allocate state of size classes");
+			return;
+		}
+
+		_size_classes = construct_at<Size_classes>(local_addr, _ds_pool, cap);
+	}
+
+	_size_classes->enabled = enabled;
+}
+
+
 int Heap::quota_limit(size_t new_quota_limit)
 {
 	if (new_quota_limit < _quota_used) return -1;
@@ -218,6 +547,24 @@ bool Heap::alloc(size_t size, void **out_addr)
 	/* serialize access of heap functions */
 	Lock::Guard lock_guard(_lock);
 
+	unsigned const size_class = _size_classes && _size_classes->enabled
+	                          ? Size_classes::size_class(size)
+	                          : (unsigned)NUM_SIZE_CLASSES;
+	if (size && size_class < NUM_SIZE_CLASSES) {
+
+		size_t const slot_size = Size_classes::slot_size(size_class);
+
+		if (slot_size + _quota_used > _quota_limit)
+			return false;
+
+		if (_size_classes->alloc(size_class, out_addr)) {
+			_quota_used += slot_size;
+			return true;
+		}
+
+		/* fall back to the local allocator if no chunk could be allocated */
+	}
+
 	/* check requested allocation against quota limit */
 	if (size + _quota_used > _quota_limit)
 		return false;
@@ -231,6 +578,13 @@ void Heap::free(void *addr, size_t)
 	/* serialize access of heap functions */
 	Lock::Guard lock_guard(_lock);
 
+	/* blocks of the size-class front end */
+	size_t slot_size = 0;
+	if (_size_classes && _size_classes->free(addr, slot_size)) {
+		_quota_used -= slot_size;
+		return;
+	}
+
 	/* try to find the size in our local allocator */
 	size_t const size = _alloc->size_at(addr);
 
@@ -283,6 +637,10 @@ Heap::Heap(Ram_allocator *ram_alloc,
 
 Heap::~Heap()
 {
+	/* release the chunks and the state of the size-class front end */
+	if (_size_classes)
+		Size_classes::destroy(*_size_classes);
+
 	/*
 	 * Revert allocations of heap-internal 'Dataspace' objects. Otherwise, the
 	 * subsequent destruction of the 'Allocator_avl' would detect those blocks
@@ -14,13 +14,50 @@
 /* Genode includes */
 #include <base/cancelable_lock.h>
 #include <cpu/memory_barrier.h>
+#include <util/misc_math.h>
 
 /* base-internal includes */
 #include <base/internal/spin_lock.h>
 
+#ifdef GENODE_LOCK_STATS
+#include <base/internal/lock_stats.h>
+static Genode::Lock_stats lock_stats;
+#endif
+
 using namespace Genode;
 
 
+/*
+ * Bounds of the adaptive spinning
+ *
+ * A contended 'lock' spins for up to twice the estimated time before it
+ * blocks. Spinning pays off for short critical sections whose holder runs
+ * on another CPU. If the estimate decays to zero, e.g., on a single CPU,
+ * the cost is limited to 'SPIN_MIN' iterations.
+ */
+enum { SPIN_MIN = 10, SPIN_MAX = 1000 };
+
+
+/*
+ * Spin estimates of the locks, indexed by the lock address
+ *
+ * The estimates are kept outside of the lock objects to leave the layout
+ * of 'Lock' unchanged. Locks that map to the same entry share their
+ * estimate, which merely blurs the heuristic. Being zero-initialized, the
+ * table is usable by locks acquired before the static constructors ran.
+ * Concurrent updates are not synchronized because a lost update is
+ * harmless.
+ */
+enum { NUM_SPIN_ESTIMATES = 256 };
+
+static volatile int spin_estimates[NUM_SPIN_ESTIMATES];
+
+static volatile int &spin_estimate(void const *lock)
+{
+	return spin_estimates[((unsigned long)lock >> 4) % NUM_SPIN_ESTIMATES];
+}
+
+
 static inline Genode::Thread *invalid_thread_base()
 {
 	return (Genode::Thread*)~0UL;
@@ -60,10 +97,78 @@ void Cancelable_lock::Applicant::wake_up()
  ** Cancelable lock **
  *********************/
 
+bool Cancelable_lock::_try_lock(Applicant &myself)
+{
+	spinlock_lock(&_spinlock_state);
+
+	bool const got_lock = cmpxchg(&_state, UNLOCKED, LOCKED);
+	if (got_lock) {
+		_owner          =  myself;
+		_last_applicant = &_owner;
+	}
+
+	spinlock_unlock(&_spinlock_state);
+	return got_lock;
+}
+
+
+bool Cancelable_lock::_spin(Applicant &myself)
+{
+	volatile int &estimate_entry = spin_estimate(this);
+
+	int const estimate = max(0, min((int)SPIN_MAX, (int)estimate_entry));
+	int const limit    = min((int)SPIN_MAX, 2*estimate + SPIN_MIN);
+
+	int spins = 0;
+	for (; spins < limit; spins++) {
+
+		/*
+		 * Once applicants are queued, the lock is handed over to them and
+		 * never becomes free for us.
+		 */
+		if (_owner.applicant_to_wake_up())
+			break;
+
+		memory_barrier();
+
+		if (_state != UNLOCKED)
+			continue;
+
+		if (_try_lock(myself)) {
+			estimate_entry = estimate + (spins - estimate) / 8;
+			return true;
+		}
+	}
+
+	/* spinning was in vain, let the estimate decay */
+	estimate_entry = estimate - estimate / 8 - (estimate > 0);
+	return false;
+}
+
+
 void Cancelable_lock::lock()
 {
 	Applicant myself(Thread::myself());
 
+	if (_try_lock(myself)) {
+#ifdef GENODE_LOCK_STATS
+		lock_stats.record(this, false, false, 0);
+#endif
+		return;
+	}
+
+#ifdef GENODE_LOCK_STATS
+	Lock_stats::Timestamp const contention_start = Lock_stats::timestamp();
+#endif
+
+	if (_spin(myself)) {
+#ifdef GENODE_LOCK_STATS
+		lock_stats.record(this, true, true,
+		                  Lock_stats::timestamp() - contention_start);
+#endif
+		return;
+	}
+
 	spinlock_lock(&_spinlock_state);
 
 	if (cmpxchg(&_state, UNLOCKED, LOCKED)) {
@@ -72,6 +177,10 @@ void Cancelable_lock::lock()
 		_owner          =  myself;
 		_last_applicant = &_owner;
 		spinlock_unlock(&_spinlock_state);
+#ifdef GENODE_LOCK_STATS
+		lock_stats.record(this, true, false,
+		                  Lock_stats::timestamp() - contention_start);
+#endif
 		return;
 	}
 
@@ -149,6 +258,10 @@ void Cancelable_lock::lock()
 		throw Blocking_canceled();
 	}
 	spinlock_unlock(&_spinlock_state);
+
+#ifdef GENODE_LOCK_STATS
+	lock_stats.record(this, true, false, Lock_stats::timestamp() - contention_start);
+#endif
 }
 
 
@@ -182,6 +295,10 @@ void Cancelable_lock::unlock()
 
 		spinlock_unlock(&_spinlock_state);
 	}
+
+#ifdef GENODE_LOCK_STATS
+	lock_stats.report(this);
+#endif
 }
 
 
@@ -0,0 +1,141 @@
+/*
+ * \brief  Heap benchmark
+ * \author Norman Feske
+ * \date   2017-07-13
+ *
+ * The benchmark allocates and frees blocks of random sizes typical for
+ * component-internal objects, once with the plain heap and once with the
+ * size-class front end enabled. It checks that the quota accounting of the
+ * heap is balanced and reports the RAM used by the heap.
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#include <base/component.h>
+#include <base/heap.h>
+#include <base/log.h>
+#include <timer_session/connection.h>
+
+using Genode::size_t;
+using Genode::log;
+using Genode::error;
+
+
+/**
+ * Linear congruential generator for reproducible block sizes
+ */
+struct Random
+{
+	unsigned long _state = 1;
+
+	unsigned operator () (unsigned max)
+	{
+		_state = _state*1103515245 + 12345;
+		return (_state >> 16) % max;
+	}
+};
+
+
+struct Benchmark
+{
+	enum { ROUNDS = 50, ALLOCS_PER_ROUND = 2000, FREES_PER_ROUND = 1500,
+	       MAX_BLOCKS = ROUNDS*(ALLOCS_PER_ROUND - FREES_PER_ROUND),
+	       MAX_SIZE   = 1100 };
+
+	struct Block { void *addr; size_t size; };
+
+	Genode::Env       &env;
+	Timer::Connection &timer;
+	Genode::Allocator &md_alloc;
+
+	Block    *blocks;
+	unsigned  num_blocks = 0;
+
+	struct Failed { };
+
+	Benchmark(Genode::Env &env, Timer::Connection &timer, Genode::Allocator &md_alloc)
+	:
+		env(env), timer(timer), md_alloc(md_alloc),
+		blocks((Block *)md_alloc.alloc(MAX_BLOCKS*sizeof(Block)))
+	{ }
+
+	~Benchmark() { md_alloc.free(blocks, MAX_BLOCKS*sizeof(Block)); }
+
+	void run(char const *name, bool size_classes)
+	{
+		size_t const ram_before = env.pd().used_ram().value;
+
+		unsigned long const start_ms = timer.elapsed_ms();
+		unsigned long alloc_ms = 0;
+		{
+			Genode::Heap heap(env.ram(), env.rm());
+			heap.size_classes(size_classes);
+
+			Random random;
+
+			for (unsigned round = 0; round < ROUNDS; round++) {
+
+				for (unsigned i = 0; i < ALLOCS_PER_ROUND; i++) {
+					Block &b = blocks[num_blocks++];
+					b.size = 1 + random(MAX_SIZE);
+					if (!heap.alloc(b.size, &b.addr)) {
+						error(name, ": allocation failed");
+						throw Failed();
+					}
+					Genode::memset(b.addr, 0, b.size);
+				}
+
+				for (unsigned i = 0; i < FREES_PER_ROUND; i++) {
+					Block &b = blocks[random(num_blocks)];
+					heap.free(b.addr, b.size);
+					b = blocks[--num_blocks];
+				}
+			}
+
+			alloc_ms = timer.elapsed_ms() - start_ms;
+
+			log(name, ": ", num_blocks, " blocks in use, "
+			    "consumed: ", heap.consumed(), ", "
+			    "used RAM: ", env.pd().used_ram().value - ram_before);
+
+			while (num_blocks)
+				heap.free(blocks[--num_blocks].addr, 0);
+
+			log(name, ": all blocks freed, "
+			    "consumed: ", heap.consumed(), ", "
+			    "used RAM: ", env.pd().used_ram().value - ram_before);
+
+			if (heap.consumed()) {
+				error(name, ": unbalanced quota accounting");
+				throw Failed();
+			}
+		}
+
+		log(name, ": ", alloc_ms, " ms for ", ROUNDS*ALLOCS_PER_ROUND, " "
+		    "allocations and ", ROUNDS*FREES_PER_ROUND, " frees, "
+		    "heap destructed, used RAM: ", env.pd().used_ram().value - ram_before);
+	}
+};
+
+
+void Component::construct(Genode::Env &env)
+{
+	log("--- heap benchmark ---");
+
+	static Timer::Connection timer(env);
+	static Genode::Heap      heap(env.ram(), env.rm());
+
+	try {
+		Benchmark benchmark(env, timer, heap);
+		benchmark.run("plain heap  ", false);
+		benchmark.run("size classes", true);
+	}
+	catch (Benchmark::Failed) { return; }
+
+	log("--- heap benchmark finished ---");
+}
@@ -0,0 +1,121 @@
+/*
+ * \brief  Ping-pong RPC benchmark
+ * \author Christian Helmuth
+ * \date   2017-06-19
+ *
+ * The test measures the round-trip time of RPCs between the entrypoint of
+ * the component and a second RPC entrypoint of the same component. Besides
+ * calls that transfer plain data only, calls that delegate a capability are
+ * measured.
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/log.h>
+#include <base/rpc_server.h>
+#include <base/rpc_client.h>
+#include <trace/timestamp.h>
+
+namespace Test {
+
+	using namespace Genode;
+
+	struct Session;
+	struct Client;
+	struct Component;
+	struct Main;
+}
+
+
+struct Test::Session : Genode::Session
+{
+	static const char *service_name() { return "RPC_BENCH"; }
+
+	enum { CAP_QUOTA = 2 };
+
+	GENODE_RPC(Rpc_ping, unsigned long, ping, unsigned long);
+	GENODE_RPC(Rpc_ping_cap, Native_capability, ping_cap, Native_capability);
+	GENODE_RPC_INTERFACE(Rpc_ping, Rpc_ping_cap);
+};
+
+
+struct Test::Client : Genode::Rpc_client<Session>
+{
+	Client(Capability<Session> cap) : Rpc_client<Session>(cap) { }
+
+	unsigned long ping(unsigned long value) { return call<Rpc_ping>(value); }
+
+	Native_capability ping_cap(Native_capability cap) {
+		return call<Rpc_ping_cap>(cap); }
+};
+
+
+struct Test::Component : Genode::Rpc_object<Session, Component>
+{
+	unsigned long ping(unsigned long value) { return value + 1; }
+
+	Native_capability ping_cap(Native_capability cap) { return cap; }
+};
+
+
+struct Test::Main
+{
+	enum { STACK_SIZE = 2*1024*sizeof(long), WARMUP = 1000, ROUNDS = 100000 };
+
+	Env &env;
+
+	Rpc_entrypoint ep { &env.pd(), STACK_SIZE, "rpc_bench_ep" };
+
+	Component component;
+
+	Capability<Session> cap { ep.manage(&component) };
+
+	Client client { cap };
+
+	template <typename FN>
+	void measure(char const *name, FN const &fn)
+	{
+		for (unsigned i = 0; i < WARMUP; i++)
+			fn(i);
+
+		Trace::Timestamp const start = Trace::timestamp();
+
+		for (unsigned i = 0; i < ROUNDS; i++)
+			fn(i);
+
+		Trace::Timestamp const cycles = Trace::timestamp() - start;
+
+		log(name, ": ", (unsigned)ROUNDS, " calls, ", cycles/ROUNDS, " cycles per call");
+	}
+
+	struct Unexpected_result : Exception { };
+
+	Main(Env &env) : env(env)
+	{
+		log("--- RPC benchmark started ---");
+
+		measure("ping", [&] (unsigned long i) {
+			if (client.ping(i) != i + 1)
+				throw Unexpected_result(); });
+
+		Native_capability const delegated = cap;
+
+		measure("ping with capability", [&] (unsigned long) {
+			if (!client.ping_cap(delegated).valid())
+				throw Unexpected_result(); });
+
+		ep.dissolve(&component);
+
+		log("--- RPC benchmark finished ---");
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
@@ -277,6 +277,15 @@ class Audio_out::Root : public Audio_out::Root_component
 			                                             "left");
 			Out::channel_number(channel_name, &channel_number);
 
+			/* the period of the driver is fixed */
+			unsigned const period =
+				Arg_string::find_arg(args, "period").ulong_value(PERIOD);
+			if (period != PERIOD) {
+				Genode::error("requested period ", period, ", driver period is ",
+				              (int)PERIOD);
+				throw Genode::Service_denied();
+			}
+
 			return new (md_alloc())
 				Session_component(_env, channel_number, _cap);
 		}
@@ -12,6 +12,7 @@
  * under the terms of the GNU Affero General Public License version 3.
  */
 
+#include "io.h"
 #include "sched.h"
 
 #include <base/log.h>
@@ -236,6 +237,9 @@ struct Allocator_policy
 
 typedef Allocator::Fap<128 * 1024 * 1024, Allocator_policy> Rump_alloc;
 
+/* minimum alignment of allocations placed into the block-session buffer */
+enum { IO_BUFFER_ALIGN = 4096 };
+
 static Genode::Lock & alloc_lock()
 {
 	static Genode::Lock inst;
@@ -255,6 +259,11 @@ int rumpuser_malloc(size_t len, int alignment, void **memp)
 	Genode::Lock::Guard guard(alloc_lock());
 
 	int align = alignment ? Genode::log2(alignment) : 0;
+
+	/* place pages into the bulk buffer of the block session */
+	if (alignment >= IO_BUFFER_ALIGN && rump_io_backend_alloc(len, align, memp))
+		return 0;
+
 	*memp     = allocator()->alloc(len, align);
 
 	if (verbose)
@@ -269,6 +278,9 @@ void rumpuser_free(void *mem, size_t len)
 {
 	Genode::Lock::Guard guard(alloc_lock());
 
+	if (rump_io_backend_free(mem, len))
+		return;
+
 	allocator()->free(mem, len);
 
 	if (verbose)
@@ -11,12 +11,15 @@
  * under the terms of the GNU Affero General Public License version 3.
  */
 
+#include "io.h"
 #include "sched.h"
 #include <base/allocator_avl.h>
 #include <base/printf.h>
+#include <base/semaphore.h>
 #include <block_session/connection.h>
 #include <rump/env.h>
 #include <rump_fs/fs.h>
+#include <util/hard_context.h>
 
 
 static const bool verbose = false;
@@ -25,23 +28,196 @@ enum  { GENODE_FD = 64 };
 
 /**
  * Block session connection
+ *
+ * Block requests are submitted asynchronously. The caller of 'rumpuser_bio'
+ * returns as soon as the request is handed over to the block session. A
+ * dedicated thread awaits the acknowledgements, which may arrive in any
+ * order, and completes the requests towards the rump kernel.
+ *
+ * Part of the bulk buffer of the block session is used as backing store for
+ * page-aligned allocations of the rump kernel. I/O on such memory is
+ * submitted in place without copying the data.
  */
 class Backend
 {
+	public:
+
+		enum {
+			MAX_IN_FLIGHT       = 64,
+			DEFAULT_BUFFER_SIZE = 1024*1024,
+		};
+
 	private:
 
+		/**
+		 * Block request in flight
+		 */
+		struct Request
+		{
+			bool                     valid   = false;
+			bool                     bounce  = false; /* data copied via packet */
+			int                      op      = 0;
+			void                    *data    = nullptr;
+			size_t                   length  = 0;
+			rump_biodone_fn          biodone = nullptr;
+			void                    *donearg = nullptr;
+			Block::Packet_descriptor packet;
+		};
+
+		Genode::size_t const _buffer_size {
+			Rump::env().config_rom().xml().attribute_value("io_buffer_size",
+				Genode::Number_of_bytes(DEFAULT_BUFFER_SIZE)) };
+
 		Genode::Allocator_avl              _alloc { &Rump::env().heap() };
-		Block::Connection                  _session { Rump::env().env(), &_alloc };
+		Block::Connection                  _session { Rump::env().env(), &_alloc, _buffer_size };
 		Genode::size_t                     _blk_size; /* block size of the device   */
 		Block::sector_t                    _blk_cnt;  /* number of blocks of device */
 		Block::Session::Operations         _blk_ops;
-		Genode::Lock                       _session_lock;
+
+		/* local address corresponding to packet offset 0 */
+		Genode::addr_t                     _packet_base = 0;
+
+		/* bytes of the bulk buffer used as memory of the rump kernel */
+		Genode::size_t                     _buffers_used = 0;
+
+		Genode::Lock                       _lock;
+		Genode::Semaphore                  _wakeup;
+		unsigned                           _waiters   = 0;
+		unsigned                           _in_flight = 0;
+		Request                            _requests[MAX_IN_FLIGHT];
+		Hard_context_thread               *_completion = nullptr;
+
+		/**
+		 * Wait for the completion of a request, called with '_lock' held
+		 */
+		void _wait_for_completion()
+		{
+			_waiters++;
+			_lock.unlock();
+			_wakeup.down();
+			_lock.lock();
+		}
+
+		void _wake_up_waiters()
+		{
+			for (; _waiters; _waiters--)
+				_wakeup.up();
+		}
+
+		Request *_free_request()
+		{
+			for (unsigned i = 0; i < MAX_IN_FLIGHT; i++)
+				if (!_requests[i].valid)
+					return &_requests[i];
+			return nullptr;
+		}
+
+		/**
+		 * Return request matching the acknowledged packet
+		 *
+		 * Requests submitted in place may refer to the same buffer. Hence,
+		 * the operation and the blocks are compared besides the offset.
+		 */
+		Request *_lookup(Block::Packet_descriptor const &packet)
+		{
+			for (unsigned i = 0; i < MAX_IN_FLIGHT; i++) {
+				Block::Packet_descriptor const &p = _requests[i].packet;
+				if (_requests[i].valid
+				 && p.offset()       == packet.offset()
+				 && p.operation()    == packet.operation()
+				 && p.block_number() == packet.block_number()
+				 && p.block_count()  == packet.block_count())
+					return &_requests[i];
+			}
+			return nullptr;
+		}
+
+		/**
+		 * Return packet referring to 'data' in place if it lies within the
+		 * bulk buffer, or an invalid packet otherwise
+		 */
+		Block::Packet_descriptor _in_place(void *data, size_t length)
+		{
+			Block::Packet_descriptor const p(
+				(Genode::off_t)((Genode::addr_t)data - _packet_base), length);
+
+			return _session.tx()->packet_valid(p) ? p : Block::Packet_descriptor();
+		}
+
+		static void *_completion_entry(void *backend)
+		{
+			/* the thread needs an lwp for calling 'biodone' */
+			_rump_upcalls.hyp_schedule();
+			_rump_upcalls.hyp_lwproc_newlwp(0);
+			_rump_upcalls.hyp_unschedule();
+
+			for (;;)
+				static_cast<Backend *>(backend)->_complete_next();
+
+			return nullptr;
+		}
+
+		/**
+		 * Await next acknowledgement and complete the corresponding request
+		 */
+		void _complete_next()
+		{
+			using namespace Block;
+
+			/* only this thread consumes acknowledgements */
+			Packet_descriptor packet = _session.tx()->get_acked_packet();
+
+			Request r;
+			{
+				Genode::Lock::Guard guard(_lock);
+
+				Request *req = _lookup(packet);
+				if (!req) {
+					Genode::error("I/O back end: unexpected acknowledgement");
+					return;
+				}
+
+				r = *req;
+				if (r.bounce && packet.operation() == Packet_descriptor::READ)
+					Genode::memcpy(r.data, _session.tx()->packet_content(packet),
+					               r.length);
+			}
+
+			bool const succeeded = packet.succeeded();
+
+			/* sync request */
+			if (r.op & RUMPUSER_BIO_SYNC)
+				_session.sync();
+
+			{
+				Genode::Lock::Guard guard(_lock);
+
+				if (r.bounce)
+					_session.tx()->release_packet(packet);
+
+				_lookup(packet)->valid = false;
+				_in_flight--;
+				_wake_up_waiters();
+			}
+
+			if (r.biodone) {
+				_rump_upcalls.hyp_schedule();
+				r.biodone(r.donearg, r.length, succeeded ? 0 : EIO);
+				_rump_upcalls.hyp_unschedule();
+			}
+		}
 
 	public:
 
 		Backend()
 		{
 			_session.info(&_blk_cnt, &_blk_size, &_blk_ops);
+
+			/* determine local address of the bulk buffer via a probe packet */
+			Block::Packet_descriptor probe = _session.tx()->alloc_packet(1);
+			_packet_base = (Genode::addr_t)_session.tx()->packet_content(probe)
+			             - probe.offset();
+			_session.tx()->release_packet(probe);
 		}
 
 		uint64_t block_count() const { return (uint64_t)_blk_cnt; }
@@ -52,64 +228,153 @@ class Backend
 			return _blk_ops.supported(Block::Packet_descriptor::WRITE);
 		}
 
+		/**
+		 * Wait until all requests in flight are completed, then sync device
+		 */
 		void sync()
 		{
-			Genode::Lock::Guard guard(_session_lock);
+			{
+				Genode::Lock::Guard guard(_lock);
+				while (_in_flight)
+					_wait_for_completion();
+			}
 			_session.sync();
 		}
 
-		bool submit(int op, int64_t offset, size_t length, void *data)
+		/**
+		 * Allocate memory for the rump kernel within the bulk buffer
+		 *
+		 * At most half of the bulk buffer is handed out, the rest is left
+		 * for copying data of requests on memory outside the bulk buffer.
+		 */
+		void *alloc_buffer(size_t length, int align)
 		{
-			using namespace Block;
+			Genode::Lock::Guard guard(_lock);
+
+			if (_buffers_used + length > _buffer_size / 2)
+				return nullptr;
 
-			Genode::Lock::Guard guard(_session_lock);
+			void *offset = nullptr;
+			if (_alloc.alloc_aligned(length, &offset, align).error())
+				return nullptr;
+
+			_buffers_used += length;
+			return (void *)(_packet_base + (Genode::addr_t)offset);
+		}
+
+		/**
+		 * Free memory allocated via 'alloc_buffer'
+		 *
+		 * \return  false if the memory is not located within the bulk buffer
+		 */
+		bool free_buffer(void *data, size_t length)
+		{
+			Genode::Lock::Guard guard(_lock);
+
+			Block::Packet_descriptor const p = _in_place(data, length);
+			if (!p.size())
+				return false;
+
+			_alloc.free((void *)p.offset(), length);
+			_buffers_used -= length;
+			return true;
+		}
+
+		/**
+		 * Submit request
+		 *
+		 * \return  false if the request could not be submitted, in which
+		 *          case 'biodone' is not called
+		 */
+		bool submit(int op, int64_t offset, size_t length, void *data,
+		            rump_biodone_fn biodone, void *donearg)
+		{
+			using namespace Block;
 
 			Packet_descriptor::Opcode opcode;
 			opcode = op & RUMPUSER_BIO_WRITE ? Packet_descriptor::WRITE :
 			                                   Packet_descriptor::READ;
-			/* allocate packet */
-			try {
-				Packet_descriptor packet( _session.dma_alloc_packet(length),
-				                         opcode, offset / _blk_size,
-				                         length / _blk_size);
 
-				/* out packet -> copy data */
-				if (opcode == Packet_descriptor::WRITE)
-					Genode::memcpy(_session.tx()->packet_content(packet), data, length);
+			Genode::Lock::Guard guard(_lock);
 
-				_session.tx()->submit_packet(packet);
-			} catch(Block::Session::Tx::Source::Packet_alloc_failed) {
-				Genode::error("I/O back end: Packet allocation failed!");
-				return false;
-			}
+			if (!_completion)
+				_completion = new (Rump::env().heap())
+					Hard_context_thread("rump_bio", _completion_entry, this, 0);
 
-			/* wait and process result */
-			Packet_descriptor packet = _session.tx()->get_acked_packet();
+			for (;;) {
 
-			/* in packet */
-			if (opcode == Packet_descriptor::READ)
-				Genode::memcpy(data, _session.tx()->packet_content(packet), length);
+				/* bound requests in flight to keep the submit queue from blocking */
+				if (_in_flight == MAX_IN_FLIGHT) {
+					_wait_for_completion();
+					continue;
+				}
 
-			bool succeeded = packet.succeeded();
-			_session.tx()->release_packet(packet);
+				Request &r = *_free_request();
+				r.bounce = false;
 
-			/* sync request */
-			if (op & RUMPUSER_BIO_SYNC) {
-				_session.sync();
-			}
+				Packet_descriptor p = _in_place(data, length);
+				if (!p.size()) {
+					try { p = _session.dma_alloc_packet(length); }
+					catch (Block::Session::Tx::Source::Packet_alloc_failed) {
+
+						/* wait for the release of bulk-buffer space */
+						if (_in_flight) {
+							_wait_for_completion();
+							continue;
+						}
+
+						Genode::error("I/O back end: Packet allocation failed!");
+						return false;
+					}
+					r.bounce = true;
+				}
 
-			return succeeded;
+				r.packet = Packet_descriptor(p, opcode, offset / _blk_size,
+				                             length / _blk_size);
+
+				/* out packet -> copy data */
+				if (r.bounce && opcode == Packet_descriptor::WRITE)
+					Genode::memcpy(_session.tx()->packet_content(r.packet), data, length);
+
+				r.valid   = true;
+				r.op      = op;
+				r.data    = data;
+				r.length  = length;
+				r.biodone = biodone;
+				r.donearg = donearg;
+				_in_flight++;
+
+				_session.tx()->submit_packet(r.packet);
+				return true;
+			}
 		}
 };
 
 
+/* back end, valid once constructed */
+static Backend *_backend;
+
+
 static Backend &backend()
 {
 	static Backend _b;
+	_backend = &_b;
 	return _b;
 }
 
 
+bool rump_io_backend_alloc(size_t length, int align, void **memp)
+{
+	return _backend && (*memp = _backend->alloc_buffer(length, align));
+}
+
+
+bool rump_io_backend_free(void *mem, size_t length)
+{
+	return _backend && _backend->free_buffer(mem, length);
+}
+
+
 int rumpuser_getfileinfo(const char *name, uint64_t *size, int *type)
 {
 	if (Genode::strcmp(GENODE_BLOCK_SESSION, name))
@@ -154,12 +419,12 @@ void rumpuser_bio(int fd, int op, void *data, size_t dlen, int64_t off,
 		            "bio ",   donearg, " "
 		            "sync: ", !!(op & RUMPUSER_BIO_SYNC));
 
-	bool succeeded = backend().submit(op, off, dlen, data);
+	bool submitted = backend().submit(op, off, dlen, data, biodone, donearg);
 
 	rumpkern_sched(nlocks, 0);
 
-	if (biodone)
-		biodone(donearg, dlen, succeeded ? 0 : EIO);
+	if (!submitted && biodone)
+		biodone(donearg, 0, EIO);
 }
 
 
@@ -0,0 +1,37 @@
+/**
+ * \brief  Interface between the block back end and the rump memory allocator
+ * \author Sebastian Sumpf
+ * \date   2017-07-05
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _IO_H_
+#define _IO_H_
+
+#include <base/stdint.h>
+
+/**
+ * Allocate memory within the bulk buffer of the block session
+ *
+ * I/O on such memory does not need to be copied. The function fails if the
+ * back end is not initialized yet or its share of the bulk buffer is used up.
+ *
+ * \param align  alignment as log2 value
+ * \return       true on success
+ */
+bool rump_io_backend_alloc(Genode::size_t length, int align, void **memp);
+
+/**
+ * Free memory allocated via 'rump_io_backend_alloc'
+ *
+ * \return  false if the memory was not allocated by the back end
+ */
+bool rump_io_backend_free(void *mem, Genode::size_t length);
+
+#endif /* _IO_H_ */
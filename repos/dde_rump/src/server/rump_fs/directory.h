@@ -42,6 +42,56 @@ class File_system::Directory : public Node
 		Path       _path;
 		Allocator &_alloc;
 
+		/*
+		 * Cursor of the sequential traversal by 'read'
+		 *
+		 * The buffer keeps the entries returned by the most recent
+		 * 'getdents' call. '_cursor' is the index of the entry returned by
+		 * the next '_next_dirent' call, not counting '.' and '..'. Reads
+		 * that continue where the previous read ended neither rewind the
+		 * directory nor skip the preceding entries.
+		 */
+		char               _dents[BUFFER_SIZE];
+		size_t             _dents_pos    = 0;
+		size_t             _dents_bytes  = 0;
+		seek_off_t         _cursor       = 0;
+		mutable bool       _cursor_valid = false;
+
+		void _rewind()
+		{
+			rump_sys_lseek(_fd, 0, SEEK_SET);
+			_dents_pos    = 0;
+			_dents_bytes  = 0;
+			_cursor       = 0;
+			_cursor_valid = true;
+		}
+
+		/**
+		 * Return next entry other than '.' and '..', or 0 at the end
+		 *
+		 * The returned entry is valid until the next call.
+		 */
+		struct ::dirent *_next_dirent()
+		{
+			for (;;) {
+				if (_dents_pos >= _dents_bytes) {
+					int const bytes = rump_sys_getdents(_fd, _dents, BUFFER_SIZE);
+					if (bytes <= 0) {
+						_dents_pos = _dents_bytes = 0;
+						return 0;
+					}
+					_dents_pos   = 0;
+					_dents_bytes = bytes;
+				}
+
+				struct ::dirent *d = (dirent *)(_dents + _dents_pos);
+				_dents_pos = (char *)_DIRENT_NEXT(d) - _dents;
+
+				if (strcmp(".", d->d_name) && strcmp("..", d->d_name))
+					return d;
+			}
+		}
+
 		unsigned long _inode(char const *path, bool create)
 		{
 			int ret;
@@ -110,16 +160,25 @@ class File_system::Directory : public Node
 
 		File * file(char const *name, Mode mode, bool create)
 		{
+			if (create)
+				_cursor_valid = false;
+
 			return new (&_alloc) File(_fd, name, mode, create);
 		}
 
 		Symlink * symlink(char const *name, bool create)
 		{
+			if (create)
+				_cursor_valid = false;
+
 			return new (&_alloc) Symlink(_path.base(), name, create);
 		}
 
 		Directory * subdir(char const *path, bool create)
 		{
+			if (create)
+				_cursor_valid = false;
+
 			Path dir_path(path, _path.base());
 			Directory *dir = new (&_alloc) Directory(_alloc, dir_path.base(), create);
 			return dir;
@@ -162,64 +221,59 @@ class File_system::Directory : public Node
 
 			seek_off_t index = seek_offset / sizeof(Directory_entry);
 
-			int bytes;
-			rump_sys_lseek(_fd, 0, SEEK_SET);
-
-			struct dirent *dent = 0;
-			seek_off_t        i = 0;
-			char *buf = _buffer();
-			do {
-				bytes = rump_sys_getdents(_fd, buf, BUFFER_SIZE);
-				void *current, *end;
-				for (current = buf, end = &buf[bytes];
-				     current < end;
-				     current = _DIRENT_NEXT((dirent *)current))
-				{
-					struct ::dirent *d = (dirent*)current;
-					if (strcmp(".", d->d_name) && strcmp("..", d->d_name)) {
-						if (i == index) {
-							dent = d;
-							break;
-						}
-						++i;
-					}
-				}
-			} while(bytes && !dent);
-
-			if (!dent)
-				return 0;
-
-			/*
-			 * Build absolute path, this becomes necessary as our 'Path' class strips
-			 * trailing dots, which will not work for '.' and  '..' directories.
-			 */
-			size_t base_len = strlen(_path.base());
-			char   path[dent->d_namlen + base_len + 2];
-
-			memcpy(path, _path.base(), base_len);
-			path[base_len] = '/';
-			strncpy(path + base_len + 1, dent->d_name, dent->d_namlen + 1);
-
-			/*
-			 * We cannot use 'd_type' member of 'dirent' here since the EXT2
-			 * implementation sets the type to unkown. Hence we use stat.
-			 */
-			struct stat s;
-			rump_sys_lstat(path, &s);
-
-			Directory_entry *e = (Directory_entry *)(dst);
-			if (S_ISDIR(s.st_mode))
-				e->type = Directory_entry::TYPE_DIRECTORY;
-			else if (S_ISREG(s.st_mode))
-				e->type = Directory_entry::TYPE_FILE;
-			else if (S_ISLNK(s.st_mode))
-				e->type = Directory_entry::TYPE_SYMLINK;
-			else
-				return 0;
+			/* seek to index, rewind only if the cursor lies beyond it */
+			if (!_cursor_valid || index < _cursor)
+				_rewind();
+
+			for (; _cursor < index; _cursor++)
+				if (!_next_dirent())
+					return 0;
+
+			/* read as many entries as fit into the buffer */
+			size_t n = 0;
+			while (len - n >= sizeof(Directory_entry)) {
+
+				struct dirent *dent = _next_dirent();
+				if (!dent)
+					break;
+
+				_cursor++;
+
+				/*
+				 * Build absolute path, this becomes necessary as our 'Path' class strips
+				 * trailing dots, which will not work for '.' and  '..' directories.
+				 */
+				size_t base_len = strlen(_path.base());
+				char   path[dent->d_namlen + base_len + 2];
+
+				memcpy(path, _path.base(), base_len);
+				path[base_len] = '/';
+				strncpy(path + base_len + 1, dent->d_name, dent->d_namlen + 1);
+
+				/*
+				 * We cannot use 'd_type' member of 'dirent' here since the EXT2
+				 * implementation sets the type to unkown. Hence we use stat.
+				 */
+				struct stat s;
+				rump_sys_lstat(path, &s);
+
+				Directory_entry *e = (Directory_entry *)(dst + n);
+				if (S_ISDIR(s.st_mode))
+					e->type = Directory_entry::TYPE_DIRECTORY;
+				else if (S_ISREG(s.st_mode))
+					e->type = Directory_entry::TYPE_FILE;
+				else if (S_ISLNK(s.st_mode))
+					e->type = Directory_entry::TYPE_SYMLINK;
+				else
+					return n;
+
+				e->inode = s.st_ino;
+				strncpy(e->name, dent->d_name, dent->d_namlen + 1);
+
+				n += sizeof(Directory_entry);
+			}
 
-			e->inode = s.st_ino;
-			strncpy(e->name, dent->d_name, dent->d_namlen + 1);
-			return sizeof(Directory_entry);
+			return n;
 		}
 
 		size_t write(char const *src, size_t len, seek_off_t seek_offset)
@@ -233,6 +287,9 @@ class File_system::Directory : public Node
 			int bytes = 0;
 			int count = 0;
 
+			/* the traversal moves the file offset under the cursor */
+			_cursor_valid = false;
+
 			rump_sys_lseek(_fd, 0, SEEK_SET);
 
 			char *buf = _buffer();
@@ -249,6 +306,8 @@ class File_system::Directory : public Node
 
 		void unlink(char const *path)
 		{
+			_cursor_valid = false;
+
 			Path node_path(path, _path.base());
 
 			struct stat s;
@@ -0,0 +1,233 @@
+/*
+ * \brief  Cache of remote-file chunks
+ * \author Sebastian Sumpf <Sebastian.Sumpf@genode-labs.com>
+ * \date   2017-07-04
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+/* Genode includes */
+#include <base/heap.h>
+#include <util/construct_at.h>
+#include <util/string.h>
+
+/* local includes */
+#include "http.h"
+
+class Cache
+{
+	typedef Genode::size_t size_t;
+	typedef Genode::addr_t addr_t;
+
+	public:
+
+		enum { CHUNK_SIZE = 64*1024 };
+
+		struct Stats
+		{
+			unsigned long long hits       = 0; /* chunks found in the cache */
+			unsigned long long misses     = 0; /* chunks fetched on demand */
+			unsigned long long read_ahead = 0; /* chunks fetched in advance */
+		};
+
+	private:
+
+		enum { INVALID = ~0UL };
+
+		/**
+		 * Cache line holding one chunk of the remote file
+		 */
+		struct Line
+		{
+			unsigned long chunk     = INVALID;
+			unsigned long last_used = 0;
+			unsigned long round     = 0;    /* read operation that uses the line */
+			char         *data      = nullptr;
+		};
+
+		Genode::Heap  &_heap;
+		Http          &_http;
+
+		unsigned const _num_lines;
+		unsigned const _read_ahead;      /* in chunks */
+		unsigned long  const _num_chunks;
+
+		Line          *_lines    = nullptr;
+		char          *_data     = nullptr;
+		Http::Request *_requests = nullptr;
+
+		unsigned long  _tick  = 0;
+		unsigned long  _round = 0;
+
+		Stats _stats;
+
+		size_t _chunk_size(unsigned long chunk) const
+		{
+			size_t const offset = chunk*CHUNK_SIZE;
+			return Genode::min((size_t)CHUNK_SIZE, _http.file_size() - offset);
+		}
+
+		Line *_lookup(unsigned long chunk)
+		{
+			for (unsigned i = 0; i < _num_lines; i++)
+				if (_lines[i].chunk == chunk)
+					return &_lines[i];
+			return nullptr;
+		}
+
+		/**
+		 * Return least-recently used line not used by the current round
+		 */
+		Line *_victim()
+		{
+			Line *victim = nullptr;
+			for (unsigned i = 0; i < _num_lines; i++) {
+				Line &l = _lines[i];
+				if (l.round == _round)
+					continue;
+				if (!victim || l.last_used < victim->last_used)
+					victim = &l;
+			}
+			return victim;
+		}
+
+		/**
+		 * Assign line to chunk and record the request for fetching it
+		 */
+		void _assign(Line &l, unsigned long chunk, unsigned &num_requests)
+		{
+			l.chunk     = chunk;
+			l.round     = _round;
+			l.last_used = ++_tick;
+
+			_requests[num_requests++] = Http::Request {
+				chunk*CHUNK_SIZE, _chunk_size(chunk), (addr_t)l.data };
+		}
+
+		/**
+		 * Make chunks 'first' to 'last' available in the cache
+		 *
+		 * Missing chunks are fetched together with the chunks following
+		 * 'last' as far as the read-ahead window and unused lines permit.
+		 */
+		void _fetch(unsigned long first, unsigned long last)
+		{
+			_round++;
+
+			unsigned num_requests = 0;
+			for (unsigned long chunk = first; chunk <= last; chunk++) {
+
+				if (Line *l = _lookup(chunk)) {
+					l->round     = _round;
+					l->last_used = ++_tick;
+					_stats.hits++;
+					continue;
+				}
+
+				_assign(*_victim(), chunk, num_requests);
+				_stats.misses++;
+			}
+
+			if (!num_requests)
+				return;
+
+			for (unsigned long chunk = last + 1;
+			     chunk <= last + _read_ahead && chunk < _num_chunks; chunk++) {
+
+				if (_lookup(chunk))
+					continue;
+
+				Line *l = _victim();
+				if (!l)
+					break;
+
+				_assign(*l, chunk, num_requests);
+				_stats.read_ahead++;
+			}
+
+			try { _http.get(_requests, num_requests); }
+			catch (...) {
+
+				/* drop lines with undefined content */
+				for (unsigned i = 0; i < num_requests; i++)
+					if (Line *l = _lookup(_requests[i].file_offset / CHUNK_SIZE))
+						l->chunk = INVALID;
+				throw;
+			}
+		}
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param size        cache size in bytes
+		 * \param read_ahead  number of bytes fetched in advance on a miss
+		 */
+		Cache(Genode::Heap &heap, Http &http, size_t size, size_t read_ahead)
+		:
+			_heap(heap), _http(http),
+			_num_lines(Genode::max(1UL, size / CHUNK_SIZE)),
+			_read_ahead(Genode::min((read_ahead + CHUNK_SIZE - 1) / CHUNK_SIZE,
+			                        (size_t)_num_lines - 1)),
+			_num_chunks((http.file_size() + CHUNK_SIZE - 1) / CHUNK_SIZE)
+		{
+			_heap.alloc(_num_lines*sizeof(Line),          (void**)&_lines);
+			_heap.alloc(_num_lines*CHUNK_SIZE,            (void**)&_data);
+			_heap.alloc(_num_lines*sizeof(Http::Request), (void**)&_requests);
+
+			for (unsigned i = 0; i < _num_lines; i++)
+				Genode::construct_at<Line>(&_lines[i])->data = _data + i*CHUNK_SIZE;
+		}
+
+		~Cache()
+		{
+			_heap.free(_requests, _num_lines*sizeof(Http::Request));
+			_heap.free(_data, _num_lines*CHUNK_SIZE);
+			_heap.free(_lines, _num_lines*sizeof(Line));
+		}
+
+		Stats const &stats() const { return _stats; }
+
+		/**
+		 * Read 'size' bytes at 'offset' of the remote file into 'dst'
+		 */
+		void read(size_t offset, size_t size, char *dst)
+		{
+			if (!size)
+				return;
+
+			unsigned long const first = offset / CHUNK_SIZE;
+			unsigned long const last  = (offset + size - 1) / CHUNK_SIZE;
+
+			/* requests larger than the cache are served window by window */
+			for (unsigned long w = first; w <= last; w += _num_lines) {
+
+				unsigned long const w_last = Genode::min(last, w + _num_lines - 1);
+
+				_fetch(w, w_last);
+
+				for (unsigned long chunk = w; chunk <= w_last; chunk++) {
+
+					size_t const chunk_offset = chunk*CHUNK_SIZE;
+					size_t const from = Genode::max(offset, chunk_offset);
+					size_t const to   = Genode::min(offset + size,
+					                                chunk_offset + CHUNK_SIZE);
+
+					Genode::memcpy(dst + (from - offset),
+					               _lookup(chunk)->data + (from - chunk_offset),
+					               to - from);
+				}
+			}
+		}
+};
+
+#endif /* _CACHE_H_ */
@@ -32,8 +32,8 @@ enum {
 	HTTP_SUCC_OK      = 200,
 	HTTP_SUCC_PARTIAL = 206,
 
-	/* Size of our local buffer */
-	HTTP_BUF = 2048,
+	/* number of attempts to re-issue requests of a failed connection */
+	MAX_RETRIES = 3,
 };
 
 /* Tokenizer policy */
@@ -48,7 +48,7 @@ struct Scanner_policy_file
 typedef ::Genode::Token<Scanner_policy_file> Http_token;
 
 
-void Http::cmd_head()
+void Http::cmd_head(Connection &c)
 {
 	const char *http_templ = "%s %s HTTP/1.1\r\n"
 	                         "Host: %s\r\n"
@@ -56,29 +56,39 @@ void Http::cmd_head()
 
 	int length = snprintf(_http_buf, HTTP_BUF, http_templ, "HEAD", _path, _host);
 
-	if (write(_fd, _http_buf, length) != length) {
+	if (write(c.fd, _http_buf, length) != length) {
 		error("cmd_head: write error");
 		throw Http::Socket_error();
 	}
 }
 
 
-void Http::connect()
+void Http::connect(Connection &c)
 {
-	_fd = socket(AF_INET, SOCK_STREAM, 0);
-	if (_fd < 0) {
+	c.pos  = 0;
+	c.fill = 0;
+
+	c.fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (c.fd < 0) {
 		error("connect: no socket avaiable");
 		throw Http::Socket_error();
 	}
 
-	if (::connect(_fd, _info->ai_addr, sizeof(*(_info->ai_addr))) < 0) {
+	if (::connect(c.fd, _info->ai_addr, sizeof(*(_info->ai_addr))) < 0) {
 		error("connect: connect failed");
 		throw Http::Socket_error();
 	}
 }
 
 
-void Http::reconnect(){ close(_fd); connect(); }
+void Http::reconnect(Connection &c)
+{
+	if (c.fd >= 0)
+		close(c.fd);
+
+	c.fd = -1;
+	connect(c);
+}
 
 
 void Http::resolve_uri()
@@ -94,13 +104,23 @@ void Http::resolve_uri()
 }
 
 
-Genode::size_t Http::read_header()
+Http::Response Http::read_header(Connection &c)
 {
 	bool header = true; size_t i = 0;
 
 	while (header) {
-		if (!read(_fd, &_http_buf[i], 1))
-			throw Http::Socket_closed();
+
+		/* refill receive buffer */
+		if (c.pos == c.fill) {
+			int const n = read(c.fd, c.buf, sizeof(c.buf));
+			if (n <= 0)
+				throw Http::Socket_closed();
+
+			c.pos  = 0;
+			c.fill = n;
+		}
+
+		_http_buf[i] = c.buf[c.pos++];
 
 		if (i >= 3 && _http_buf[i - 3] == '\r' && _http_buf[i - 2] == '\n'
 		 && _http_buf[i - 1] == '\r' && _http_buf[i - 0] == '\n')
@@ -112,64 +132,72 @@ Genode::size_t Http::read_header()
 		}
 	}
 
-	/* scan for status code */
-	Http_token t(_http_buf, i);
-	for (int count = 0;; t = t.next()) {
+	/*
+	 * Scan for status code, which is the second token, and the values of
+	 * the header fields we are interested in
+	 */
+	Response response;
+	enum { NONE, LENGTH, CONNECTION } key = NONE;
+	char buf[32];
+	unsigned count = 0;
+	for (Http_token t(_http_buf, i); t; t = t.next()) {
 
 		if (t.type() != Http_token::IDENT)
 			continue;
 
-		if (count) {
-			ascii_to(t.start(), _http_ret);
-			break;
+		if (count++ == 1) {
+			ascii_to(t.start(), response.status);
+			continue;
+		}
+
+		t.string(buf, sizeof(buf));
+
+		switch (key) {
+		case LENGTH:     ascii_to(t.start(), response.content_length); break;
+		case CONNECTION: response.close = !Genode::strcmp(buf, "close", 5); break;
+		case NONE:       break;
 		}
 
-		count++;
+		key = !Genode::strcmp(buf, "Content-Length", sizeof(buf)) ? LENGTH
+		    : !Genode::strcmp(buf, "Connection",     sizeof(buf)) ? CONNECTION
+		    : NONE;
 	}
 
-	return i;
+	return response;
 }
 
 
 void Http::get_capacity()
 {
-	cmd_head();
-	size_t  len = read_header();
-	char buf[32];
-	Http_token t(_http_buf, len);
-
-	bool key = false;
-	while (t) {
+	Connection &c = _connections[0];
 
-		if (t.type() != Http_token::IDENT) {
-			t = t.next();
-			continue;
-		}
+	cmd_head(c);
+	Response const response = read_header(c);
 
-		if (key) {
-			ascii_to(t.start(), _size);
-			break;
-		}
-
-		t.string(buf, 32);
+	if (response.status != HTTP_SUCC_OK) {
+		error("get_capacity: server returned ", response.status);
+		throw Http::Server_error();
+	}
 
-		if (!Genode::strcmp(buf, "Content-Length", 32))
-			key = true;
+	_size = response.content_length;
 
-		t = t.next();
-	}
+	if (response.close)
+		reconnect(c);
 }
 
 
-void Http::do_read(void * buf, size_t size)
+void Http::do_read(Connection &c, void * buf, size_t size)
 {
-	size_t buf_fill = 0;
+	/* consume data already received along with the header */
+	size_t buf_fill = min(size, c.fill - c.pos);
+	Genode::memcpy(buf, c.buf + c.pos, buf_fill);
+	c.pos += buf_fill;
 
 	while (buf_fill < size) {
 
 		int part;
-		if ((part = read(_fd, (void *)((addr_t)buf + buf_fill),
-		                      size - buf_fill)) <= 0) {
+		if ((part = read(c.fd, (void *)((addr_t)buf + buf_fill),
+		                       size - buf_fill)) <= 0) {
 			error("could not read data (", errno, ")");
 			throw Http::Socket_error();
 		}
@@ -179,8 +207,12 @@ void Http::do_read(void * buf, size_t size)
 }
 
 
-Http::Http(Genode::Heap &heap, ::String &uri)
-: _heap(heap), _port((char *)"80")
+Http::Http(Genode::Heap &heap, ::String &uri,
+           unsigned connections, unsigned pipeline)
+:
+	_heap(heap), _size(0), _port((char *)"80"),
+	_num_connections(max(1U, min(connections, (unsigned)MAX_CONNECTIONS))),
+	_pipeline(max(1U, min(pipeline, (unsigned)MAX_PIPELINE)))
 {
 	_heap.alloc(HTTP_BUF, (void**)&_http_buf);
 
@@ -191,7 +223,8 @@ Http::Http(Genode::Heap &heap, ::String &uri)
 	resolve_uri();
 
 	/* connect to host */
-	connect();
+	for (unsigned i = 0; i < _num_connections; i++)
+		connect(_connections[i]);
 
 	/* retrieve file info */
 	get_capacity();
@@ -200,6 +233,10 @@ Http::Http(Genode::Heap &heap, ::String &uri)
 
 Http::~Http()
 {
+	for (unsigned i = 0; i < _num_connections; i++)
+		if (_connections[i].fd >= 0)
+			close(_connections[i].fd);
+
 	_heap.free(_host, Genode::strlen(_host) + 1);
 	_heap.free(_path, Genode::strlen(_path) + 2);
 	_heap.free(_http_buf, HTTP_BUF);
@@ -239,40 +276,102 @@ void Http::parse_uri(::String & u)
 }
 
 
-void Http::cmd_get(size_t file_offset, size_t size, addr_t buffer)
+void Http::send_get(Connection &c, Request const &request)
 {
-	while (true) {
+	const char *http_templ = "GET %s HTTP/1.1\r\n"
+	                         "Host: %s\r\n"
+	                         "Range: bytes=%lu-%lu\r\n"
+	                         "\r\n";
 
-		const char *http_templ = "GET %s HTTP/1.1\r\n"
-		                         "Host: %s\r\n"
-		                         "Range: bytes=%lu-%lu\r\n"
-		                         "\r\n";
+	int length = snprintf(_http_buf, HTTP_BUF, http_templ, _path, _host,
+	                      request.file_offset,
+	                      request.file_offset + request.size - 1);
 
-		int length = snprintf(_http_buf, HTTP_BUF, http_templ, _path, _host,
-		                      file_offset, file_offset + size - 1);
+	if (write(c.fd, _http_buf, length) != length)
+		throw Http::Socket_closed();
+}
 
-		if (write(_fd, _http_buf, length) < 0) {
 
-			if (errno == ESHUTDOWN)
-				reconnect();
+bool Http::receive(Connection &c, Request const &request)
+{
+	Response const response = read_header(c);
+
+	if (response.status != HTTP_SUCC_PARTIAL
+	 || response.content_length != request.size) {
+		error("cmd_get: server returned ", response.status, " with ",
+		      response.content_length, " bytes for range of ",
+		      request.size, " bytes");
+		throw Http::Server_error();
+	}
 
-			if (write(_fd, _http_buf, length) < 0)
-				throw Http::Socket_error();
-		}
+	do_read(c, (void *)request.buffer, request.size);
+	return response.close;
+}
 
-		try {
-			read_header();
-		} catch (Http::Socket_closed) {
-			reconnect();
-			continue;
-		}
 
-		if (_http_ret != HTTP_SUCC_PARTIAL) {
-			error("cmd_get: server returned ", _http_ret);
-			throw Http::Server_error();
+void Http::get(Request const *requests, unsigned count)
+{
+	/*
+	 * Request 'i' is served by connection 'i % n'. For each connection,
+	 * 'sent' and 'received' count the requests of the connection that were
+	 * sent and completed.
+	 */
+	unsigned const n = min(count, _num_connections);
+
+	unsigned sent[MAX_CONNECTIONS], received[MAX_CONNECTIONS],
+	         failures[MAX_CONNECTIONS];
+
+	for (unsigned i = 0; i < n; i++)
+		sent[i] = received[i] = failures[i] = 0;
+
+	auto index = [&] (unsigned conn, unsigned nr) { return conn + nr*n; };
+
+	/*
+	 * A broken connection loses all responses in flight. Re-connect and
+	 * re-issue the requests, unless the connection fails persistently.
+	 */
+	auto restart = [&] (unsigned i) {
+		Connection &c = _connections[i];
+		if (++failures[i] > MAX_RETRIES) {
+			error("connection to ", Cstring(_host), " failed persistently");
+			throw Http::Socket_error();
 		}
+		reconnect(c);
+		sent[i] = received[i];
+	};
+
+	for (unsigned done = 0; done < count; ) {
+
+		/* fill up pipelines */
+		for (unsigned i = 0; i < n; i++) {
+			try {
+				while (sent[i] - received[i] < _pipeline
+				    && index(i, sent[i]) < count) {
+					send_get(_connections[i], requests[index(i, sent[i])]);
+					sent[i]++;
+				}
+			} catch (Http::Socket_closed) { restart(i); }
+		}
+
+		/* collect one response per connection */
+		for (unsigned i = 0; i < n; i++) {
 
-		do_read((void *)(buffer), size);
-		return;
+			if (received[i] == sent[i])
+				continue;
+
+			Connection &c = _connections[i];
+			try {
+				bool const close = receive(c, requests[index(i, received[i])]);
+				received[i]++;
+				failures[i] = 0;
+				done++;
+
+				/* the server drops requests sent after the closing one */
+				if (close)
+					restart(i);
+
+			} catch (Http::Socket_closed) { restart(i);
+			} catch (Http::Socket_error)  { restart(i); }
+		}
 	}
 }
@@ -25,33 +25,78 @@ class Http
 	typedef Genode::addr_t addr_t;
 	typedef Genode::off_t  off_t;
 
+	public:
+
+		enum {
+			HTTP_BUF        = 2048, /* size of header and receive buffers */
+			MAX_CONNECTIONS = 16,
+			MAX_PIPELINE    = 16,
+		};
+
+		/**
+		 * Range of the remote file to be transferred to a local buffer
+		 */
+		struct Request
+		{
+			size_t file_offset;
+			size_t size;
+			addr_t buffer;
+		};
+
 	private:
 
+		/**
+		 * Keep-alive connection to the host
+		 *
+		 * Received data is buffered so that the headers of pipelined
+		 * responses can be parsed without reading byte by byte from the
+		 * socket.
+		 */
+		struct Connection
+		{
+			int    fd   = -1;
+			size_t pos  = 0;      /* read position within 'buf' */
+			size_t fill = 0;      /* number of valid bytes in 'buf' */
+			char   buf[HTTP_BUF];
+		};
+
+		/**
+		 * Information parsed from a response header
+		 */
+		struct Response
+		{
+			unsigned status         = 0;
+			size_t   content_length = 0;
+			bool     close          = false;
+		};
+
 		Genode::Heap   &_heap;
 		size_t          _size;      /* number of bytes in file */
 		char            *_host;      /* host name */
 		char            *_port;      /* host port */
 		char            *_path;      /* absolute file path on host */
 		char            *_http_buf;  /* internal data buffer */
-		unsigned         _http_ret;  /* HTTP status code */
 		struct addrinfo *_info;      /* Resolved address info for host */
-		int              _fd;        /* Socket file handle */
 		addr_t          _base_addr; /* Address of I/O dataspace */
 
+		unsigned const  _num_connections;
+		unsigned const  _pipeline;   /* max. outstanding requests per connection */
+		Connection      _connections[MAX_CONNECTIONS];
+
 		/*
 		 * Send 'HEAD' command
 		 */
-		void cmd_head();
+		void cmd_head(Connection &c);
 
 		/*
 		 * Connect to host
 		 */
-		void connect();
+		void connect(Connection &c);
 
 		/*
 		 * Re-connect to host
 		 */
-		void reconnect();
+		void reconnect(Connection &c);
 
 		/*
 		 * Set URI of remote file
@@ -64,9 +109,9 @@ class Http
 		void resolve_uri();
 
 		/*
-		 * Read HTTP header and parse server-status code
+		 * Read HTTP header and parse server-status code and relevant fields
 		 */
-		size_t read_header();
+		Response read_header(Connection &c);
 
 		/*
 		 * Determine remote-file size
@@ -76,14 +121,30 @@ class Http
 		/*
 		 * Read 'size' bytes into buffer
 		 */
-		void do_read(void * buf, size_t size);
+		void do_read(Connection &c, void * buf, size_t size);
+
+		/*
+		 * Send 'GET' command for the range of the request
+		 */
+		void send_get(Connection &c, Request const &request);
+
+		/*
+		 * Receive response to the 'GET' command of the request
+		 *
+		 * \return  true if the server is going to close the connection
+		 */
+		bool receive(Connection &c, Request const &request);
 
 	public:
 
 		/*
 		 * Constructor (default host port is 80
+		 *
+		 * \param connections  number of keep-alive connections to the host
+		 * \param pipeline     number of requests in flight per connection
 		 */
-		Http(Genode::Heap &heap, ::String &uri);
+		Http(Genode::Heap &heap, ::String &uri,
+		     unsigned connections = 1, unsigned pipeline = 1);
 
 		/*
 		 * Destructor
@@ -105,13 +166,18 @@ class Http
 		void  base_addr(addr_t base_addr) { _base_addr = base_addr; }
 
 		/**
-		 * Send 'GET' command
+		 * Transfer ranges of the remote file
+		 *
+		 * The requests are distributed round-robin among the connections.
+		 * On each connection, up to 'pipeline' range requests are sent
+		 * before the first response is awaited. Hence, the latency of the
+		 * requests overlaps. The call returns after all requests are
+		 * completed.
 		 *
-		 * \param file_offset  Read from offset of remote file
-		 * \param size         Number of byts to transfer
-		 * \param buffer       address in I/O dataspace
+		 * \param requests  array of requests
+		 * \param count     number of requests
 		 */
-		void cmd_get(size_t file_offset, size_t size, addr_t buffer);
+		void get(Request const *requests, unsigned count);
 
 		/* Exceptions */
 		class Exception     : public ::Genode::Exception { };
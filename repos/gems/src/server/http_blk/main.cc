@@ -19,6 +19,7 @@
 #include <libc/component.h>
 
 /* local includes */
+#include "cache.h"
 #include "http.h"
 
 using namespace Genode;
@@ -27,15 +28,41 @@ class Driver : public Block::Driver
 {
 	private:
 
-		size_t _block_size;
-		Http   _http;
+		enum { STATS_INTERVAL = 1024 };
+
+		size_t        _block_size;
+		Http          _http;
+		Cache         _cache;
+		bool const    _verbose;
+		unsigned long _requests = 0;
+
+		void _log_stats()
+		{
+			Cache::Stats const &s = _cache.stats();
+			log("cache: ", s.hits, " hits, ", s.misses, " misses, ",
+			    s.read_ahead, " chunks read ahead");
+		}
 
 	public:
 
-		Driver(Heap &heap, Ram_session &ram,
-		       size_t block_size, ::String &uri)
+		struct Config
+		{
+			size_t   block_size;
+			unsigned connections;
+			unsigned pipeline;
+			size_t   cache_size;
+			size_t   read_ahead;
+			bool     verbose;
+		};
+
+		Driver(Heap &heap, Ram_session &ram, Config const &config, ::String &uri)
 		: Block::Driver(ram),
-		  _block_size(block_size), _http(heap, uri) {}
+		  _block_size(config.block_size),
+		  _http(heap, uri, config.connections, config.pipeline),
+		  _cache(heap, _http, config.cache_size, config.read_ahead),
+		  _verbose(config.verbose) {}
+
+		~Driver() { if (_verbose) _log_stats(); }
 
 
 		/*******************************
@@ -57,9 +84,12 @@ class Driver : public Block::Driver
 		          char                     *buffer,
 		          Block::Packet_descriptor &packet)
 		{
-			_http.cmd_get(block_nr * _block_size, block_count * _block_size,
-			              (addr_t)buffer);
+			_cache.read(block_nr * _block_size, block_count * _block_size,
+			            buffer);
 			ack_packet(packet);
+
+			if (_verbose && ++_requests % STATS_INTERVAL == 0)
+				_log_stats();
 		}
 	};
 
@@ -73,6 +103,7 @@ class Factory : public Block::Driver_factory
 		Attached_rom_dataspace _config { _env, "config" };
 		::String               _uri;
 		size_t                 _blk_sz;
+		Driver::Config         _driver_config;
 
 	public:
 
@@ -85,12 +116,26 @@ class Factory : public Block::Driver_factory
 			}
 			catch (...) { }
 
+			Xml_node const config = _config.xml();
+
+			_driver_config = Driver::Config {
+				_blk_sz,
+				config.attribute_value("connections", 4U),
+				config.attribute_value("pipeline",    4U),
+				config.attribute_value("cache_size",  Number_of_bytes(1024*1024)),
+				config.attribute_value("read_ahead",  Number_of_bytes(128*1024)),
+				config.attribute_value("verbose",     false) };
+
 			log("Using file=", _uri, " as device with block size ",
 			    Hex(_blk_sz, Hex::OMIT_PREFIX), ".");
+			log("Fetching over ", _driver_config.connections, " connection(s) with ",
+			    _driver_config.pipeline, " request(s) in flight each, cache size ",
+			    Number_of_bytes(_driver_config.cache_size), ", read ahead ",
+			    Number_of_bytes(_driver_config.read_ahead));
 		}
 
 		Block::Driver *create() {
-			return new (&_heap) Driver(_heap, _env.ram(), _blk_sz, _uri); }
+			return new (&_heap) Driver(_heap, _env.ram(), _driver_config, _uri); }
 
 	void destroy(Block::Driver *driver) {
 		Genode::destroy(&_heap, driver); }
@@ -408,6 +408,7 @@ ssize_t Libc::Vfs_plugin::getdirentries(Libc::File_descriptor *fd, char *buf,
 {
 	if (nbytes < sizeof(struct dirent)) {
 		Genode::error("getdirentries: buffer too small");
+		errno = EINVAL;
 		return -1;
 	}
 
@@ -415,49 +416,70 @@ ssize_t Libc::Vfs_plugin::getdirentries(Libc::File_descriptor *fd, char *buf,
 
 	Vfs::Vfs_handle *handle = vfs_handle(fd);
 
-	Vfs::Directory_service::Dirent dirent_out;
-	Genode::memset(&dirent_out, 0, sizeof(dirent_out));
+	/*
+	 * Read as many entries as fit into the user-supplied buffer with one
+	 * 'dirents' call, bounded by the batch on the stack
+	 */
+	enum { BATCH = 16 };
+	static_assert(BATCH*sizeof(Vfs::Directory_service::Dirent) <= 4096,
+	              "dirent batch too large for the stack");
+
+	Vfs::Directory_service::Dirent dirents_out[BATCH];
+
+	unsigned const count = Genode::min((::size_t)BATCH,
+	                                   nbytes / sizeof(struct dirent));
 
 	unsigned const index = handle->seek() / sizeof(Vfs::Directory_service::Dirent);
 
-	switch (handle->ds().dirent(fd->fd_path, index, dirent_out)) {
+	unsigned out_count = 0;
+	switch (handle->ds().dirents(fd->fd_path, index, dirents_out, count, out_count)) {
 	case Result::DIRENT_ERR_INVALID_PATH: errno = ENOENT; return -1;
 	case Result::DIRENT_ERR_NO_PERM:      errno = EACCES; return -1;
 	case Result::DIRENT_OK:                               break;
 	}
 
 	/*
-	 * Convert dirent structure from VFS to libc
+	 * Convert dirent structures from VFS to libc
 	 */
 
-	struct dirent *dirent = (struct dirent *)buf;
-	Genode::memset(dirent, 0, sizeof(struct dirent));
+	unsigned n = 0;
+	for (; n < out_count; n++) {
 
-	switch (dirent_out.type) {
-	case Vfs::Directory_service::DIRENT_TYPE_DIRECTORY: dirent->d_type = DT_DIR;  break;
-	case Vfs::Directory_service::DIRENT_TYPE_FILE:      dirent->d_type = DT_REG;  break;
-	case Vfs::Directory_service::DIRENT_TYPE_SYMLINK:   dirent->d_type = DT_LNK;  break;
-	case Vfs::Directory_service::DIRENT_TYPE_FIFO:      dirent->d_type = DT_FIFO; break;
-	case Vfs::Directory_service::DIRENT_TYPE_CHARDEV:   dirent->d_type = DT_CHR;  break;
-	case Vfs::Directory_service::DIRENT_TYPE_BLOCKDEV:  dirent->d_type = DT_BLK;  break;
-	case Vfs::Directory_service::DIRENT_TYPE_END:                                 return 0;
-	}
+		Vfs::Directory_service::Dirent const &dirent_out = dirents_out[n];
 
-	dirent->d_fileno = dirent_out.fileno;
-	dirent->d_reclen = sizeof(struct dirent);
+		struct dirent *dirent = (struct dirent *)buf + n;
+		Genode::memset(dirent, 0, sizeof(struct dirent));
 
-	Genode::strncpy(dirent->d_name, dirent_out.name, sizeof(dirent->d_name));
+		bool end = false;
+		switch (dirent_out.type) {
+		case Vfs::Directory_service::DIRENT_TYPE_DIRECTORY: dirent->d_type = DT_DIR;  break;
+		case Vfs::Directory_service::DIRENT_TYPE_FILE:      dirent->d_type = DT_REG;  break;
+		case Vfs::Directory_service::DIRENT_TYPE_SYMLINK:   dirent->d_type = DT_LNK;  break;
+		case Vfs::Directory_service::DIRENT_TYPE_FIFO:      dirent->d_type = DT_FIFO; break;
+		case Vfs::Directory_service::DIRENT_TYPE_CHARDEV:   dirent->d_type = DT_CHR;  break;
+		case Vfs::Directory_service::DIRENT_TYPE_BLOCKDEV:  dirent->d_type = DT_BLK;  break;
+		case Vfs::Directory_service::DIRENT_TYPE_END:       end = true;               break;
+		}
+
+		if (end)
+			break;
 
-	dirent->d_namlen = Genode::strlen(dirent->d_name);
+		dirent->d_fileno = dirent_out.fileno;
+		dirent->d_reclen = sizeof(struct dirent);
+
+		Genode::strncpy(dirent->d_name, dirent_out.name, sizeof(dirent->d_name));
+
+		dirent->d_namlen = Genode::strlen(dirent->d_name);
+	}
 
 	/*
 	 * Keep track of VFS seek pointer and user-supplied basep.
 	 */
-	handle->advance_seek(sizeof(Vfs::Directory_service::Dirent));
+	handle->advance_seek(n*sizeof(Vfs::Directory_service::Dirent));
 
-	*basep += sizeof(struct dirent);
+	*basep += n*sizeof(struct dirent);
 
-	return sizeof(struct dirent);
+	return n*sizeof(struct dirent);
 }
 
 
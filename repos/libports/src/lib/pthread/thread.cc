@@ -14,7 +14,9 @@
 
 #include <base/log.h>
 #include <base/thread.h>
+#include <cpu/atomic.h>
 #include <os/timed_semaphore.h>
+#include <util/fifo.h>
 #include <util/list.h>
 
 #include <errno.h>
@@ -260,15 +262,66 @@ extern "C" {
 	};
 
 
+	/*
+	 * Futex-style lock word
+	 *
+	 * The word is 0 if unlocked, 1 if locked, and 2 if locked with possibly
+	 * blocked waiters. Uncontended lock and unlock operations are a single
+	 * atomic operation each. Only contended operations block at the
+	 * semaphore, which acts as the wait queue. A surplus 'up' merely causes
+	 * a waiter to re-check the lock word.
+	 */
+	struct Lock_word
+	{
+		volatile int state = 0;
+		Semaphore    waiters;
+
+		static int xchg(volatile int *dst, int value)
+		{
+			for (;;) {
+				int const old = *dst;
+				if (cmpxchg(dst, old, value))
+					return old;
+			}
+		}
+
+		static void add(volatile int *dst, int value)
+		{
+			for (;;) {
+				int const old = *dst;
+				if (cmpxchg(dst, old, old + value))
+					return;
+			}
+		}
+
+		bool try_lock() { return cmpxchg(&state, 0, 1); }
+
+		void lock()
+		{
+			if (try_lock())
+				return;
+
+			while (xchg(&state, 2) != 0)
+				waiters.down();
+		}
+
+		void unlock()
+		{
+			if (xchg(&state, 0) == 2)
+				waiters.up();
+		}
+	};
+
+
 	struct pthread_mutex
 	{
 		pthread_mutex_attr mutexattr;
 
-		Lock mutex_lock;
+		Lock_word mutex_lock;
 
-		pthread_t owner;
-		int       lock_count;
-		Lock      owner_and_counter_lock;
+		/* owner and recursion depth, not tracked for normal mutexes */
+		Thread *owner;
+		int     lock_count;
 
 		pthread_mutex(const pthread_mutexattr_t *__restrict attr)
 		: owner(0),
@@ -278,136 +331,73 @@ extern "C" {
 				mutexattr = **attr;
 		}
 
-		int lock()
+		bool _normal() const
 		{
-			if (mutexattr.type == PTHREAD_MUTEX_RECURSIVE) {
-
-				Lock::Guard lock_guard(owner_and_counter_lock);
-
-				if (lock_count == 0) {
-					owner = pthread_self();
-					lock_count++;
-					mutex_lock.lock();
-					return 0;
-				}
+			return mutexattr.type != PTHREAD_MUTEX_RECURSIVE
+			    && mutexattr.type != PTHREAD_MUTEX_ERRORCHECK;
+		}
 
-				/* the mutex is already locked */
-				if (pthread_self() == owner) {
-					lock_count++;
-					return 0;
-				} else {
-					mutex_lock.lock();
-					return 0;
-				}
+		int lock()
+		{
+			/* PTHREAD_MUTEX_NORMAL or PTHREAD_MUTEX_DEFAULT */
+			if (_normal()) {
+				mutex_lock.lock();
+				return 0;
 			}
 
-			if (mutexattr.type == PTHREAD_MUTEX_ERRORCHECK) {
-
-				Lock::Guard lock_guard(owner_and_counter_lock);
-
-				if (lock_count == 0) {
-					owner = pthread_self();
-					mutex_lock.lock();
-					return 0;
-				}
+			/* only the owner itself can observe 'owner == myself' */
+			Thread * const myself = Thread::myself();
 
-				/* the mutex is already locked */
-				if (pthread_self() != owner) {
-					mutex_lock.lock();
-					return 0;
-				} else
+			if (lock_count && owner == myself) {
+				if (mutexattr.type == PTHREAD_MUTEX_ERRORCHECK)
 					return EDEADLK;
+
+				lock_count++;
+				return 0;
 			}
 
-			/* PTHREAD_MUTEX_NORMAL or PTHREAD_MUTEX_DEFAULT */
 			mutex_lock.lock();
+			owner      = myself;
+			lock_count = 1;
 			return 0;
 		}
 
 		int trylock()
 		{
-			if (mutexattr.type == PTHREAD_MUTEX_RECURSIVE) {
+			if (_normal())
+				return mutex_lock.try_lock() ? 0 : EBUSY;
 
-				Lock::Guard lock_guard(owner_and_counter_lock);
+			Thread * const myself = Thread::myself();
 
-				if (lock_count == 0) {
-					owner = pthread_self();
-					lock_count++;
-					mutex_lock.lock();
-					return 0;
-				}
-
-				/* the mutex is already locked */
-				if (pthread_self() == owner) {
-					lock_count++;
-					return 0;
-				} else {
-					return EBUSY;
-				}
-			}
-
-			if (mutexattr.type == PTHREAD_MUTEX_ERRORCHECK) {
-
-				Lock::Guard lock_guard(owner_and_counter_lock);
-
-				if (lock_count == 0) {
-					owner = pthread_self();
-					mutex_lock.lock();
-					return 0;
-				}
-
-				/* the mutex is already locked */
-				if (pthread_self() != owner) {
-					return EBUSY;
-				} else
+			if (lock_count && owner == myself) {
+				if (mutexattr.type == PTHREAD_MUTEX_ERRORCHECK)
 					return EDEADLK;
-			}
 
-			/* PTHREAD_MUTEX_NORMAL or PTHREAD_MUTEX_DEFAULT */
-			Lock::Guard lock_guard(owner_and_counter_lock);
-
-			if (lock_count == 0) {
-				owner = pthread_self();
-				mutex_lock.lock();
+				lock_count++;
 				return 0;
 			}
 
-			return EBUSY;
+			if (!mutex_lock.try_lock())
+				return EBUSY;
+
+			owner      = myself;
+			lock_count = 1;
+			return 0;
 		}
 
 		int unlock()
 		{
+			if (!_normal()) {
 
-			if (mutexattr.type == PTHREAD_MUTEX_RECURSIVE) {
-
-				Lock::Guard lock_guard(owner_and_counter_lock);
-
-				if (pthread_self() != owner)
+				if (!lock_count || owner != Thread::myself())
 					return EPERM;
 
-				lock_count--;
-
-				if (lock_count == 0) {
-					owner = 0;
-					mutex_lock.unlock();
-				}
-
-				return 0;
-			}
-
-			if (mutexattr.type == PTHREAD_MUTEX_ERRORCHECK) {
-
-				Lock::Guard lock_guard(owner_and_counter_lock);
-
-				if (pthread_self() != owner)
-					return EPERM;
+				if (--lock_count > 0)
+					return 0;
 
 				owner = 0;
-				mutex_lock.unlock();
-				return 0;
 			}
 
-			/* PTHREAD_MUTEX_NORMAL or PTHREAD_MUTEX_DEFAULT */
 			mutex_lock.unlock();
 			return 0;
 		}
@@ -480,9 +470,7 @@ extern "C" {
 		if (*mutex == PTHREAD_MUTEX_INITIALIZER)
 			pthread_mutex_init(mutex, 0);
 
-		(*mutex)->lock();
-
-		return 0;
+		return (*mutex)->lock();
 	}
 
 
@@ -506,9 +494,7 @@ extern "C" {
 		if (*mutex == PTHREAD_MUTEX_INITIALIZER)
 			pthread_mutex_init(mutex, 0);
 
-		(*mutex)->unlock();
-
-		return 0;
+		return (*mutex)->unlock();
 	}
 
 
@@ -516,19 +502,41 @@ extern "C" {
 
 
 	/*
-	 * Implementation based on
-	 * http://web.archive.org/web/20010914175514/http://www-classic.be.com/aboutbe/benewsletter/volume_III/Issue40.html#Workshop
+	 * Each waiter blocks at its own blockade. Signalling dequeues the
+	 * longest-waiting thread and unblocks it directly, without a handshake
+	 * with the woken thread. Signalling a condition variable without
+	 * waiters does not take any lock.
 	 */
 
 	struct pthread_cond
 	{
-		int num_waiters;
-		int num_signallers;
-		Lock counter_lock;
-		Timed_semaphore signal_sem;
-		Semaphore handshake_sem;
+		struct Waiter : Fifo<Waiter>::Element
+		{
+			Timed_semaphore blockade;
+			bool            signalled = false;
+		};
+
+		Lock         counter_lock;  /* protects 'waiters' */
+		Fifo<Waiter> waiters;
+		volatile int num_waiters;
+
+		pthread_cond() : num_waiters(0) { }
 
-		pthread_cond() : num_waiters(0), num_signallers(0) { }
+		/**
+		 * Wake up longest-waiting thread, must be called with
+		 * 'counter_lock' held
+		 */
+		bool wake_one()
+		{
+			Waiter *waiter = waiters.dequeue();
+			if (!waiter)
+				return false;
+
+			num_waiters--;
+			waiter->signalled = true;
+			waiter->blockade.up();
+			return true;
+		}
 	};
 
 
@@ -642,14 +650,18 @@ extern "C" {
 
 		pthread_cond *c = *cond;
 
-		c->counter_lock.lock();
-		c->num_waiters++;
-		c->counter_lock.unlock();
+		pthread_cond::Waiter waiter;
+
+		{
+			Lock::Guard guard(c->counter_lock);
+			c->waiters.enqueue(&waiter);
+			c->num_waiters++;
+		}
 
 		pthread_mutex_unlock(mutex);
 
 		if (!abstime)
-			c->signal_sem.down();
+			waiter.blockade.down();
 		else {
 			struct timespec currtime;
 			clock_gettime(CLOCK_REALTIME, &currtime);
@@ -657,24 +669,30 @@ extern "C" {
 			Alarm::Time timeout = timeout_ms(currtime, *abstime);
 
 			try {
-				c->signal_sem.down(timeout);
+				waiter.blockade.down(timeout);
 			} catch (Timeout_exception) {
 				result = ETIMEDOUT;
 			} catch (Genode::Nonblocking_exception) {
 				errno  = ETIMEDOUT;
 				result = ETIMEDOUT;
 			}
-		}
 
-		c->counter_lock.lock();
-		if (c->num_signallers > 0) {
-			if (result == ETIMEDOUT) /* timeout occured */
-				c->signal_sem.down();
-			c->handshake_sem.up();
-			--c->num_signallers;
+			if (result == ETIMEDOUT) {
+				Lock::Guard guard(c->counter_lock);
+
+				/*
+				 * If a signal raced with the timeout, the signaller already
+				 * dequeued us. Consume the wakeup instead of losing it.
+				 */
+				if (waiter.signalled) {
+					waiter.blockade.down();
+					result = 0;
+				} else {
+					c->waiters.remove(&waiter);
+					c->num_waiters--;
+				}
+			}
 		}
-		c->num_waiters--;
-		c->counter_lock.unlock();
 
 		pthread_mutex_lock(mutex);
 
@@ -696,16 +714,13 @@ extern "C" {
 
 		pthread_cond *c = *cond;
 
-		c->counter_lock.lock();
-		if (c->num_waiters > c->num_signallers) {
-		  ++c->num_signallers;
-		  c->signal_sem.up();
-		  c->counter_lock.unlock();
-		  c->handshake_sem.down();
-		} else
-		  c->counter_lock.unlock();
+		if (!c->num_waiters)
+			return 0;
 
-	   return 0;
+		Lock::Guard guard(c->counter_lock);
+		c->wake_one();
+
+		return 0;
 	}
 
 
@@ -716,21 +731,225 @@ extern "C" {
 
 		pthread_cond *c = *cond;
 
-		c->counter_lock.lock();
-		if (c->num_waiters > c->num_signallers) {
-			int still_waiting = c->num_waiters - c->num_signallers;
-			c->num_signallers = c->num_waiters;
-			for (int i = 0; i < still_waiting; i++)
-				c->signal_sem.up();
-			c->counter_lock.unlock();
-			for (int i = 0; i < still_waiting; i++)
-				c->handshake_sem.down();
-		} else
-			c->counter_lock.unlock();
+		if (!c->num_waiters)
+			return 0;
+
+		Lock::Guard guard(c->counter_lock);
+		while (c->wake_one());
+
+		return 0;
+	}
+
+
+	/* Reader-writer lock */
+
+
+	/*
+	 * The state word holds the number of readers or 'WRITER'. Uncontended
+	 * acquisitions and releases are a single atomic operation. Contended
+	 * threads block at their own blockade and retry after the lock became
+	 * free. Readers are preferred, which permits recursive read locking.
+	 */
+
+	struct pthread_rwlock
+	{
+		enum { WRITER = -1 };
+
+		struct Waiter : Fifo<Waiter>::Element
+		{
+			Lock blockade { Lock::LOCKED };
+		};
+
+		volatile int state       = 0;
+		volatile int num_waiters = 0;
+		Thread      *writer      = nullptr;
+		Lock         waiters_lock;  /* protects 'waiters' */
+		Fifo<Waiter> waiters;
+
+		bool try_rdlock()
+		{
+			for (;;) {
+				int const old = state;
+				if (old == WRITER)
+					return false;
+				if (cmpxchg(&state, old, old + 1))
+					return true;
+			}
+		}
+
+		bool try_wrlock()
+		{
+			if (!cmpxchg(&state, 0, WRITER))
+				return false;
+
+			writer = Thread::myself();
+			return true;
+		}
+
+		template <typename FN>
+		void acquire(FN const &try_acquire)
+		{
+			while (!try_acquire()) {
+
+				Waiter waiter;
+
+				{
+					Lock::Guard guard(waiters_lock);
+					waiters.enqueue(&waiter);
+
+					/*
+					 * The atomic update orders the announcement before the
+					 * re-check, which catches a release that happened
+					 * meanwhile.
+					 */
+					Lock_word::add(&num_waiters, 1);
+
+					if (try_acquire()) {
+						waiters.remove(&waiter);
+						Lock_word::add(&num_waiters, -1);
+						return;
+					}
+				}
+
+				waiter.blockade.lock();
+			}
+		}
+
+		int unlock()
+		{
+			if (state == WRITER) {
+				if (writer != Thread::myself())
+					return EPERM;
+
+				writer = nullptr;
+				cmpxchg(&state, WRITER, 0);
+
+			} else {
+				int old;
+				do {
+					old = state;
+					if (old <= 0)
+						return EPERM;
+				} while (!cmpxchg(&state, old, old - 1));
+
+				/* only the last reader releases the lock */
+				if (old > 1)
+					return 0;
+			}
+
+			/* wake up all waiters, they compete for the free lock */
+			if (num_waiters) {
+				Lock::Guard guard(waiters_lock);
+				while (Waiter *waiter = waiters.dequeue()) {
+					Lock_word::add(&num_waiters, -1);
+					waiter->blockade.unlock();
+				}
+			}
+			return 0;
+		}
+	};
+
+
+	int pthread_rwlock_init(pthread_rwlock_t *__restrict rwlock,
+	                        const pthread_rwlockattr_t *__restrict)
+	{
+		if (!rwlock)
+			return EINVAL;
+
+		*rwlock = new pthread_rwlock;
 
 		return 0;
 	}
 
+
+	int pthread_rwlock_destroy(pthread_rwlock_t *rwlock)
+	{
+		if (!rwlock || !*rwlock)
+			return EINVAL;
+
+		delete *rwlock;
+		*rwlock = 0;
+
+		return 0;
+	}
+
+
+	static pthread_rwlock *rwlock_object(pthread_rwlock_t *rwlock)
+	{
+		if (!rwlock)
+			return nullptr;
+
+		if (*rwlock)
+			return *rwlock;
+
+		/*
+		 * The rwlock was initialized via 'PTHREAD_RWLOCK_INITIALIZER'.
+		 * Threads using it for the first time may race for installing
+		 * the object. Only one object gets installed, the others are
+		 * freed. 'Genode::cmpxchg' covers 'int' values only, hence the
+		 * compiler builtin for exchanging the pointer.
+		 */
+		pthread_rwlock *l = new pthread_rwlock;
+		if (!__sync_bool_compare_and_swap(rwlock, (pthread_rwlock *)nullptr, l))
+			delete l;
+
+		return *rwlock;
+	}
+
+
+	int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
+	{
+		pthread_rwlock *l = rwlock_object(rwlock);
+		if (!l)
+			return EINVAL;
+
+		l->acquire([&] () { return l->try_rdlock(); });
+		return 0;
+	}
+
+
+	int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock)
+	{
+		pthread_rwlock *l = rwlock_object(rwlock);
+		if (!l)
+			return EINVAL;
+
+		if (l->state == pthread_rwlock::WRITER && l->writer == Thread::myself())
+			return EDEADLK;
+
+		l->acquire([&] () { return l->try_wrlock(); });
+		return 0;
+	}
+
+
+	int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
+	{
+		pthread_rwlock *l = rwlock_object(rwlock);
+		if (!l)
+			return EINVAL;
+
+		return l->try_rdlock() ? 0 : EBUSY;
+	}
+
+
+	int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
+	{
+		pthread_rwlock *l = rwlock_object(rwlock);
+		if (!l)
+			return EINVAL;
+
+		return l->try_wrlock() ? 0 : EBUSY;
+	}
+
+
+	int pthread_rwlock_unlock(pthread_rwlock_t *rwlock)
+	{
+		if (!rwlock || !*rwlock)
+			return EINVAL;
+
+		return (*rwlock)->unlock();
+	}
+
 	/* TLS */
 
 
@@ -0,0 +1,595 @@
+/*
+ * \brief  Benchmark of POSIX thread synchronization primitives
+ * \author Christian Prochaska
+ * \date   2017-07-10
+ *
+ * The benchmark measures uncontended mutex operations, mutexes and
+ * reader-writer locks contended by several threads, and the hand-over
+ * latency of condition variables. Each contended scenario also checks
+ * that the protected counter is consistent afterwards. Finally, the error
+ * codes of misused mutexes and reader-writer locks, recursive locking,
+ * and timed waits on condition variables are checked.
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+
+enum {
+	UNCONTENDED_OPS = 1000*1000,
+	CONTENDED_OPS   = 100*1000,   /* per thread */
+	PING_PONG_ROUNDS = 10*1000,
+	MAX_THREADS     = 4,
+	WRITE_RATIO     = 16,         /* one write per 16 reads */
+};
+
+
+static unsigned long now_ms()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000 + ts.tv_nsec/(1000*1000);
+}
+
+
+static void report(char const *name, unsigned long ops, unsigned long ms)
+{
+	printf("%-30s %8lu ops in %5lu ms", name, ops, ms);
+	if (ms)
+		printf(" (%lu ops/ms)", ops/ms);
+	printf("\n");
+}
+
+
+static void check(bool condition, char const *what)
+{
+	if (condition)
+		return;
+
+	printf("error: %s\n", what);
+	exit(-1);
+}
+
+
+/*
+ * Threads of a contended scenario
+ *
+ * The threads block on the start semaphore until all of them are created
+ * and report their completion via the done semaphore.
+ */
+
+struct Scenario
+{
+	sem_t start;
+	sem_t done;
+
+	pthread_mutex_t  mutex;
+	pthread_rwlock_t rwlock;
+
+	unsigned long volatile counter = 0;
+	unsigned long volatile reads   = 0;
+
+	Scenario()
+	{
+		sem_init(&start, 0, 0);
+		sem_init(&done,  0, 0);
+		pthread_mutex_init(&mutex, 0);
+		pthread_rwlock_init(&rwlock, 0);
+	}
+
+	~Scenario()
+	{
+		pthread_rwlock_destroy(&rwlock);
+		pthread_mutex_destroy(&mutex);
+		sem_destroy(&done);
+		sem_destroy(&start);
+	}
+
+	/**
+	 * Run 'func' in 'num_threads' threads and return the duration in ms
+	 */
+	unsigned long run(void *(*func)(void *), unsigned num_threads)
+	{
+		for (unsigned i = 0; i < num_threads; i++) {
+			pthread_t t;
+			check(pthread_create(&t, 0, func, this) == 0, "pthread_create failed");
+		}
+
+		unsigned long const start_ms = now_ms();
+
+		for (unsigned i = 0; i < num_threads; i++)
+			sem_post(&start);
+		for (unsigned i = 0; i < num_threads; i++)
+			sem_wait(&done);
+
+		return now_ms() - start_ms;
+	}
+};
+
+
+static void *mutex_thread(void *arg)
+{
+	Scenario &s = *(Scenario *)arg;
+
+	sem_wait(&s.start);
+
+	for (unsigned i = 0; i < CONTENDED_OPS; i++) {
+		pthread_mutex_lock(&s.mutex);
+		s.counter++;
+		pthread_mutex_unlock(&s.mutex);
+	}
+
+	sem_post(&s.done);
+	return 0;
+}
+
+
+static void *rwlock_thread(void *arg)
+{
+	Scenario &s = *(Scenario *)arg;
+
+	sem_wait(&s.start);
+
+	for (unsigned i = 0; i < CONTENDED_OPS; i++) {
+		if (i % WRITE_RATIO == 0) {
+			pthread_rwlock_wrlock(&s.rwlock);
+			s.counter++;
+			pthread_rwlock_unlock(&s.rwlock);
+		} else {
+			pthread_rwlock_rdlock(&s.rwlock);
+			unsigned long const value = s.counter;
+			(void)value;
+			pthread_rwlock_unlock(&s.rwlock);
+		}
+	}
+
+	sem_post(&s.done);
+	return 0;
+}
+
+
+static void bench_uncontended(int type, char const *name)
+{
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, type);
+
+	pthread_mutex_t mutex;
+	pthread_mutex_init(&mutex, &attr);
+
+	unsigned long const start_ms = now_ms();
+
+	for (unsigned i = 0; i < UNCONTENDED_OPS; i++) {
+		pthread_mutex_lock(&mutex);
+		pthread_mutex_unlock(&mutex);
+	}
+
+	report(name, UNCONTENDED_OPS, now_ms() - start_ms);
+
+	check(pthread_mutex_trylock(&mutex) == 0, "trylock of free mutex failed");
+	pthread_mutex_unlock(&mutex);
+
+	pthread_mutex_destroy(&mutex);
+	pthread_mutexattr_destroy(&attr);
+}
+
+
+static void bench_contended_mutex(unsigned num_threads)
+{
+	Scenario s;
+	unsigned long const ms = s.run(mutex_thread, num_threads);
+
+	char name[32];
+	snprintf(name, sizeof(name), "mutex, %u threads", num_threads);
+	report(name, num_threads*CONTENDED_OPS, ms);
+
+	check(s.counter == num_threads*CONTENDED_OPS, "mutex counter mismatch");
+}
+
+
+static void bench_contended_rwlock(unsigned num_threads)
+{
+	Scenario s;
+	unsigned long const ms = s.run(rwlock_thread, num_threads);
+
+	char name[32];
+	snprintf(name, sizeof(name), "rwlock, %u threads", num_threads);
+	report(name, num_threads*CONTENDED_OPS, ms);
+
+	unsigned long const writes = (CONTENDED_OPS + WRITE_RATIO - 1) / WRITE_RATIO;
+	check(s.counter == num_threads*writes, "rwlock counter mismatch");
+}
+
+
+/*
+ * Condition-variable ping pong
+ *
+ * Two threads hand a token back and forth. Each hand-over consists of a
+ * signal and a wakeup of the blocked partner.
+ */
+
+struct Ping_pong
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+	unsigned        turn = 0;
+	sem_t           done;
+
+	Ping_pong()
+	{
+		pthread_mutex_init(&mutex, 0);
+		pthread_cond_init(&cond, 0);
+		sem_init(&done, 0, 0);
+	}
+
+	void play(unsigned me)
+	{
+		pthread_mutex_lock(&mutex);
+		for (unsigned i = 0; i < PING_PONG_ROUNDS; i++) {
+			while (turn % 2 != me)
+				pthread_cond_wait(&cond, &mutex);
+			turn++;
+			pthread_cond_signal(&cond);
+		}
+		pthread_mutex_unlock(&mutex);
+	}
+};
+
+
+static void *pong_thread(void *arg)
+{
+	Ping_pong &p = *(Ping_pong *)arg;
+	p.play(1);
+	sem_post(&p.done);
+	return 0;
+}
+
+
+static void bench_cond_ping_pong()
+{
+	Ping_pong p;
+
+	pthread_t t;
+	check(pthread_create(&t, 0, pong_thread, &p) == 0, "pthread_create failed");
+
+	unsigned long const start_ms = now_ms();
+	p.play(0);
+	sem_wait(&p.done);
+
+	report("cond ping pong", 2*PING_PONG_ROUNDS, now_ms() - start_ms);
+
+	check(p.turn == 2*PING_PONG_ROUNDS, "ping-pong turn mismatch");
+}
+
+
+static void bench_cond_signal_no_waiter()
+{
+	pthread_cond_t cond;
+	pthread_cond_init(&cond, 0);
+
+	unsigned long const start_ms = now_ms();
+
+	for (unsigned i = 0; i < UNCONTENDED_OPS; i++)
+		pthread_cond_signal(&cond);
+
+	report("cond signal, no waiter", UNCONTENDED_OPS, now_ms() - start_ms);
+
+	pthread_cond_destroy(&cond);
+}
+
+
+/**
+ * Execute 'fn' in another thread and wait for its completion
+ */
+template <typename FN>
+static void in_other_thread(FN const &fn)
+{
+	struct Call
+	{
+		FN const &fn;
+		sem_t     done;
+
+		Call(FN const &fn) : fn(fn) { sem_init(&done, 0, 0); }
+		~Call() { sem_destroy(&done); }
+
+		static void *entry(void *arg)
+		{
+			Call &call = *(Call *)arg;
+			call.fn();
+			sem_post(&call.done);
+			return 0;
+		}
+	} call(fn);
+
+	pthread_t t;
+	check(pthread_create(&t, 0, Call::entry, &call) == 0, "pthread_create failed");
+	sem_wait(&call.done);
+}
+
+
+static void test_mutex_errorcheck()
+{
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK);
+
+	pthread_mutex_t mutex;
+	pthread_mutex_init(&mutex, &attr);
+
+	check(pthread_mutex_lock(&mutex) == 0, "errorcheck lock failed");
+	check(pthread_mutex_lock(&mutex) == EDEADLK,
+	      "errorcheck relock did not return EDEADLK");
+	check(pthread_mutex_trylock(&mutex) == EDEADLK,
+	      "errorcheck trylock by owner did not return EDEADLK");
+
+	int other_unlock = 0, other_trylock = 0;
+	in_other_thread([&] () {
+		other_unlock  = pthread_mutex_unlock(&mutex);
+		other_trylock = pthread_mutex_trylock(&mutex); });
+	check(other_unlock == EPERM, "errorcheck unlock by non-owner did not return EPERM");
+	check(other_trylock == EBUSY, "errorcheck trylock of locked mutex did not return EBUSY");
+
+	check(pthread_mutex_unlock(&mutex) == 0, "errorcheck unlock failed");
+	check(pthread_mutex_unlock(&mutex) == EPERM,
+	      "errorcheck unlock of free mutex did not return EPERM");
+
+	pthread_mutex_destroy(&mutex);
+	pthread_mutexattr_destroy(&attr);
+}
+
+
+static void test_mutex_recursive()
+{
+	enum { DEPTH = 3 };
+
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+
+	pthread_mutex_t mutex;
+	pthread_mutex_init(&mutex, &attr);
+
+	int other = 0;
+	auto other_trylock = [&] () -> int {
+		in_other_thread([&] () {
+			other = pthread_mutex_trylock(&mutex);
+			if (other == 0)
+				pthread_mutex_unlock(&mutex); });
+		return other;
+	};
+
+	check(pthread_mutex_lock(&mutex) == 0, "recursive lock failed");
+	for (unsigned i = 1; i < DEPTH; i++)
+		check(pthread_mutex_trylock(&mutex) == 0, "recursive trylock by owner failed");
+
+	/* the mutex stays locked until the last unlock */
+	for (unsigned i = 0; i < DEPTH; i++) {
+		check(other_trylock() == EBUSY, "recursive mutex released too early");
+		check(pthread_mutex_unlock(&mutex) == 0, "recursive unlock failed");
+	}
+	check(other_trylock() == 0, "recursive mutex not released after last unlock");
+	check(pthread_mutex_unlock(&mutex) == EPERM,
+	      "recursive unlock of free mutex did not return EPERM");
+
+	pthread_mutex_destroy(&mutex);
+	pthread_mutexattr_destroy(&attr);
+}
+
+
+static void test_rwlock_errors()
+{
+	pthread_rwlock_t rwlock;
+	pthread_rwlock_init(&rwlock, 0);
+
+	check(pthread_rwlock_wrlock(&rwlock) == 0, "wrlock failed");
+	check(pthread_rwlock_wrlock(&rwlock) == EDEADLK,
+	      "wrlock by writer did not return EDEADLK");
+
+	int other_unlock = 0, other_tryrdlock = 0;
+	in_other_thread([&] () {
+		other_unlock    = pthread_rwlock_unlock(&rwlock);
+		other_tryrdlock = pthread_rwlock_tryrdlock(&rwlock); });
+	check(other_unlock == EPERM, "rwlock unlock by non-writer did not return EPERM");
+	check(other_tryrdlock == EBUSY, "tryrdlock of write-locked rwlock did not return EBUSY");
+
+	check(pthread_rwlock_unlock(&rwlock) == 0, "rwlock unlock failed");
+	check(pthread_rwlock_unlock(&rwlock) == EPERM,
+	      "unlock of free rwlock did not return EPERM");
+
+	/* readers share the lock and exclude writers */
+	check(pthread_rwlock_rdlock(&rwlock) == 0, "rdlock failed");
+	check(pthread_rwlock_tryrdlock(&rwlock) == 0, "second rdlock failed");
+	check(pthread_rwlock_trywrlock(&rwlock) == EBUSY,
+	      "trywrlock of read-locked rwlock did not return EBUSY");
+	check(pthread_rwlock_unlock(&rwlock) == 0, "rwlock reader unlock failed");
+	check(pthread_rwlock_unlock(&rwlock) == 0, "rwlock reader unlock failed");
+
+	pthread_rwlock_destroy(&rwlock);
+}
+
+
+/*
+ * Waiter of the timed-wait tests
+ *
+ * The waiter announces that it is waiting while holding the mutex. Once the
+ * signaller observes the announcement with the mutex held, the waiter is
+ * enqueued at the condition variable.
+ */
+
+struct Timed_waiter
+{
+	enum { MAX_WAIT_MS = 1000 };
+
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+
+	bool volatile waiting = false;
+	bool volatile woken   = false;
+	int  volatile result  = 0;
+
+	unsigned timeout_ms = 0;   /* zero for waiting without timeout */
+
+	Timed_waiter()
+	{
+		pthread_mutex_init(&mutex, 0);
+		pthread_cond_init(&cond, 0);
+	}
+
+	~Timed_waiter()
+	{
+		pthread_cond_destroy(&cond);
+		pthread_mutex_destroy(&mutex);
+	}
+
+	static void *entry(void *arg)
+	{
+		Timed_waiter &w = *(Timed_waiter *)arg;
+
+		pthread_mutex_lock(&w.mutex);
+		w.waiting = true;
+
+		if (w.timeout_ms) {
+			struct timespec abstime;
+			clock_gettime(CLOCK_REALTIME, &abstime);
+			abstime.tv_nsec += w.timeout_ms*1000*1000;
+			abstime.tv_sec  += abstime.tv_nsec / (1000*1000*1000);
+			abstime.tv_nsec %= 1000*1000*1000;
+			w.result = pthread_cond_timedwait(&w.cond, &w.mutex, &abstime);
+		} else {
+			w.result = pthread_cond_wait(&w.cond, &w.mutex);
+		}
+
+		w.waiting = false;
+		w.woken   = true;
+		pthread_mutex_unlock(&w.mutex);
+		return 0;
+	}
+
+	/**
+	 * Start waiter thread and return once it waits, with the mutex held
+	 */
+	void start()
+	{
+		waiting = woken = false;
+
+		pthread_t t;
+		check(pthread_create(&t, 0, entry, this) == 0, "pthread_create failed");
+
+		for (;;) {
+			pthread_mutex_lock(&mutex);
+			if (waiting)
+				return;
+			pthread_mutex_unlock(&mutex);
+			usleep(100);
+		}
+	}
+
+	/**
+	 * Return true if the waiter returns within 'MAX_WAIT_MS'
+	 */
+	bool returned()
+	{
+		for (unsigned i = 0; i < MAX_WAIT_MS && !woken; i++)
+			usleep(1000);
+
+		/* serialize with the final unlock of the waiter */
+		pthread_mutex_lock(&mutex);
+		pthread_mutex_unlock(&mutex);
+		return woken;
+	}
+};
+
+
+static void test_cond_timeout()
+{
+	enum { RACE_ROUNDS = 200 };
+
+	Timed_waiter w;
+
+	/* a timed wait without signal times out */
+	w.timeout_ms = 10;
+	w.start();
+	pthread_mutex_unlock(&w.mutex);
+	check(w.returned(), "timed wait did not return");
+	check(w.result == ETIMEDOUT, "timed wait did not time out");
+
+	/* the timed-out waiter must not absorb a later signal */
+	w.timeout_ms = 0;
+	w.start();
+	pthread_cond_signal(&w.cond);
+	pthread_mutex_unlock(&w.mutex);
+	check(w.returned(), "signal after timed-out wait got lost");
+	check(w.result == 0, "wait did not return 0 after signal");
+
+	/*
+	 * Signal at about the time the waiter times out. Each round must end
+	 * either with a consumed signal or a timeout. In the latter case, the
+	 * signal found no waiter and a subsequent waiter must still be woken
+	 * by the next signal.
+	 */
+	unsigned signalled = 0, timed_out = 0;
+	for (unsigned i = 0; i < RACE_ROUNDS; i++) {
+
+		w.timeout_ms = 1;
+		w.start();
+		pthread_mutex_unlock(&w.mutex);
+		usleep((i % 3)*500);
+
+		pthread_mutex_lock(&w.mutex);
+		pthread_cond_signal(&w.cond);
+		pthread_mutex_unlock(&w.mutex);
+
+		check(w.returned(), "timed wait racing with signal did not return");
+		check(w.result == 0 || w.result == ETIMEDOUT,
+		      "timed wait racing with signal returned unexpected result");
+
+		if (w.result == 0) signalled++; else timed_out++;
+
+		w.timeout_ms = 0;
+		w.start();
+		pthread_cond_signal(&w.cond);
+		pthread_mutex_unlock(&w.mutex);
+		check(w.returned(), "signal got lost after racing timed wait");
+	}
+	printf("cond signal vs. timeout: %u signalled, %u timed out\n",
+	       signalled, timed_out);
+}
+
+
+int main(int argc, char **argv)
+{
+	printf("--- pthread benchmark ---\n");
+
+	bench_uncontended(PTHREAD_MUTEX_NORMAL,     "mutex normal, uncontended");
+	bench_uncontended(PTHREAD_MUTEX_RECURSIVE,  "mutex recursive, uncontended");
+	bench_uncontended(PTHREAD_MUTEX_ERRORCHECK, "mutex errorcheck, uncontended");
+
+	for (unsigned n = 2; n <= MAX_THREADS; n *= 2)
+		bench_contended_mutex(n);
+
+	for (unsigned n = 2; n <= MAX_THREADS; n *= 2)
+		bench_contended_rwlock(n);
+
+	bench_cond_signal_no_waiter();
+	bench_cond_ping_pong();
+	test_cond_timeout();
+
+	test_mutex_errorcheck();
+	test_mutex_recursive();
+	test_rwlock_errors();
+
+	printf("--- pthread benchmark finished ---\n");
+	return 0;
+}
@@ -0,0 +1,3 @@
+TARGET   = test-pthread_bench
+SRC_CC   = main.cc
+LIBS     = posix pthread
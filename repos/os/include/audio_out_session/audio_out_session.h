@@ -51,9 +51,19 @@ namespace Audio_out {
 	enum {
 		QUEUE_SIZE  = 256,           /* buffer queue size */
 		PERIOD      = 512,           /* samples per period (~11.6ms) */
+		MIN_PERIOD  = 64,            /* smallest negotiable period (~1.5ms) */
 		SAMPLE_RATE = 44100,
 		SAMPLE_SIZE = sizeof(float),
 	};
+
+	/**
+	 * Return true if 'period' is a power of two within [MIN_PERIOD, PERIOD]
+	 */
+	inline bool valid_period(unsigned period)
+	{
+		return period >= MIN_PERIOD && period <= PERIOD
+		    && !(period & (period - 1));
+	}
 }
 
 
@@ -154,6 +164,7 @@ class Audio_out::Stream
 
 		unsigned  _pos;             /* current playback position */
 		unsigned  _tail;            /* tail pointer used for allocations */
+		unsigned  _period;          /* samples per packet, zero means 'PERIOD' */
 		Packet    _buf[QUEUE_SIZE]; /* packet queue */
 
 	public:
@@ -177,6 +188,16 @@ class Audio_out::Stream
 		 */
 		unsigned tail() const { return _tail; }
 
+		/**
+		 * Number of samples per packet
+		 *
+		 * Only the first 'period()' samples of a packet are played. The
+		 * period is the one requested by the client at session creation.
+		 * A server that does not provide the requested period denies the
+		 * session.
+		 */
+		unsigned period() const { return _period ? _period : (unsigned)PERIOD; }
+
 		/**
 		 * Number of packets between playback and allocation position
 		 *
@@ -291,6 +312,11 @@ class Audio_out::Stream
 		 * Increment current stream position by one
 		 */
 		void increment_position() { _pos = (_pos + 1) % QUEUE_SIZE; }
+
+		/**
+		 * Set number of samples per packet
+		 */
+		void period(unsigned p) { _period = p; }
 };
 
 
@@ -28,10 +28,11 @@ struct Audio_out::Connection : Genode::Connection<Session>, Audio_out::Session_c
 	 *
 	 * \noapi
 	 */
-	Capability<Audio_out::Session> _session(Genode::Parent &parent, char const *channel)
+	Capability<Audio_out::Session> _session(Genode::Parent &parent, char const *channel,
+	                                        unsigned period = PERIOD)
 	{
-		return session(parent, "ram_quota=%ld, cap_quota=%ld, channel=\"%s\"",
-		               2*4096 + 2048 + sizeof(Stream), CAP_QUOTA, channel);
+		return session(parent, "ram_quota=%ld, cap_quota=%ld, channel=\"%s\", period=%u",
+		               2*4096 + 2048 + sizeof(Stream), CAP_QUOTA, channel, period);
 	}
 
 	/**
@@ -43,13 +44,17 @@ struct Audio_out::Connection : Genode::Connection<Session>, Audio_out::Session_c
 	 * \param progress_signal  install progress signal, the client may then
 	 *                         call 'wait_for_progress', which is sent when the
 	 *                         server processed one or more packets
+	 * \param period           number of samples per packet, the session
+	 *                         is denied if the server does not provide
+	 *                         this period
 	 */
 	Connection(Genode::Env &env,
 	           char const  *channel,
 	           bool         alloc_signal = true,
-	           bool         progress_signal = false)
+	           bool         progress_signal = false,
+	           unsigned     period = PERIOD)
 	:
-		Genode::Connection<Session>(env, _session(env.parent(), channel)),
+		Genode::Connection<Session>(env, _session(env.parent(), channel, period)),
 		Session_client(env.rm(), cap(), alloc_signal, progress_signal)
 	{ }
 
@@ -74,8 +74,10 @@ class Block::Session_component : public Block::Session_component_base,
 		Signal_handler<Session_component> _sink_submit;
 		bool                              _req_queue_full;
 		bool                              _ack_queue_full;
+		bool                              _queue_depth_reached;
 		Packet_descriptor                 _p_to_handle;
 		unsigned                          _p_in_fly;
+		unsigned const                    _queue_depth;
 
 		/**
 		 * Acknowledge a packet already handled
@@ -159,11 +161,18 @@ class Block::Session_component : public Block::Session_component_base,
 			 * them, and the driver's request queue isn't full,
 			 * direct the packet request to the driver backend
 			 */
-			for (_ack_queue_full = (_p_in_fly >= tx_sink()->ack_slots_free());
-			     !_req_queue_full && !_ack_queue_full
-			     && tx_sink()->packet_avail();
-				 _ack_queue_full = (++_p_in_fly >= tx_sink()->ack_slots_free()))
+			for (;;) {
+				_ack_queue_full      = (_p_in_fly >= tx_sink()->ack_slots_free());
+				_queue_depth_reached = (_p_in_fly >= _queue_depth);
+
+				if (_req_queue_full || _ack_queue_full || _queue_depth_reached
+				 || !tx_sink()->packet_avail())
+					return;
+
+				/* account the packet before the driver may acknowledge it */
+				_p_in_fly++;
 				_handle_packet(tx_sink()->get_packet());
+			}
 		}
 
 	public:
@@ -185,7 +194,10 @@ class Block::Session_component : public Block::Session_component_base,
 		  _sink_ack(ep, *this, &Session_component::_signal),
 		  _sink_submit(ep, *this, &Session_component::_signal),
 		  _req_queue_full(false),
-		  _p_in_fly(0)
+		  _ack_queue_full(false),
+		  _queue_depth_reached(false),
+		  _p_in_fly(0),
+		  _queue_depth(max(1U, _driver.queue_depth()))
 		{
 			_tx.sigh_ready_to_ack(_sink_ack);
 			_tx.sigh_packet_avail(_sink_submit);
@@ -208,7 +220,7 @@ class Block::Session_component : public Block::Session_component_base,
 			packet.succeeded(success);
 			_ack_packet(packet);
 
-			if (!_req_queue_full && !_ack_queue_full)
+			if (!_req_queue_full && !_ack_queue_full && !_queue_depth_reached)
 				return;
 
 			/*
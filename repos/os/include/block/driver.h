@@ -78,6 +78,13 @@ class Block::Driver_session : public Driver_session_base,
 
 /**
  * Interface to be implemented by the device-specific driver code
+ *
+ * A driver may complete requests asynchronously. The packet descriptor
+ * passed to 'read', 'write', 'read_dma', and 'write_dma' identifies the
+ * request and must be handed back via 'ack_packet' once the request is
+ * completed. Requests may be acknowledged in any order. The number of
+ * requests that are handed to the driver at the same time is bounded by
+ * 'queue_depth'.
  */
 class Block::Driver
 {
@@ -193,6 +200,16 @@ class Block::Driver
 		                       Packet_descriptor &packet) {
 			throw Io_error(); }
 
+		/**
+		 * Request maximum number of requests in flight
+		 *
+		 * The session component does not hand out more requests to the
+		 * driver than this number. Drivers with a limited number of
+		 * request slots should override this method instead of throwing
+		 * 'Request_congestion' for each request that exceeds the limit.
+		 */
+		virtual unsigned queue_depth() { return ~0U; }
+
 		/**
 		 * Check if DMA is enabled for driver
 		 *
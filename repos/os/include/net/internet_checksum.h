@@ -0,0 +1,101 @@
+/*
+ * \brief  Internet checksum (RFC 1071) and its incremental update (RFC 1624)
+ * \author agent
+ * \date   2026-10-18
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _NET__INTERNET_CHECKSUM_H_
+#define _NET__INTERNET_CHECKSUM_H_
+
+/* Genode includes */
+#include <base/stdint.h>
+
+namespace Net {
+
+	/**
+	 * Add data to a partial one's-complement sum
+	 *
+	 * \param data  start of the data, must be located at an even offset
+	 *              of the checksummed byte stream
+	 * \param size  size of the data in bytes, an odd trailing byte gets
+	 *              padded with zero
+	 * \param sum   partial sum of the preceding parts of the byte stream
+	 *
+	 * \return  partial sum that covers the preceding parts and 'data'
+	 *
+	 * The data is interpreted as a sequence of 16-bit words in network byte
+	 * order. Internally, the data is summed up machine-word-wise in host byte
+	 * order, which yields the same result because the one's-complement sum
+	 * is independent of the byte order (RFC 1071, section 2 B).
+	 */
+	Genode::uint32_t internet_checksum_add(void const       *data,
+	                                       Genode::size_t    size,
+	                                       Genode::uint32_t  sum = 0);
+
+	/**
+	 * Fold the carries of a partial sum into its lower 16 bits
+	 */
+	inline Genode::uint16_t internet_checksum_fold(Genode::uint32_t sum)
+	{
+		while (sum >> 16) {
+			sum = (sum & 0xffff) + (sum >> 16); }
+
+		return sum;
+	}
+
+	/**
+	 * Return the internet checksum of data, optionally prefixed by a
+	 * partial sum, e.g., of a pseudo header
+	 */
+	inline Genode::uint16_t internet_checksum(void const       *data,
+	                                          Genode::size_t    size,
+	                                          Genode::uint32_t  sum = 0)
+	{
+		return ~internet_checksum_fold(internet_checksum_add(data, size, sum));
+	}
+
+	/**
+	 * Update a checksum after a 16-bit word of the data has changed
+	 *
+	 * Implements equation 3 of RFC 1624: HC' = ~(~HC + ~m + m')
+	 */
+	inline Genode::uint16_t internet_checksum_update(Genode::uint16_t checksum,
+	                                                 Genode::uint16_t old_word,
+	                                                 Genode::uint16_t new_word)
+	{
+		Genode::uint32_t const sum = (Genode::uint16_t)~checksum +
+		                             (Genode::uint16_t)~old_word + new_word;
+
+		return ~internet_checksum_fold(sum);
+	}
+
+	/**
+	 * Update a checksum after a sequence of 16-bit words has changed
+	 *
+	 * \param old_data  previous content of the sequence
+	 * \param new_data  new content of the sequence
+	 * \param size      size of the sequence in bytes, must be even
+	 */
+	inline Genode::uint16_t internet_checksum_update(Genode::uint16_t  checksum,
+	                                                 void       const *old_data,
+	                                                 void       const *new_data,
+	                                                 Genode::size_t    size)
+	{
+		Genode::uint16_t const old_sum =
+			internet_checksum_fold(internet_checksum_add(old_data, size));
+
+		Genode::uint16_t const new_sum =
+			internet_checksum_fold(internet_checksum_add(new_data, size));
+
+		return internet_checksum_update(checksum, old_sum, new_sum);
+	}
+}
+
+#endif /* _NET__INTERNET_CHECKSUM_H_ */
@@ -20,6 +20,7 @@
 #include <util/endian.h>
 #include <net/ethernet.h>
 #include <net/ipv4.h>
+#include <net/internet_checksum.h>
 #include <util/register.h>
 #include <net/port.h>
 
@@ -79,9 +80,12 @@ class Net::Tcp_packet
 		void src_port(Port p) { _src_port = host_to_big_endian(p.value); }
 		void dst_port(Port p) { _dst_port = host_to_big_endian(p.value); }
 
+		void checksum(uint16_t c) { _checksum = host_to_big_endian(c); }
+
 		Port src_port()  const { return Port(host_to_big_endian(_src_port)); }
 		Port dst_port()  const { return Port(host_to_big_endian(_dst_port)); }
 		uint16_t flags() const { return host_to_big_endian(_flags); }
+		uint16_t checksum() const { return host_to_big_endian(_checksum); }
 
 		Tcp_packet(size_t size) {
 			if (size < sizeof(Tcp_packet)) { throw No_tcp_packet(); } }
@@ -105,31 +109,12 @@ class Net::Tcp_packet
 			_checksum = 0;
 
 			/* sum up pseudo header */
-			uint32_t sum = 0;
-			for (size_t i = 0; i < Ipv4_packet::ADDR_LEN; i += sizeof(uint16_t)) {
-				uint16_t s = ip_src.addr[i] << 8 | ip_src.addr[i + 1];
-				uint16_t d = ip_dst.addr[i] << 8 | ip_dst.addr[i + 1];
-				sum += s + d;
-			}
-			uint8_t prot[] = { 0, IP_ID };
-			sum += host_to_big_endian(*(uint16_t *)&prot) + tcp_size;
+			uint32_t sum = internet_checksum_add(ip_src.addr, Ipv4_packet::ADDR_LEN);
+			sum = internet_checksum_add(ip_dst.addr, Ipv4_packet::ADDR_LEN, sum);
+			sum += IP_ID + tcp_size;
 
 			/* sum up TCP packet itself */
-			size_t max = (tcp_size & 1) ? (tcp_size - 1) : tcp_size;
-			uint16_t * tcp = (uint16_t *)this;
-			for (size_t i = 0; i < max; i = i + sizeof(*tcp)) {
-				sum += host_to_big_endian(*tcp++); }
-
-			/* if TCP size is odd, append a zero byte */
-			if (tcp_size & 1) {
-				uint8_t last[] = { *((uint8_t *)this + (tcp_size - 1)), 0 };
-				sum += host_to_big_endian(*(uint16_t *)&last);
-			}
-			/* keep the last 16 bits of the 32 bit sum and add the carries */
-			while (sum >> 16) { sum = (sum & 0xffff) + (sum >> 16); }
-
-			/* one's complement of sum */
-			_checksum = host_to_big_endian((uint16_t)~sum);
+			_checksum = host_to_big_endian(internet_checksum(this, tcp_size, sum));
 		}
 
 		/**
@@ -32,14 +32,36 @@ class File_system::Directory : public Node
 		List<Node> _entries;
 		size_t     _num_entries;
 
+		/*
+		 * Position of the most recent 'entry_unsynchronized' lookup
+		 *
+		 * A sequential traversal of the directory continues from the
+		 * cursor instead of walking the list from the start. The cursor is
+		 * reset whenever the list of entries changes.
+		 */
+		Node   *_cursor_node  = nullptr;
+		size_t  _cursor_index = 0;
+
 	public:
 
 		Directory(char const *name) : _num_entries(0) { Node::name(name); }
 
 		Node *entry_unsynchronized(size_t index)
 		{
-			Node *node = _entries.first();
-			for (unsigned i = 0; i < index && node; node = node->next(), i++);
+			Node  *node = _entries.first();
+			size_t i    = 0;
+
+			if (_cursor_node && _cursor_index <= index) {
+				node = _cursor_node;
+				i    = _cursor_index;
+			}
+
+			for (; i < index && node; node = node->next(), i++);
+
+			if (node) {
+				_cursor_node  = node;
+				_cursor_index = index;
+			}
 			return node;
 		}
 
@@ -60,6 +82,7 @@ class File_system::Directory : public Node
 			 */
 			_entries.insert(node);
 			_num_entries++;
+			_cursor_node = nullptr;
 
 			mark_as_updated();
 		}
@@ -68,6 +91,7 @@ class File_system::Directory : public Node
 		{
 			_entries.remove(node);
 			_num_entries--;
+			_cursor_node = nullptr;
 
 			mark_as_updated();
 		}
@@ -201,21 +225,28 @@ class File_system::Directory : public Node
 
 			Node *node = entry_unsynchronized(index);
 
-			/* index out of range */
-			if (!node)
-				return 0;
+			/* fill the buffer with as many consecutive entries as fit */
+			size_t n = 0;
+			for (; node && len - n >= sizeof(Directory_entry);
+			     node = node->next(), index++) {
 
-			Directory_entry *e = (Directory_entry *)(dst);
+				Directory_entry *e = (Directory_entry *)(dst + n);
 
-			e->inode = node->inode();
+				e->inode = node->inode();
 
-			if (dynamic_cast<File      *>(node)) e->type = Directory_entry::TYPE_FILE;
-			if (dynamic_cast<Directory *>(node)) e->type = Directory_entry::TYPE_DIRECTORY;
-			if (dynamic_cast<Symlink   *>(node)) e->type = Directory_entry::TYPE_SYMLINK;
+				if (dynamic_cast<File      *>(node)) e->type = Directory_entry::TYPE_FILE;
+				if (dynamic_cast<Directory *>(node)) e->type = Directory_entry::TYPE_DIRECTORY;
+				if (dynamic_cast<Symlink   *>(node)) e->type = Directory_entry::TYPE_SYMLINK;
 
-			strncpy(e->name, node->name(), sizeof(e->name));
+				strncpy(e->name, node->name(), sizeof(e->name));
+
+				n += sizeof(Directory_entry);
+
+				_cursor_node  = node;
+				_cursor_index = index;
+			}
 
-			return sizeof(Directory_entry);
+			return n;
 		}
 
 		size_t write(char const *src, size_t len, seek_off_t seek_offset)
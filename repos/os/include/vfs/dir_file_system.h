@@ -17,6 +17,7 @@
 #define _INCLUDE__VFS__DIR_FILE_SYSTEM_H_
 
 #include <vfs/file_system_factory.h>
+#include <vfs/path_cache.h>
 #include <vfs/vfs_handle.h>
 
 
@@ -31,6 +32,8 @@ class Vfs::Dir_file_system : public File_system
 
 	private:
 
+		typedef Path_cache::Resolution Resolution;
+
 		/* pointer to first child file system */
 		File_system *_first_file_system;
 
@@ -56,6 +59,184 @@ class Vfs::Dir_file_system : public File_system
 
 		bool _root() const { return _name[0] == 0; }
 
+		/**
+		 * Cache of path lookups, present in the root directory only
+		 *
+		 * The cache is configured via the 'path_cache' attribute (number
+		 * of cached paths, 0 by default, which disables the cache) and the
+		 * 'stat_cache_ttl_ms' attribute (time to live of cached 'stat'
+		 * results and failed lookups, 0 disables caching them) of the
+		 * '<vfs>' node.
+		 */
+		Genode::Constructible<Path_cache> _cache;
+
+		static bool _dir_fs(File_system &fs) { return !strcmp(fs.type(), "dir"); }
+
+		static Dir_file_system &_dir(File_system &fs) {
+			return static_cast<Dir_file_system &>(fs); }
+
+		/**
+		 * Stat 'path' and record the file system that provides it
+		 *
+		 * \param full  path as passed to the root directory, used for
+		 *              determining the offset of the path local to the
+		 *              providing file system
+		 * \param res   resolution, left untouched if 'path' refers to a
+		 *              directory node of the static configuration
+		 */
+		Stat_result _stat(char const *path, Stat &out,
+		                  char const *full, Resolution &res)
+		{
+			path = _sub_path(path);
+
+			/* path does not match directory name */
+			if (!path)
+				return STAT_ERR_NO_ENTRY;
+
+			/*
+			 * If path equals directory name, return information about the
+			 * current directory.
+			 */
+			if (strlen(path) == 0 || (strcmp(path, "/") == 0)) {
+				out.size   = 0;
+				out.mode   = STAT_MODE_DIRECTORY | 0755;
+				out.uid    = 0;
+				out.gid    = 0;
+				out.inode  = 1;
+				out.device = (Genode::addr_t)this;
+				return STAT_OK;
+			}
+
+			/*
+			 * The given path refers to one of our sub directories.
+			 * Propagate the request into our file systems.
+			 */
+			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
+
+				bool const dir_fs = _dir_fs(*fs);
+
+				Stat_result const err = dir_fs
+				                      ? _dir(*fs)._stat(path, out, full, res)
+				                      : fs->stat(path, out);
+
+				if (err == STAT_OK) {
+					if (!dir_fs) {
+						res.fs        = fs;
+						res.offset    = path - full;
+						res.directory = (out.mode & STAT_MODE_DIRECTORY) != 0;
+					}
+					return err;
+				}
+
+				if (err != STAT_ERR_NO_ENTRY)
+					return err;
+
+				/* 'fs' may provide the path later, shadowing the next ones */
+				if (!dir_fs || _dir(*fs)._sub_path(path))
+					res.first_layer = false;
+			}
+
+			/* none of our file systems felt responsible for the path */
+			return STAT_ERR_NO_ENTRY;
+		}
+
+		/**
+		 * Open non-directory 'path' and record the file system that
+		 * provides it
+		 */
+		Open_result _open(char const *path, unsigned mode, Vfs_handle **out_handle,
+		                  Allocator &alloc, char const *full, Resolution &res)
+		{
+			path = _sub_path(path);
+
+			/* check if path does not match directory name */
+			if (!path)
+				return OPEN_ERR_UNACCESSIBLE;
+
+			/* path equals directory name */
+			if (strlen(path) == 0) {
+				*out_handle = new (alloc) Vfs_handle(*this, *this, alloc, 0);
+				return OPEN_OK;
+			}
+
+			/* path refers to any of our sub file systems */
+			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
+
+				bool const dir_fs = _dir_fs(*fs);
+
+				Open_result const err = dir_fs
+				                      ? _dir(*fs)._open(path, mode, out_handle,
+				                                        alloc, full, res)
+				                      : fs->open(path, mode, out_handle, alloc);
+				switch (err) {
+				case OPEN_ERR_UNACCESSIBLE:
+
+					/* 'fs' may provide the path later, shadowing the next ones */
+					if (!dir_fs || _dir(*fs)._sub_path(path))
+						res.first_layer = false;
+					continue;
+				case OPEN_OK:
+					if (!dir_fs) {
+						res.fs        = fs;
+						res.offset    = path - full;
+						res.directory = false;
+					}
+					return err;
+				default:
+					return err;
+				}
+			}
+
+			/* path does not match any existing file or directory */
+			return OPEN_ERR_UNACCESSIBLE;
+		}
+
+		/**
+		 * Drop cached lookups of 'path' after it got modified
+		 */
+		void _invalidate(char const *path)
+		{
+			if (_cache.constructed())
+				_cache->invalidate(path);
+		}
+
+		/**
+		 * Rename 'from_path' within our tree
+		 */
+		Rename_result _rename(char const *from_path, char const *to_path)
+		{
+			from_path = _sub_path(from_path);
+			to_path = _sub_path(to_path);
+
+			/* path does not match directory name */
+			if (!from_path)
+				return RENAME_ERR_NO_ENTRY;
+
+			/*
+			 * Cannot rename a path in the static VFS configuration.
+			 */
+			if (strlen(from_path) == 0)
+				return RENAME_ERR_NO_PERM;
+
+			/*
+			 * Check if destination path resides within the same file
+			 * system instance as the source path.
+			 */
+			if (!to_path)
+				return RENAME_ERR_CROSS_FS;
+
+			Rename_result final = RENAME_ERR_NO_ENTRY;
+			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
+				switch (fs->rename(from_path, to_path)) {
+				case RENAME_OK:           return RENAME_OK;
+				case RENAME_ERR_NO_ENTRY: continue;
+				case RENAME_ERR_NO_PERM:  return RENAME_ERR_NO_PERM;
+				case RENAME_ERR_CROSS_FS: final = RENAME_ERR_CROSS_FS;
+				}
+			}
+			return final;
+		}
+
 		/**
 		 * Perform operation on a file system
 		 *
@@ -181,6 +362,56 @@ class Vfs::Dir_file_system : public File_system
 			return DIRENT_OK;
 		}
 
+		/**
+		 * Read consecutive entries of the file systems at once
+		 *
+		 * The entries of a file system are obtained by a single 'dirents'
+		 * call. If the range spans several file systems, the read continues
+		 * with the first entry of the next file system.
+		 */
+		Dirent_result _dirents_of_file_systems(char const *path, file_offset index,
+		                                       Dirent *out, unsigned count,
+		                                       unsigned &out_count)
+		{
+			out_count = 0;
+
+			file_offset base = 0;
+			for (File_system *fs = _first_file_system; fs && out_count < count;
+			     fs = fs->next) {
+
+				file_offset const fs_num_dirent = fs->num_dirent(path);
+
+				if (index < base + fs_num_dirent) {
+
+					unsigned const wanted = (unsigned)
+						min((file_offset)(count - out_count),
+						    fs_num_dirent - (index - base));
+
+					unsigned fs_count = 0;
+					Dirent_result const result =
+						fs->dirents(path, index - base, out + out_count,
+						            wanted, fs_count);
+
+					if (result != DIRENT_OK)
+						return out_count ? DIRENT_OK : result;
+
+					out_count += fs_count;
+					index     += fs_count;
+
+					/* the file system ended its directory prematurely */
+					if (fs_count < wanted)
+						break;
+				}
+
+				base += fs_num_dirent;
+			}
+
+			if (out_count < count)
+				out[out_count].type = DIRENT_TYPE_END;
+
+			return DIRENT_OK;
+		}
+
 		void _dirent_of_this_dir_node(file_offset index, Dirent &out)
 		{
 			if (index == 0) {
@@ -224,6 +455,16 @@ class Vfs::Dir_file_system : public File_system
 			else
 				node.attribute("name").value(_name, sizeof(_name));
 
+			if (_root()) {
+				unsigned const entries =
+					node.attribute_value("path_cache", 0U);
+				unsigned long const ttl_ms =
+					node.attribute_value("stat_cache_ttl_ms", 0UL);
+
+				if (entries)
+					_cache.construct(env, alloc, entries, ttl_ms);
+			}
+
 			for (unsigned i = 0; i < node.num_sub_nodes(); i++) {
 
 				Xml_node sub_node = node.sub_node(i);
@@ -291,43 +532,36 @@ class Vfs::Dir_file_system : public File_system
 
 		Stat_result stat(char const *path, Stat &out) override
 		{
-			path = _sub_path(path);
+			Resolution res;
 
-			/* path does not match directory name */
-			if (!path)
-				return STAT_ERR_NO_ENTRY;
+			if (!_cache.constructed())
+				return _stat(path, out, path, res);
 
-			/*
-			 * If path equals directory name, return information about the
-			 * current directory.
-			 */
-			if (strlen(path) == 0 || (strcmp(path, "/") == 0)) {
-				out.size   = 0;
-				out.mode   = STAT_MODE_DIRECTORY | 0755;
-				out.uid    = 0;
-				out.gid    = 0;
-				out.inode  = 1;
-				out.device = (Genode::addr_t)this;
-				return STAT_OK;
+			switch (_cache->stat(path, out)) {
+			case Path_cache::STAT_CACHED:   return STAT_OK;
+			case Path_cache::STAT_NO_ENTRY: return STAT_ERR_NO_ENTRY;
+			case Path_cache::STAT_UNKNOWN:  break;
 			}
 
-			/*
-			 * The given path refers to one of our sub directories.
-			 * Propagate the request into our file systems.
-			 */
-			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
+			/* try the file system that provided the path last time */
+			if (_cache->resolution(path, res)) {
+				if (res.fs->stat(path + res.offset, out) == STAT_OK) {
+					_cache->insert(path, res, &out);
+					return STAT_OK;
+				}
+				_cache->invalidate(path);
+				res = Resolution();
+			}
 
-				Stat_result const err = fs->stat(path, out);
+			Stat_result const result = _stat(path, out, path, res);
 
-				if (err == STAT_OK)
-					return err;
+			if (result == STAT_OK && res.fs && res.first_layer)
+				_cache->insert(path, res, &out);
 
-				if (err != STAT_ERR_NO_ENTRY)
-					return err;
-			}
+			if (result == STAT_ERR_NO_ENTRY)
+				_cache->insert_no_entry(path);
 
-			/* none of our file systems felt responsible for the path */
-			return STAT_ERR_NO_ENTRY;
+			return result;
 		}
 
 		Dirent_result dirent(char const *path, file_offset index, Dirent &out) override
@@ -352,6 +586,30 @@ class Vfs::Dir_file_system : public File_system
 			return _dirent_of_file_systems(*path ? path : "/", index, out);
 		}
 
+		Dirent_result dirents(char const *path, file_offset index,
+		                      Dirent *out, unsigned count,
+		                      unsigned &out_count) override
+		{
+			if (_root())
+				return _dirents_of_file_systems(path, index, out, count, out_count);
+
+			if (strcmp(path, "/") == 0) {
+				out_count = 0;
+				if (count) {
+					_dirent_of_this_dir_node(index, out[0]);
+					out_count = out[0].type == DIRENT_TYPE_END ? 0 : 1;
+				}
+				return DIRENT_OK;
+			}
+
+			path = _sub_path(path);
+			if (!path)
+				return DIRENT_ERR_INVALID_PATH;
+
+			return _dirents_of_file_systems(*path ? path : "/", index,
+			                                out, count, out_count);
+		}
+
 		file_size num_dirent(char const *path) override
 		{
 			if (_root()) {
@@ -383,6 +641,11 @@ class Vfs::Dir_file_system : public File_system
 		 */
 		bool directory(char const *path) override
 		{
+			Resolution res;
+			if (_cache.constructed() && _cache->resolution(path, res)
+			 && res.directory && res.fs->directory(path + res.offset))
+				return true;
+
 			path = _sub_path(path);
 			if (!path)
 				return false;
@@ -407,6 +670,11 @@ class Vfs::Dir_file_system : public File_system
 
 		char const *leaf_path(char const *path) override
 		{
+			Resolution res;
+			if (_cache.constructed() && _cache->resolution(path, res))
+				if (char const *leaf_path = res.fs->leaf_path(path + res.offset))
+					return leaf_path;
+
 			path = _sub_path(path);
 			if (!path)
 				return 0;
@@ -428,6 +696,25 @@ class Vfs::Dir_file_system : public File_system
 		                 Vfs_handle **out_handle,
 		                 Allocator   &alloc) override
 		{
+			Resolution res;
+
+			if (_cache.constructed()) {
+
+				/* try the file system that provided the file last time */
+				if (!(mode & OPEN_MODE_CREATE)
+				 && _cache->resolution(path, res) && !res.directory) {
+
+					Open_result const err =
+						res.fs->open(path + res.offset, mode, out_handle, alloc);
+
+					if (err != OPEN_ERR_UNACCESSIBLE)
+						return err;
+
+					_cache->invalidate(path);
+				}
+				res = Resolution();
+			}
+
 			/*
 			 * If 'path' is a directory, we create a 'Vfs_handle'
 			 * for the root directory so that subsequent 'dirent' calls
@@ -443,39 +730,26 @@ class Vfs::Dir_file_system : public File_system
 			 * 'Vfs_handle' local to the file system that provides the
 			 * file.
 			 */
+			Open_result const err = _open(path, mode, out_handle, alloc, path, res);
 
-			path = _sub_path(path);
+			if (!_cache.constructed())
+				return err;
 
-			/* check if path does not match directory name */
-			if (!path)
-				return OPEN_ERR_UNACCESSIBLE;
+			if (mode & OPEN_MODE_CREATE)
+				_cache->invalidate(path);
 
-			/* path equals directory name */
-			if (strlen(path) == 0) {
-				*out_handle = new (alloc) Vfs_handle(*this, *this, alloc, 0);
-				return OPEN_OK;
-			}
+			if (err == OPEN_OK && res.fs && res.first_layer)
+				_cache->insert(path, res);
 
-			/* path refers to any of our sub file systems */
-			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
-
-				Open_result const err = fs->open(path, mode, out_handle, alloc);
-				switch (err) {
-				case OPEN_ERR_UNACCESSIBLE:
-					continue;
-				default:
-					return err;
-				}
-			}
-
-			/* path does not match any existing file or directory */
-			return OPEN_ERR_UNACCESSIBLE;
+			return err;
 		}
 
 		void close(Vfs_handle *handle) override
 		{
-			if (handle && (&handle->ds() == this))
+			if (handle && (&handle->ds() == this)) {
 				destroy(handle->alloc(), handle);
+				directory_closed();
+			}
 		}
 
 		Unlink_result unlink(char const *path) override
@@ -485,8 +759,12 @@ class Vfs::Dir_file_system : public File_system
 				return fs.unlink(path);
 			};
 
-			return _dir_op(UNLINK_ERR_NO_ENTRY, UNLINK_ERR_NO_PERM, UNLINK_OK,
-			               path, unlink_fn);
+			Unlink_result const result =
+				_dir_op(UNLINK_ERR_NO_ENTRY, UNLINK_ERR_NO_PERM, UNLINK_OK,
+				        path, unlink_fn);
+
+			_invalidate(path);
+			return result;
 		}
 
 		Readlink_result readlink(char const *path, char *buf, file_size buf_size,
@@ -503,36 +781,11 @@ class Vfs::Dir_file_system : public File_system
 
 		Rename_result rename(char const *from_path, char const *to_path) override
 		{
-			from_path = _sub_path(from_path);
-			to_path = _sub_path(to_path);
-
-			/* path does not match directory name */
-			if (!from_path)
-				return RENAME_ERR_NO_ENTRY;
-
-			/*
-			 * Cannot rename a path in the static VFS configuration.
-			 */
-			if (strlen(from_path) == 0)
-				return RENAME_ERR_NO_PERM;
+			Rename_result const result = _rename(from_path, to_path);
 
-			/*
-			 * Check if destination path resides within the same file
-			 * system instance as the source path.
-			 */
-			if (!to_path)
-				return RENAME_ERR_CROSS_FS;
-
-			Rename_result final = RENAME_ERR_NO_ENTRY;
-			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
-				switch (fs->rename(from_path, to_path)) {
-				case RENAME_OK:           return RENAME_OK;
-				case RENAME_ERR_NO_ENTRY: continue;
-				case RENAME_ERR_NO_PERM:  return RENAME_ERR_NO_PERM;
-				case RENAME_ERR_CROSS_FS: final = RENAME_ERR_CROSS_FS;
-				}
-			}
-			return final;
+			_invalidate(from_path);
+			_invalidate(to_path);
+			return result;
 		}
 
 		Symlink_result symlink(char const *from, char const *to) override
@@ -542,8 +795,12 @@ class Vfs::Dir_file_system : public File_system
 				return fs.symlink(from, to);
 			};
 
-			return _dir_op(SYMLINK_ERR_NO_ENTRY, SYMLINK_ERR_NO_PERM, SYMLINK_OK,
-			               to, symlink_fn);
+			Symlink_result const result =
+				_dir_op(SYMLINK_ERR_NO_ENTRY, SYMLINK_ERR_NO_PERM, SYMLINK_OK,
+				        to, symlink_fn);
+
+			_invalidate(to);
+			return result;
 		}
 
 		Mkdir_result mkdir(char const *path, unsigned mode) override
@@ -553,8 +810,12 @@ class Vfs::Dir_file_system : public File_system
 				return fs.mkdir(path, mode);
 			};
 
-			return _dir_op(MKDIR_ERR_NO_ENTRY, MKDIR_ERR_NO_PERM, MKDIR_OK,
-			               path, mkdir_fn);
+			Mkdir_result const result =
+				_dir_op(MKDIR_ERR_NO_ENTRY, MKDIR_ERR_NO_PERM, MKDIR_OK,
+				        path, mkdir_fn);
+
+			_invalidate(path);
+			return result;
 		}
 
 
@@ -588,6 +849,9 @@ class Vfs::Dir_file_system : public File_system
 		{
 			using namespace Genode;
 
+			if (_cache.constructed())
+				_cache->flush();
+
 			File_system *curr = _first_file_system;
 			for (unsigned i = 0; i < node.num_sub_nodes(); i++, curr = curr->next) {
 				Xml_node const &sub_node = node.sub_node(i);
@@ -603,6 +867,12 @@ class Vfs::Dir_file_system : public File_system
 			}
 		}
 
+		void directory_closed() override
+		{
+			for (File_system *fs = _first_file_system; fs; fs = fs->next)
+				fs->directory_closed();
+		}
+
 
 		/********************************
 		 ** File I/O service interface **
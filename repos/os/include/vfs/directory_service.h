@@ -127,6 +127,33 @@ struct Vfs::Directory_service
 
 	virtual Dirent_result dirent(char const *path, file_offset index, Dirent &) = 0;
 
+	/**
+	 * Read up to 'count' consecutive directory entries starting at 'index'
+	 *
+	 * \param out        destination array with room for 'count' entries
+	 * \param out_count  number of entries read, less than 'count' if the
+	 *                   end of the directory is reached
+	 *
+	 * The default implementation reads one entry after the other. File
+	 * systems that obtain several entries at once override this method.
+	 */
+	virtual Dirent_result dirents(char const *path, file_offset index,
+	                              Dirent *out, unsigned count,
+	                              unsigned &out_count)
+	{
+		for (out_count = 0; out_count < count; out_count++) {
+
+			Dirent_result const result = dirent(path, index + out_count,
+			                                    out[out_count]);
+			if (result != DIRENT_OK)
+				return out_count ? DIRENT_OK : result;
+
+			if (out[out_count].type == DIRENT_TYPE_END)
+				break;
+		}
+		return DIRENT_OK;
+	}
+
 
 	/************
 	 ** Unlink **
@@ -41,6 +41,13 @@ struct Vfs::File_system : Directory_service, File_io_service
 	 */
 	virtual void apply_config(Genode::Xml_node const &node) { }
 
+	/**
+	 * Release state kept for reading directories
+	 *
+	 * This method is called whenever a directory handle gets closed.
+	 */
+	virtual void directory_closed() { }
+
 	/**
 	 * Return the file-system type
 	 */
@@ -0,0 +1,292 @@
+/*
+ * \brief  Cache of path resolutions of the directory file system
+ * \author Christian Helmuth
+ * \date   2017-07-06
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__VFS__PATH_CACHE_H_
+#define _INCLUDE__VFS__PATH_CACHE_H_
+
+#include <base/allocator.h>
+#include <timer_session/connection.h>
+#include <util/reconstructible.h>
+#include <vfs/file_system.h>
+
+namespace Vfs { class Path_cache; }
+
+
+/**
+ * Bounded cache of path lookups
+ *
+ * The cache remembers the file system that provides a path together with
+ * the portion of the path relative to this file system. A cached
+ * resolution is only a hint. The user must fall back to a regular lookup
+ * if the file system does not provide the path anymore.
+ *
+ * Optionally, the results of 'stat' calls and failed lookups are cached
+ * for a limited time. The cache does not observe modifications that
+ * bypass the directory file system, in particular writes via VFS handles.
+ * Hence, cached 'stat' results may be outdated by up to the time to live.
+ */
+class Vfs::Path_cache
+{
+	public:
+
+		enum { WAYS = 4 };
+
+		/**
+		 * Resolution of a path
+		 */
+		struct Resolution
+		{
+			File_system *fs          = nullptr;
+			unsigned     offset      = 0;     /* start of path local to 'fs' */
+			bool         directory   = false;
+
+			/*
+			 * True if no file system precedes 'fs' in the lookup of the
+			 * path. Only such resolutions are cached because a preceding
+			 * file system may provide the path later on, taking precedence
+			 * over 'fs'.
+			 */
+			bool         first_layer = true;
+		};
+
+		enum Stat_state { STAT_UNKNOWN, STAT_CACHED, STAT_NO_ENTRY };
+
+	private:
+
+		struct Entry
+		{
+			bool                      valid        = false;
+			bool                      no_entry     = false;
+			bool                      stat_valid   = false;
+			unsigned                  hash         = 0;
+			unsigned long             used         = 0;
+			unsigned long             expires_ms   = 0;
+			Resolution                resolution;
+			Directory_service::Stat   stat;
+			char                      path[MAX_PATH_LEN];
+		};
+
+		Genode::Allocator &_alloc;
+		unsigned const     _num_sets;
+		unsigned long const _ttl_ms;
+		Entry             *_entries;
+		unsigned long      _used = 0;
+		Genode::Lock       _lock;
+
+		Genode::Constructible<Timer::Connection> _timer;
+
+		static unsigned _hash(char const *path)
+		{
+			/* FNV-1a */
+			unsigned h = 2166136261u;
+			for (; *path; path++)
+				h = (h ^ (unsigned char)*path) * 16777619u;
+			return h;
+		}
+
+		unsigned long _now_ms() { return _timer.constructed() ? _timer->elapsed_ms() : 0; }
+
+		Entry *_set(unsigned hash) { return &_entries[(hash % _num_sets)*WAYS]; }
+
+		Entry *_lookup(char const *path)
+		{
+			unsigned const hash = _hash(path);
+			Entry *set = _set(hash);
+			for (unsigned i = 0; i < WAYS; i++) {
+				Entry &e = set[i];
+				if (e.valid && e.hash == hash && !strcmp(e.path, path)) {
+					e.used = ++_used;
+					return &e;
+				}
+			}
+			return nullptr;
+		}
+
+		/**
+		 * Return entry for 'path', replacing the least-recently used entry
+		 * of the set if needed
+		 */
+		Entry *_entry(char const *path)
+		{
+			if (strlen(path) >= MAX_PATH_LEN)
+				return nullptr;
+
+			if (Entry *e = _lookup(path))
+				return e;
+
+			unsigned const hash = _hash(path);
+			Entry *set = _set(hash), *victim = &set[0];
+			for (unsigned i = 0; i < WAYS; i++) {
+				if (!set[i].valid) {
+					victim = &set[i];
+					break;
+				}
+				if (set[i].used < victim->used)
+					victim = &set[i];
+			}
+
+			*victim       = Entry();
+			victim->valid = true;
+			victim->hash  = hash;
+			victim->used  = ++_used;
+			strncpy(victim->path, path, sizeof(victim->path));
+			return victim;
+		}
+
+		bool _expired(Entry const &e) { return _now_ms() >= e.expires_ms; }
+
+		/**
+		 * Return true if 'path' equals 'prefix' or lies below it
+		 */
+		static bool _within(char const *path, char const *prefix)
+		{
+			Genode::size_t const len = strlen(prefix);
+			return !strcmp(path, prefix, len) && (path[len] == 0 || path[len] == '/');
+		}
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param entries  number of cached paths
+		 * \param ttl_ms   time to live of cached 'stat' results and failed
+		 *                 lookups, zero disables caching them
+		 */
+		Path_cache(Genode::Env &env, Genode::Allocator &alloc,
+		           unsigned entries, unsigned long ttl_ms)
+		:
+			_alloc(alloc),
+			_num_sets(Genode::max(1U, entries / WAYS)),
+			_ttl_ms(ttl_ms),
+			_entries((Entry *)alloc.alloc(_num_sets*WAYS*sizeof(Entry)))
+		{
+			for (unsigned i = 0; i < _num_sets*WAYS; i++)
+				Genode::construct_at<Entry>(&_entries[i]);
+
+			if (_ttl_ms)
+				_timer.construct(env);
+		}
+
+		~Path_cache() { _alloc.free(_entries, _num_sets*WAYS*sizeof(Entry)); }
+
+		/**
+		 * Look up resolution of 'path'
+		 */
+		bool resolution(char const *path, Resolution &out)
+		{
+			Lock::Guard guard(_lock);
+
+			Entry const *e = _lookup(path);
+			if (!e || !e->resolution.fs)
+				return false;
+
+			out = e->resolution;
+			return true;
+		}
+
+		/**
+		 * Look up cached 'stat' result of 'path'
+		 */
+		Stat_state stat(char const *path, Directory_service::Stat &out)
+		{
+			if (!_ttl_ms)
+				return STAT_UNKNOWN;
+
+			Lock::Guard guard(_lock);
+
+			Entry *e = _lookup(path);
+			if (!e || !(e->stat_valid || e->no_entry))
+				return STAT_UNKNOWN;
+
+			if (_expired(*e)) {
+				e->stat_valid = false;
+				e->no_entry   = false;
+				return STAT_UNKNOWN;
+			}
+
+			if (e->no_entry)
+				return STAT_NO_ENTRY;
+
+			out = e->stat;
+			return STAT_CACHED;
+		}
+
+		/**
+		 * Remember resolution of 'path' and, if enabled, its 'stat' result
+		 */
+		void insert(char const *path, Resolution const &resolution,
+		            Directory_service::Stat const *stat = nullptr)
+		{
+			Lock::Guard guard(_lock);
+
+			Entry *e = _entry(path);
+			if (!e)
+				return;
+
+			e->resolution = resolution;
+			e->no_entry   = false;
+			e->stat_valid = false;
+
+			if (stat && _ttl_ms) {
+				e->stat       = *stat;
+				e->stat_valid = true;
+				e->expires_ms = _now_ms() + _ttl_ms;
+			}
+		}
+
+		/**
+		 * Remember that 'path' does not exist, if enabled
+		 */
+		void insert_no_entry(char const *path)
+		{
+			if (!_ttl_ms)
+				return;
+
+			Lock::Guard guard(_lock);
+
+			Entry *e = _entry(path);
+			if (!e)
+				return;
+
+			e->resolution = Resolution();
+			e->no_entry   = true;
+			e->stat_valid = false;
+			e->expires_ms = _now_ms() + _ttl_ms;
+		}
+
+		/**
+		 * Drop entries of 'path' and of all paths below it
+		 */
+		void invalidate(char const *path)
+		{
+			Lock::Guard guard(_lock);
+
+			for (unsigned i = 0; i < _num_sets*WAYS; i++)
+				if (_entries[i].valid && _within(_entries[i].path, path))
+					_entries[i].valid = false;
+		}
+
+		/**
+		 * Drop all entries
+		 */
+		void flush()
+		{
+			Lock::Guard guard(_lock);
+
+			for (unsigned i = 0; i < _num_sets*WAYS; i++)
+				_entries[i].valid = false;
+		}
+};
+
+#endif /* _INCLUDE__VFS__PATH_CACHE_H_ */
@@ -18,17 +18,20 @@
 
 static snd_pcm_t *playback_handle;
 
-int audio_drv_init(char const * const device)
+/* number of periods buffered by ALSA */
+enum { PERIODS = 4 };
+
+
+/**
+ * Set hardware parameters for a period of 'period' frames
+ *
+ * The ALSA buffer holds 'PERIODS' periods. Hence, the output latency
+ * follows the period negotiated with the clients.
+ */
+static int set_hw_params(snd_pcm_hw_params_t *hw_params, unsigned period)
 {
 	unsigned int rate = 44100;
 	int err;
-	snd_pcm_hw_params_t *hw_params;
-
-	if ((err = snd_pcm_open(&playback_handle, device, SND_PCM_STREAM_PLAYBACK, 0)) < 0)
-		return -1;
-
-	if ((err = snd_pcm_hw_params_malloc(&hw_params)) < 0)
-		return -2;
 
 	if ((err = snd_pcm_hw_params_any(playback_handle, hw_params)) < 0)
 		return -3;
@@ -45,17 +48,34 @@ int audio_drv_init(char const * const device)
 	if ((err = snd_pcm_hw_params_set_channels(playback_handle, hw_params, 2)) < 0)
 		return -7;
 
-	if ((err = snd_pcm_hw_params_set_period_size(playback_handle, hw_params, 2048, 0)) < 0)
+	if ((err = snd_pcm_hw_params_set_period_size(playback_handle, hw_params, period, 0)) < 0)
 		return -8;
 
-	if ((err = snd_pcm_hw_params_set_periods(playback_handle, hw_params, 4, 0)) < 0)
+	if ((err = snd_pcm_hw_params_set_periods(playback_handle, hw_params, PERIODS, 0)) < 0)
 		return -9;
 
 	if ((err = snd_pcm_hw_params(playback_handle, hw_params)) < 0)
 		return -10;
 
+	return 0;
+}
+
+
+static int configure(unsigned period)
+{
+	int err;
+	snd_pcm_hw_params_t *hw_params;
+
+	if ((err = snd_pcm_hw_params_malloc(&hw_params)) < 0)
+		return -2;
+
+	err = set_hw_params(hw_params, period);
+
 	snd_pcm_hw_params_free(hw_params);
 
+	if (err)
+		return err;
+
 	if ((err = snd_pcm_prepare(playback_handle)) < 0)
 		return -11;
 
@@ -63,6 +83,25 @@ int audio_drv_init(char const * const device)
 }
 
 
+int audio_drv_init(char const * const device, unsigned period)
+{
+	int err;
+
+	if ((err = snd_pcm_open(&playback_handle, device, SND_PCM_STREAM_PLAYBACK, 0)) < 0)
+		return -1;
+
+	return configure(period);
+}
+
+
+int audio_drv_period(unsigned period)
+{
+	snd_pcm_drop(playback_handle);
+
+	return configure(period);
+}
+
+
 int audio_drv_play(void *data, int frame_cnt)
 {
 	int err;
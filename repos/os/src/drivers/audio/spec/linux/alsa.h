@@ -19,7 +19,8 @@
 extern "C" {
 #endif
 
-int audio_drv_init(char const * const);
+int audio_drv_init(char const * const, unsigned period);
+int audio_drv_period(unsigned period);
 int audio_drv_play(void *data, int frame_cnt);
 void audio_drv_stop(void);
 void audio_drv_start(void);
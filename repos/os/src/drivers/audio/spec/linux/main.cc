@@ -55,11 +55,13 @@ class Audio_out::Session_component : public Audio_out::Session_rpc_object
 
 	public:
 
-		Session_component(Genode::Env &env, Channel_number channel, Signal_context_capability data_cap)
+		Session_component(Genode::Env &env, Channel_number channel,
+		                  unsigned period, Signal_context_capability data_cap)
 		:
 			Session_rpc_object(env, data_cap),
 			_channel(channel)
 		{
+			stream()->period(period);
 			Audio_out::channel_acquired[_channel] = this;
 		}
 
@@ -105,6 +107,8 @@ class Audio_out::Out
 
 		Timer::Connection _timer { _env };
 
+		unsigned _period = PERIOD;  /* samples played per timeout */
+
 		bool _active() {
 			return  channel_acquired[LEFT] && channel_acquired[RIGHT] &&
 			        channel_acquired[LEFT]->active() && channel_acquired[RIGHT]->active();
@@ -147,7 +151,7 @@ class Audio_out::Out
 
 			if (p_left->valid() && p_right->valid()) {
 
-				for (int i = 0; i < 2 * PERIOD; i += 2) {
+				for (unsigned i = 0; i < 2 * _period; i += 2) {
 					data[i] = p_left->content()[i / 2] * 32767;
 					data[i + 1] = p_right->content()[i / 2] * 32767;
 				}
@@ -156,7 +160,7 @@ class Audio_out::Out
 				p_right->invalidate();
 
 				/* blocking-write packet to ALSA */
-				while (audio_drv_play(data, PERIOD)) {
+				while (audio_drv_play(data, _period)) {
 					/* try to restart the driver silently */
 					audio_drv_stop();
 					audio_drv_start();
@@ -178,6 +182,12 @@ class Audio_out::Out
 			if (_active()) _play_packet();
 		}
 
+		void _trigger_timer()
+		{
+			unsigned long const us = (unsigned long)_period*1000*1000 / SAMPLE_RATE;
+			_timer.trigger_periodic(us);
+		}
+
 	public:
 
 		Out(Genode::Env &env)
@@ -187,12 +197,49 @@ class Audio_out::Out
 			_timer_dispatcher(env.ep(), *this, &Audio_out::Out::_handle_timer)
 		{
 			_timer.sigh(_timer_dispatcher);
-
-			unsigned const us = (Audio_out::PERIOD * 1000 / Audio_out::SAMPLE_RATE)*1000;
-			_timer.trigger_periodic(us);
+			_trigger_timer();
 		}
 
 		Signal_context_capability data_avail_sigh() { return _data_avail_dispatcher; }
+
+		/**
+		 * Switch to the period requested by a new session
+		 *
+		 * The period can only be changed while no channel is acquired. The
+		 * ALSA period is adapted accordingly so that the latency of the
+		 * ALSA buffer follows the negotiated period.
+		 *
+		 * \return  false if the period cannot be provided
+		 */
+		bool negotiate_period(unsigned period)
+		{
+			if (period == _period)
+				return true;
+
+			if (!valid_period(period)) {
+				Genode::error("invalid period ", period);
+				return false;
+			}
+
+			if (channel_acquired[LEFT] || channel_acquired[RIGHT]) {
+				Genode::error("requested period ", period, ", current period "
+				              "of acquired channels is ", _period);
+				return false;
+			}
+
+			/* keep the current period if ALSA does not support the new one */
+			if (audio_drv_period(period)) {
+				Genode::error("ALSA period of ", period, " frames not supported");
+				audio_drv_period(_period);
+				return false;
+			}
+
+			_period = period;
+			_trigger_timer();
+			return true;
+		}
+
+		unsigned period() const { return _period; }
 };
 
 
@@ -240,8 +287,7 @@ class Audio_out::Root : public Audio_out::Root_component
 	private:
 
 		Genode::Env &_env;
-
-		Signal_context_capability _data_cap;
+		Out         &_out;
 
 	protected:
 
@@ -254,15 +300,23 @@ class Audio_out::Root : public Audio_out::Root_component
 			                                             "left");
 			channel_number_from_string(channel_name, &channel_number);
 
+			/*
+			 * A client that is unaware of the period would submit packets
+			 * that are played only partially.
+			 */
+			if (!_out.negotiate_period(
+				Arg_string::find_arg(args, "period").ulong_value(PERIOD)))
+				throw Genode::Service_denied();
+
 			return new (md_alloc())
-				Session_component(_env, channel_number, _data_cap);
+				Session_component(_env, channel_number, _out.period(),
+				                  _out.data_avail_sigh());
 		}
 
 	public:
 
-		Root(Genode::Env &env, Allocator &md_alloc,
-		     Signal_context_capability data_cap)
-		: Root_component(env.ep(), md_alloc), _env(env), _data_cap(data_cap)
+		Root(Genode::Env &env, Allocator &md_alloc, Out &out)
+		: Root_component(env.ep(), md_alloc), _env(env), _out(out)
 		{ }
 };
 
@@ -282,7 +336,7 @@ struct Audio_out::Main
 		} catch (...) { }
 
 		/* init ALSA */
-		int err = audio_drv_init(dev);
+		int err = audio_drv_init(dev, PERIOD);
 		if (err) {
 			if (err == -1) {
 				Genode::error("could not open ALSA device ", Genode::Cstring(dev));
@@ -295,7 +349,7 @@ struct Audio_out::Main
 		audio_drv_start();
 
 		static Audio_out::Out  out(env);
-		static Audio_out::Root root(env, heap, out.data_avail_sigh());
+		static Audio_out::Root root(env, heap, out);
 		env.parent().announce(env.ep().manage(root));
 		Genode::log("--- start Audio_out ALSA driver ---");
 	}
@@ -561,8 +561,8 @@ struct Usb::Block_driver : Usb::Completion,
 	void ack_pending_request(bool success = true)
 	{
 		/*
-		 * Needs to be reset bevor calling ack_packet to prevent getting a new
-		 * request imediately and throwing Request_congestion() in io() again.
+		 * Needs to be reset bevor calling ack_packet because the session
+		 * hands out the next request immediately.
 		 */
 		req.pending = false;
 
@@ -772,6 +772,11 @@ struct Usb::Block_driver : Usb::Completion,
 	Block::sector_t    block_count() override { return _block_count; }
 	Block::Session::Operations ops() override { return _block_ops;   }
 
+	/*
+	 * The bulk-only transport executes one command at a time
+	 */
+	unsigned queue_depth() override { return 1; }
+
 	void read(Block::sector_t lba, size_t count,
 	          char *buffer, Block::Packet_descriptor &p) override {
 		io(true, lba, count, buffer, p); }
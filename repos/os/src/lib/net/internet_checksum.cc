@@ -0,0 +1,87 @@
+/*
+ * \brief  Internet checksum (RFC 1071)
+ * \author agent
+ * \date   2026-10-18
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <util/endian.h>
+#include <net/internet_checksum.h>
+
+using namespace Genode;
+
+
+/**
+ * Sum up data that starts at an odd address byte-wise in network byte order
+ */
+static uint16_t _sum_unaligned(uint8_t const *byte, size_t size)
+{
+	uint64_t sum = 0;
+	for (; size > 1; size -= 2, byte += 2) {
+		sum += (byte[0] << 8) | byte[1]; }
+
+	if (size) {
+		sum += byte[0] << 8; }
+
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	return Net::internet_checksum_fold((sum & 0xffffffff) + (sum >> 32));
+}
+
+
+/**
+ * Sum up 16-bit aligned data machine-word-wise in host byte order
+ */
+static uint16_t _sum_aligned(uint8_t const *byte, size_t size)
+{
+	uint64_t sum = 0;
+
+	/* align to 32 bit so that the main loop uses naturally aligned loads */
+	if (size >= 2 && ((addr_t)byte & 2)) {
+		sum  += *(uint16_t const *)byte;
+		byte += 2;
+		size -= 2;
+	}
+	/*
+	 * Because 2^32 and 2^16 are both congruent to 1 modulo 2^16 - 1, adding
+	 * up 32-bit words into a 64-bit accumulator and folding the result at
+	 * the end is equivalent to the 16-bit one's-complement sum.
+	 */
+	uint32_t const *word = (uint32_t const *)byte;
+	for (; size >= 32; size -= 32, word += 8) {
+		sum += (uint64_t)word[0] + word[1] + word[2] + word[3];
+		sum += (uint64_t)word[4] + word[5] + word[6] + word[7];
+	}
+	for (; size >= 4; size -= 4, word++) {
+		sum += *word; }
+
+	byte = (uint8_t const *)word;
+	if (size >= 2) {
+		sum  += *(uint16_t const *)byte;
+		byte += 2;
+		size -= 2;
+	}
+	/* pad an odd trailing byte with zero */
+	if (size) {
+		uint8_t const last[] = { *byte, 0 };
+		sum += *(uint16_t const *)last;
+	}
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	return Net::internet_checksum_fold((sum & 0xffffffff) + (sum >> 32));
+}
+
+
+uint32_t Net::internet_checksum_add(void const *data, size_t size, uint32_t sum)
+{
+	uint8_t const *byte = (uint8_t const *)data;
+	if ((addr_t)byte & 1) {
+		return sum + _sum_unaligned(byte, size); }
+
+	return sum + host_to_big_endian(_sum_aligned(byte, size));
+}
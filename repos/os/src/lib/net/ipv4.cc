@@ -17,6 +17,7 @@
 #include <net/udp.h>
 #include <net/tcp.h>
 #include <net/ipv4.h>
+#include <net/internet_checksum.h>
 
 using namespace Genode;
 using namespace Net;
@@ -84,17 +85,16 @@ Ipv4_address Ipv4_packet::ip_from_string(const char *ip)
 
 Genode::uint16_t Ipv4_packet::calculate_checksum(Ipv4_packet const &packet)
 {
-	Genode::uint16_t const *data = packet.header<Genode::uint16_t>();
-	Genode::uint32_t const sum = host_to_big_endian(data[0])
-	                           + host_to_big_endian(data[1])
-	                           + host_to_big_endian(data[2])
-	                           + host_to_big_endian(data[3])
-	                           + host_to_big_endian(data[4])
-	                           + host_to_big_endian(data[6])
-	                           + host_to_big_endian(data[7])
-	                           + host_to_big_endian(data[8])
-	                           + host_to_big_endian(data[9]);
-	return ~((0xFFFF & sum) + (sum >> 16));
+	/* sum up the header including options but skip the checksum field */
+	Genode::uint8_t const *header = packet.header<Genode::uint8_t>();
+	Genode::size_t  const  size   = Genode::max((Genode::size_t)packet._header_length * 4,
+	                                            sizeof(Ipv4_packet));
+	Genode::size_t  const  csum   = (Genode::addr_t)&packet._header_checksum -
+	                                (Genode::addr_t)&packet;
+
+	Genode::uint32_t const sum = internet_checksum_add(header, csum);
+	return internet_checksum(header + csum + sizeof(packet._header_checksum),
+	                         size - csum - sizeof(packet._header_checksum), sum);
 }
 
 
@@ -278,6 +278,39 @@ class Vfs::Fs_file_system : public File_system
 		Genode::Io_signal_handler<Fs_file_system> _ack_handler {
 			_env.ep(), *this, &Fs_file_system::_handle_ack };
 
+		/**
+		 * Directory handle kept open across 'dirents' calls
+		 *
+		 * Servers keep a cursor per open directory handle. By reusing the
+		 * handle for consecutive reads of the same directory, a sequential
+		 * traversal does not have to skip the already-read entries on each
+		 * call. The handle is dropped whenever this file system modifies the
+		 * namespace, once the end of the directory is reached, and when a
+		 * directory handle of the VFS gets closed. Otherwise, the server
+		 * would keep the directory open after the listing finished.
+		 */
+		Genode::Constructible<Fs_handle_guard> _dir_cursor;
+		Absolute_path                          _dir_cursor_path;
+
+		void _drop_dir_cursor()
+		{
+			Lock::Guard guard(_lock);
+			_dir_cursor.destruct();
+		}
+
+		Fs_vfs_handle &_dir_cursor_handle(char const *path)
+		{
+			if (_dir_cursor.constructed() && _dir_cursor_path == path)
+				return *_dir_cursor;
+
+			_dir_cursor.destruct();
+
+			::File_system::Dir_handle const dir_handle = _fs.dir(path, false);
+			_dir_cursor.construct(*this, _fs, dir_handle, _handle_space);
+			_dir_cursor_path = Absolute_path(path);
+			return *_dir_cursor;
+		}
+
 	public:
 
 		Fs_file_system(Genode::Env         &env,
@@ -391,51 +424,84 @@ class Vfs::Fs_file_system : public File_system
 			return STAT_OK;
 		}
 
-		Dirent_result dirent(char const *path, file_offset index, Dirent &out) override
+		Dirent_result dirents(char const *path, file_offset index,
+		                      Dirent *out, unsigned count,
+		                      unsigned &out_count) override
 		{
 			Lock::Guard guard(_lock);
 
 			using ::File_system::Directory_entry;
 
+			out_count = 0;
+
 			if (strcmp(path, "") == 0)
 				path = "/";
 
-			::File_system::Dir_handle dir_handle;
-			try { dir_handle = _fs.dir(path, false); }
+			Fs_vfs_handle *dir = nullptr;
+			try { dir = &_dir_cursor_handle(path); }
 			catch (::File_system::Lookup_failed) { return DIRENT_ERR_INVALID_PATH; }
 			catch (::File_system::Name_too_long) { return DIRENT_ERR_INVALID_PATH; }
 			catch (...) { return DIRENT_ERR_NO_PERM; }
 
-			Fs_handle_guard dir_guard(*this, _fs, dir_handle, _handle_space);
-			Directory_entry entry;
+			enum { DIRENT_SIZE = sizeof(Directory_entry), BATCH = 16 };
 
-			enum { DIRENT_SIZE = sizeof(Directory_entry) };
+			/* fetch the entries with as few packets as possible */
+			Directory_entry entries[BATCH];
 
-			_read(dir_guard, &entry, DIRENT_SIZE, index*DIRENT_SIZE);
+			while (out_count < count) {
 
-			/*
-			 * The default value has no meaning because the switch below
-			 * assigns a value in each possible branch. But it is needed to
-			 * keep the compiler happy.
-			 */
-			Dirent_type type = DIRENT_TYPE_END;
+				unsigned const batch = min((unsigned)BATCH, count - out_count);
+
+				file_size const n = _read(*dir, entries, batch*DIRENT_SIZE,
+				                          (index + out_count)*DIRENT_SIZE)
+				                  / DIRENT_SIZE;
 
-			/* copy-out payload into destination buffer */
-			switch (entry.type) {
-			case Directory_entry::TYPE_DIRECTORY: type = DIRENT_TYPE_DIRECTORY; break;
-			case Directory_entry::TYPE_FILE:      type = DIRENT_TYPE_FILE;      break;
-			case Directory_entry::TYPE_SYMLINK:   type = DIRENT_TYPE_SYMLINK;   break;
+				for (unsigned i = 0; i < n; i++) {
+
+					Directory_entry const &entry = entries[i];
+					Dirent &dirent = out[out_count];
+
+					dirent.type = DIRENT_TYPE_END;
+					switch (entry.type) {
+					case Directory_entry::TYPE_DIRECTORY: dirent.type = DIRENT_TYPE_DIRECTORY; break;
+					case Directory_entry::TYPE_FILE:      dirent.type = DIRENT_TYPE_FILE;      break;
+					case Directory_entry::TYPE_SYMLINK:   dirent.type = DIRENT_TYPE_SYMLINK;   break;
+					}
+
+					dirent.fileno = entry.inode;
+					strncpy(dirent.name, entry.name, sizeof(dirent.name));
+					out_count++;
+				}
+
+				if (n < batch)
+					break;
 			}
 
-			out.fileno = entry.inode;
-			out.type   = type;
-			strncpy(out.name, entry.name, sizeof(out.name));
+			/* end of directory, close the server-side handle */
+			if (out_count < count) {
+				out[out_count].type = DIRENT_TYPE_END;
+				_dir_cursor.destruct();
+			}
 
 			return DIRENT_OK;
 		}
 
+		Dirent_result dirent(char const *path, file_offset index, Dirent &out) override
+		{
+			unsigned count = 0;
+			Dirent_result const result = dirents(path, index, &out, 1, count);
+
+			if (result == DIRENT_OK && count == 0) {
+				out.fileno  = 0;
+				out.name[0] = 0;
+			}
+			return result;
+		}
+
 		Unlink_result unlink(char const *path) override
 		{
+			_drop_dir_cursor();
+
 			Absolute_path dir_path(path);
 			dir_path.strip_last_element();
 
@@ -491,6 +557,8 @@ class Vfs::Fs_file_system : public File_system
 			if ((strcmp(from_path, to_path) == 0) && leaf_path(from_path))
 				return RENAME_OK;
 
+			_drop_dir_cursor();
+
 			Absolute_path from_dir_path(from_path);
 			from_dir_path.strip_last_element();
 
@@ -520,6 +588,8 @@ class Vfs::Fs_file_system : public File_system
 
 		Mkdir_result mkdir(char const *path, unsigned mode) override
 		{
+			_drop_dir_cursor();
+
 			/*
 			 * Canonicalize path (i.e., path must start with '/')
 			 */
@@ -547,6 +617,8 @@ class Vfs::Fs_file_system : public File_system
 			 */
 			Lock::Guard guard(_lock);
 
+			_dir_cursor.destruct();
+
 			/*
 			 * Canonicalize path (i.e., path must start with '/')
 			 */
@@ -638,6 +710,9 @@ class Vfs::Fs_file_system : public File_system
 
 			bool const create = vfs_mode & OPEN_MODE_CREATE;
 
+			if (create)
+				_dir_cursor.destruct();
+
 			try {
 				::File_system::Dir_handle dir = _fs.dir(dir_path.base(), false);
 				Fs_handle_guard dir_guard(*this, _fs, dir, _handle_space);
@@ -684,6 +759,8 @@ class Vfs::Fs_file_system : public File_system
 		static char const *name()   { return "fs"; }
 		char const *type() override { return "fs"; }
 
+		void directory_closed() override { _drop_dir_cursor(); }
+
 		void sync(char const *path) override
 		{
 			try {
@@ -18,6 +18,7 @@
 #include <vfs/file_system.h>
 #include <vfs/vfs_handle.h>
 #include <base/attached_rom_dataspace.h>
+#include <util/avl_string.h>
 
 namespace Vfs { class Tar_file_system; }
 
@@ -115,49 +116,20 @@ class Vfs::Tar_file_system : public File_system
 	typedef Genode::Token<Scanner_policy_path_element> Path_element_token;
 
 
-	struct Node : List<Node>, List<Node>::Element
+	struct Node : List<Node>, List<Node>::Element, Genode::Avl_string_base
 	{
 		char const *name;
 		Record const *record;
 
-		Node(char const *name, Record const *record) : name(name), record(record) { }
-
-		Node *lookup(char const *name)
-		{
-			Absolute_path lookup_path(name);
-
-			Node *parent_node = this;
-			Node *child_node;
-
-			Path_element_token t(lookup_path.base());
-
-			while (t) {
-
-				if (t.type() != Path_element_token::IDENT) {
-						t = t.next();
-						continue;
-				}
-
-				char path_element[MAX_PATH_LEN];
-
-				t.string(path_element, sizeof(path_element));
-
-				for (child_node = parent_node->first(); child_node; child_node = child_node->next()) {
-					if (strcmp(child_node->name, path_element) == 0) {
-						parent_node = child_node;
-						break;
-					}
-				}
-
-				if (!child_node)
-					return 0;
-
-				t = t.next();
-			}
-
-			return parent_node;
-		}
-
+		/**
+		 * Constructor
+		 *
+		 * \param path  absolute path of the node, used as key of the
+		 *              node index
+		 * \param name  last path element
+		 */
+		Node(char const *path, char const *name, Record const *record)
+		: Avl_string_base(path), name(name), record(record) { }
 
 		Node const *lookup_child(int index) const
 		{
@@ -180,6 +152,27 @@ class Vfs::Tar_file_system : public File_system
 	} _root_node;
 
 
+	/*
+	 * Index of all nodes by their absolute path
+	 *
+	 * The index is populated once while scanning the archive and spares us
+	 * from walking the child lists of all directories along a path on each
+	 * lookup.
+	 */
+	struct Node_index : Genode::Avl_tree<Genode::Avl_string_base>
+	{
+		Node *lookup(char const *path)
+		{
+			Absolute_path const lookup_path(path);
+
+			Genode::Avl_string_base *node = first();
+			node = node ? node->find_by_name(lookup_path.base()) : 0;
+			return static_cast<Node *>(node);
+		}
+
+	} _node_index;
+
+
 	/*
 	 *  Create a Node for a tar record and insert it into the node list
 	 */
@@ -191,11 +184,14 @@ class Vfs::Tar_file_system : public File_system
 
 			Node &_root_node;
 
+			Node_index &_node_index;
+
 		public:
 
 			Add_node_action(Genode::Allocator &alloc,
-			                Node              &root_node)
-			: _alloc(alloc), _root_node(root_node) { }
+			                Node              &root_node,
+			                Node_index        &node_index)
+			: _alloc(alloc), _root_node(root_node), _node_index(node_index) { }
 
 			void operator()(Record const *record)
 			{
@@ -205,6 +201,8 @@ class Vfs::Tar_file_system : public File_system
 
 				Path_element_token t(current_path.base());
 
+				Absolute_path node_path;
+
 				Node *parent_node = &_root_node;
 				Node *child_node;
 
@@ -219,10 +217,9 @@ class Vfs::Tar_file_system : public File_system
 
 					t.string(path_element, sizeof(path_element));
 
-					for (child_node = parent_node->first(); child_node; child_node = child_node->next()) {
-						if (strcmp(child_node->name, path_element) == 0)
-							break;
-					}
+					node_path.append_element(path_element);
+
+					child_node = _node_index.lookup(node_path.base());
 
 					if (child_node) {
 
@@ -233,26 +230,24 @@ class Vfs::Tar_file_system : public File_system
 							child_node->record = record;
 						}
 					} else {
-						if (remaining_path.has_single_element()) {
 
-							/*
-							 * TODO: find 'path_element' in 'record->name'
-							 * and use the location in the record as name
-							 * pointer to save some memory
-							 */
-							Genode::size_t name_size = strlen(path_element) + 1;
-							char *name = (char*)_alloc.alloc(name_size);
-							strncpy(name, path_element, name_size);
-							child_node = new (_alloc) Node(name, record);
-						} else {
-
-							/* create a directory node without record */
-							Genode::size_t name_size = strlen(path_element) + 1;
-							char *name = (char*)_alloc.alloc(name_size);
-							strncpy(name, path_element, name_size);
-							child_node = new (_alloc) Node(name, 0);
-						}
-						parent_node->insert(child_node);
+						/*
+						 * The node name is the last element of the path
+						 * stored as index key.
+						 */
+						Genode::size_t const path_len = strlen(node_path.base());
+						Genode::size_t const name_len = strlen(path_element);
+						char *path = (char*)_alloc.alloc(path_len + 1);
+						strncpy(path, node_path.base(), path_len + 1);
+						char const *name = path + path_len - name_len;
+
+						/* create a directory node without record if needed */
+						child_node = new (_alloc)
+							Node(path, name, remaining_path.has_single_element()
+							                 ? record : 0);
+
+						parent_node->List<Node>::insert(child_node);
+						_node_index.insert(child_node);
 					}
 
 					parent_node = child_node;
@@ -298,13 +293,13 @@ class Vfs::Tar_file_system : public File_system
 	struct Num_dirent_cache
 	{
 		Lock             lock;
-		Node            &root_node;
+		Node_index      &node_index;
 		bool             valid;              /* true after first lookup */
 		char             key[256];           /* key used for lookup */
 		file_size        cached_num_dirent;  /* cached value */
 
-		Num_dirent_cache(Node &root_node)
-		: root_node(root_node), valid(false), cached_num_dirent(0) { }
+		Num_dirent_cache(Node_index &node_index)
+		: node_index(node_index), valid(false), cached_num_dirent(0) { }
 
 		file_size num_dirent(char const *path)
 		{
@@ -312,7 +307,7 @@ class Vfs::Tar_file_system : public File_system
 
 			/* check for cache miss */
 			if (!valid || strcmp(path, key) != 0) {
-				Node *node = root_node.lookup(path);
+				Node *node = node_index.lookup(path);
 				if (!node)
 					return 0;
 				strncpy(key, path, sizeof(key));
@@ -330,7 +325,7 @@ class Vfs::Tar_file_system : public File_system
 	 */
 	Node const *dereference(char const *path)
 	{
-		Node const *node = _root_node.lookup(path);
+		Node const *node = _node_index.lookup(path);
 		if (!node) return 0;
 
 		Record const *record = node->record;
@@ -349,13 +344,16 @@ class Vfs::Tar_file_system : public File_system
 		:
 			_env(env), _alloc(alloc),
 			_rom_name(config.attribute_value("name", Rom_name())),
-			_root_node("", 0),
-			_cached_num_dirent(_root_node)
+			_root_node("/", "", 0),
+			_cached_num_dirent(_node_index)
 		{
 			Genode::log("tar archive '", _rom_name, "' "
 			            "local at ", (void *)_tar_base, ", size is ", _tar_size);
 
-			_for_each_tar_record_do(Add_node_action(_alloc, _root_node));
+			_node_index.insert(&_root_node);
+
+			_for_each_tar_record_do(Add_node_action(_alloc, _root_node,
+			                                        _node_index));
 		}
 
 		/*********************************
@@ -505,7 +503,7 @@ class Vfs::Tar_file_system : public File_system
 
 		Rename_result rename(char const *from, char const *to) override
 		{
-			if (_root_node.lookup(from) || _root_node.lookup(to))
+			if (_node_index.lookup(from) || _node_index.lookup(to))
 				return RENAME_ERR_NO_PERM;
 			return RENAME_ERR_NO_ENTRY;
 		}
@@ -544,7 +542,7 @@ class Vfs::Tar_file_system : public File_system
 			 * case, return the whole path, which is relative to the root
 			 * of this file system.
 			 */
-			Node *node = _root_node.lookup(path);
+			Node *node = _node_index.lookup(path);
 			return node ? path : 0;
 		}
 
@@ -381,6 +381,14 @@ class Driver : public Block::Driver
 		Block::sector_t block_count()    { return _blk_cnt; }
 		Block::Session::Operations ops() { return _ops;     }
 
+		/*
+		 * A write to a partial cache block may need two requests to the
+		 * backend device, one for each end of the written range. Limiting
+		 * the number of client requests accordingly keeps the requests
+		 * re-issued on completion of a backend request from congesting.
+		 */
+		unsigned queue_depth() override { return Block::Session::TX_QUEUE_SIZE / 2; }
+
 		void read(Block::sector_t           block_number,
 		          Genode::size_t            block_count,
 		          char*                     buffer,
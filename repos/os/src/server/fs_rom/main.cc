@@ -33,9 +33,11 @@ namespace Fs_rom {
 
 	struct Packet_handler;
 
+	class Rom_file;
 	class Rom_session_component;
 	class Rom_root;
 
+	typedef Genode::List<Rom_file>              Rom_files;
 	typedef Genode::List<Rom_session_component> Sessions;
 
 	typedef File_system::Session_client::Tx::Source Tx_source;
@@ -43,20 +45,50 @@ namespace Fs_rom {
 
 
 /**
- * A 'Rom_session_component' exports a single file of the file system
+ * File of the file system as shared by all ROM sessions that requested it
+ *
+ * The file content is read only once per version of the file, no matter how
+ * many ROM sessions refer to the file. A change notification just marks the
+ * content as outdated and informs the sessions. The content is re-read when
+ * a session requests the dataspace for the first time after the change.
+ * Thereby, a burst of notifications results in a single read.
+ *
+ * Each version of the content is kept in a dataspace of its own. A version
+ * is freed not before all sessions that obtained it have switched to a
+ * newer one, so no client ever sees its dataspace vanish or change.
  */
-class Fs_rom::Rom_session_component :
-	public Genode::Rpc_object<Genode::Rom_session>, public Sessions::Element
+class Fs_rom::Rom_file : public Rom_files::Element
 {
+	public:
+
+		/**
+		 * Version of the file content
+		 */
+		struct Version
+		{
+			Genode::Attached_ram_dataspace ds;
+
+			unsigned users = 0;   /* sessions that obtained the version */
+
+			Version(Genode::Env &env, size_t size)
+			: ds(env.ram(), env.rm(), size) { }
+		};
+
 	private:
 
 		Genode::Env          &_env;
+		Genode::Allocator    &_alloc;
 
 		File_system::Session &_fs;
 
 		enum { PATH_MAX_LEN = 512 };
 		typedef Genode::Path<PATH_MAX_LEN> Path;
 
+		/**
+		 * Maximum number of read packets in flight
+		 */
+		enum { MAX_READS_IN_FLIGHT = 4 };
+
 		/**
 		 * Name of requested file, interpreted at path into the file system
 		 */
@@ -73,9 +105,15 @@ class Fs_rom::Rom_session_component :
 		File_system::file_size_t _file_size = 0;
 
 		/**
-		 * Read offset of the file
+		 * Number of read packets in flight and their success
+		 */
+		unsigned _reads_in_flight = 0;
+		bool     _read_failed     = false;
+
+		/**
+		 * True if the file changed since the content was read
 		 */
-		File_system::seek_off_t _file_seek = 0;
+		bool _outdated = true;
 
 		/**
 		 * Handle of currently watched compound directory
@@ -86,14 +124,14 @@ class Fs_rom::Rom_session_component :
 		File_system::Node_handle _compound_dir_handle;
 
 		/**
-		 * Dataspace exposed as ROM module to the client
+		 * Current version of the file content, exposed to the clients
 		 */
-		Genode::Attached_ram_dataspace _file_ds;
+		Version *_version = nullptr;
 
 		/**
-		 * Signal destination for ROM file changes
+		 * Sessions that refer to the file
 		 */
-		Genode::Signal_context_capability _sigh;
+		Sessions _sessions;
 
 		/**
 		 * Open compound directory of specified file
@@ -181,35 +219,60 @@ class Fs_rom::Rom_session_component :
 				Genode::warning("could not track compound dir, giving up");
 		}
 
+		void _destroy_if_unused(Version *version)
+		{
+			if (version && version != _version && !version->users)
+				Genode::destroy(_alloc, version);
+		}
+
 		/**
-		 * Initialize '_file_ds' dataspace with file content
+		 * Read file content into '_version' with several packets in flight
 		 */
-		void _update_dataspace()
+		void _read_content()
 		{
-			using namespace File_system;
+			Tx_source &source = *_fs.tx();
 
-			/*
-			 * On each repeated call of this function, the dataspace is
-			 * replaced with a new one that contains the most current file
-			 * content. The dataspace is re-allocated if the new version
-			 * of the file has become bigger.
-			 */
-			{
-				File_handle const file_handle = _open_file(_fs, _file_path);
-				if (file_handle.valid()) {
-					File_system::file_size_t const new_file_size =
-						_fs.status(file_handle).size;
-
-					if (_file_ds.size() && (new_file_size > _file_size)) {
-						/* mark as invalid */
-						_file_ds.realloc(&_env.ram(), 0);
-						_file_size = 0;
-						_file_seek = 0;
-					}
+			size_t const chunk_size =
+				source.bulk_buffer_size() / (MAX_READS_IN_FLIGHT * 2);
+
+			File_system::seek_off_t seek = 0;
+			_read_failed = false;
+
+			while (seek < _file_size || _reads_in_flight) {
+
+				/* submit as many packets as possible */
+				while (seek < _file_size && source.ready_to_submit()
+				    && _reads_in_flight < MAX_READS_IN_FLIGHT) {
+
+					size_t const length = min(_file_size - seek, chunk_size);
+
+					File_system::Packet_descriptor packet;
+					try { packet = source.alloc_packet(length); }
+					catch (Tx_source::Packet_alloc_failed) { break; }
+
+					source.submit_packet(File_system::Packet_descriptor(
+						packet, _file_handle, File_system::Packet_descriptor::READ,
+						length, seek));
+
+					seek += length;
+					_reads_in_flight++;
 				}
-				_fs.close(file_handle);
+
+				/* process acks at the global signal handler */
+				_env.ep().wait_and_dispatch_one_io_signal();
 			}
 
+			if (_read_failed)
+				Genode::error(_file_path, ": reading the file failed");
+		}
+
+		/**
+		 * Read current file content into a new version
+		 */
+		void _update_dataspace()
+		{
+			using namespace File_system;
+
 			/* close and then re-open the file */
 			if (_file_handle.valid())
 				_fs.close(_file_handle);
@@ -220,8 +283,10 @@ class Fs_rom::Rom_session_component :
 			 * If we got the file, we can stop paying attention to the
 			 * compound directory.
 			 */
-			if (_file_handle.valid() && _compound_dir_handle.valid())
+			if (_file_handle.valid() && _compound_dir_handle.valid()) {
 				_fs.close(_compound_dir_handle);
+				_compound_dir_handle = File_system::Node_handle();
+			}
 
 			/* register for file changes */
 			if (_file_handle.valid())
@@ -231,40 +296,28 @@ class Fs_rom::Rom_session_component :
 			size_t const file_size = _file_handle.valid()
 			                       ? _fs.status(_file_handle).size : 0;
 
-			/* allocate new RAM dataspace according to file size */
-			if (file_size > 0) {
-				try {
-					_file_seek = 0;
-					_file_ds.realloc(&_env.ram(), file_size);
-					_file_size = file_size;
-				} catch (...) {
-					Genode::error("couldn't allocate memory for file, empty result");;
-					return;
-				}
-			} else {
+			if (!file_size) {
+				_file_size = 0;
 				_register_for_compound_dir_changes();
 				return;
 			}
 
-			/* read content from file */
-			Tx_source &source = *_fs.tx();
-			while (_file_seek < _file_size) {
-				/* if we cannot submit then process acknowledgements */
-				if (source.ready_to_submit()) {
-					size_t chunk_size = min(_file_size - _file_seek,
-					                        source.bulk_buffer_size() / 2);
-					File_system::Packet_descriptor
-						packet(source.alloc_packet(chunk_size),
-						       _file_handle,
-						       File_system::Packet_descriptor::READ,
-						       chunk_size,
-						       _file_seek);
-					source.submit_packet(packet);
-				}
-
-				/* process ack at the global signal handler */
-				_env.ep().wait_and_dispatch_one_io_signal();
+			/* allocate new RAM dataspace according to file size */
+			Version *version = nullptr;
+			try {
+				version = new (_alloc) Version(_env, file_size);
+			} catch (...) {
+				Genode::error("couldn't allocate memory for file, empty result");;
+				return;
 			}
+
+			/* the previous version stays alive while sessions refer to it */
+			Version *old = _version;
+			_version     = version;
+			_file_size   = file_size;
+			_destroy_if_unused(old);
+
+			_read_content();
 		}
 
 	public:
@@ -272,20 +325,15 @@ class Fs_rom::Rom_session_component :
 		/**
 		 * Constructor
 		 *
-		 * \param fs        file-system session to read the file from
-		 * \param filename  requested file name
-		 * \param sig_rec   signal receiver used to get notified about changes
-		 *                  within the compound directory (in the case when
-		 *                  the requested file could not be found at session-
-		 *                  creation time)
+		 * \param fs         file-system session to read the file from
+		 * \param file_path  requested file name
 		 */
-		Rom_session_component(Genode::Env &env,
-		                      File_system::Session &fs, const char *file_path)
+		Rom_file(Genode::Env &env, Genode::Allocator &alloc,
+		         File_system::Session &fs, const char *file_path)
 		:
-			_env(env), _fs(fs),
+			_env(env), _alloc(alloc), _fs(fs),
 			_file_path(file_path),
-			_file_handle(_open_file(_fs, _file_path)),
-			_file_ds(env.ram(), env.rm(), 0) /* realloc later */
+			_file_handle(_open_file(_fs, _file_path))
 		{
 			if (!_file_handle.valid())
 				_register_for_compound_dir_changes();
@@ -294,7 +342,7 @@ class Fs_rom::Rom_session_component :
 		/**
 		 * Destructor
 		 */
-		~Rom_session_component()
+		~Rom_file()
 		{
 			/* close re-open the file */
 			if (_file_handle.valid())
@@ -302,80 +350,179 @@ class Fs_rom::Rom_session_component :
 
 			if (_compound_dir_handle.valid())
 				_fs.close(_compound_dir_handle);
+
+			if (_version)
+				Genode::destroy(_alloc, _version);
 		}
 
+		bool has_path(char const *path) const { return _file_path == path; }
+
+		void add_session(Rom_session_component &session) {
+			_sessions.insert(&session); }
+
+		void remove_session(Rom_session_component &session) {
+			_sessions.remove(&session); }
+
+		bool unused() const { return !_sessions.first(); }
+
 		/**
-		 * Return dataspace with up-to-date content of file
+		 * Obtain up-to-date version of the file content
+		 *
+		 * \return  version, or nullptr if the file has no content
 		 */
-		Genode::Rom_dataspace_capability dataspace()
+		Version *acquire()
 		{
-			_update_dataspace();
-			Genode::Dataspace_capability ds = _file_ds.cap();
-			return Genode::static_cap_cast<Genode::Rom_dataspace>(ds);
+			if (_outdated) {
+				_outdated = false;
+				_update_dataspace();
+			}
+			if (_version)
+				_version->users++;
+
+			return _version;
 		}
 
-		void sigh(Genode::Signal_context_capability sigh) {
-			_sigh = sigh; }
+		/**
+		 * Release version obtained via 'acquire'
+		 */
+		void release(Version *version)
+		{
+			if (!version)
+				return;
+
+			version->users--;
+			_destroy_if_unused(version);
+		}
 
 		/**
-		 * If packet corresponds to this session then process and return true.
+		 * If packet corresponds to this file then process and return true.
 		 *
 		 * Called from the signal handler.
 		 */
-		bool process_packet(File_system::Packet_descriptor const packet)
+		inline bool process_packet(File_system::Packet_descriptor const packet);
+};
+
+
+/**
+ * A 'Rom_session_component' exports a single file of the file system
+ */
+class Fs_rom::Rom_session_component :
+	public Genode::Rpc_object<Genode::Rom_session>, public Sessions::Element
+{
+	private:
+
+		Rom_file &_file;
+
+		/**
+		 * Version of the file content handed out to the client
+		 */
+		Rom_file::Version *_version = nullptr;
+
+		/**
+		 * Signal destination for ROM file changes
+		 */
+		Genode::Signal_context_capability _sigh;
+
+	public:
+
+		Rom_session_component(Rom_file &file) : _file(file) {
+			_file.add_session(*this); }
+
+		~Rom_session_component()
 		{
-			switch (packet.operation()) {
-
-			case File_system::Packet_descriptor::CONTENT_CHANGED:
-				if (_file_handle == packet.handle() ||
-				    _compound_dir_handle == packet.handle())
-				{
-					if (_sigh.valid())
-						Genode::Signal_transmitter(_sigh).submit();
-					return true;
-				}
-				return false;
+			_file.release(_version);
+			_file.remove_session(*this);
+		}
 
-			case File_system::Packet_descriptor::READ: {
-				if (_file_handle != packet.handle())
-					return false;
+		Rom_file &file() { return _file; }
 
-				if (packet.position() > _file_seek || _file_seek >= _file_size) {
-						error("bad packet seek position");
-						_file_ds.realloc(&_env.ram(), 0);
-						return true;
-				}
+		/**
+		 * Inform client about a changed file
+		 */
+		void notify()
+		{
+			if (_sigh.valid())
+				Genode::Signal_transmitter(_sigh).submit();
+		}
 
-				size_t const n = min(packet.length(), _file_size - _file_seek);
-				memcpy(_file_ds.local_addr<char>()+_file_seek,
-				       _fs.tx()->packet_content(packet), n);
-				_file_seek += n;
-				return true;
-			}
+		/**
+		 * Return dataspace with up-to-date content of file
+		 */
+		Genode::Rom_dataspace_capability dataspace()
+		{
+			/* switch to the new version before releasing the old one */
+			Rom_file::Version *version = _file.acquire();
+			_file.release(_version);
+			_version = version;
 
-			default:
-				Genode::error("discarding strange packet acknowledgement");
-				return true;
-			}
-			return false;
+			Genode::Dataspace_capability ds;
+			if (_version)
+				ds = _version->ds.cap();
+
+			return Genode::static_cap_cast<Genode::Rom_dataspace>(ds);
 		}
+
+		void sigh(Genode::Signal_context_capability sigh) {
+			_sigh = sigh; }
 };
 
+
+bool Fs_rom::Rom_file::process_packet(File_system::Packet_descriptor const packet)
+{
+	switch (packet.operation()) {
+
+	case File_system::Packet_descriptor::CONTENT_CHANGED:
+		if (_file_handle == packet.handle() ||
+		    _compound_dir_handle == packet.handle())
+		{
+			_outdated = true;
+			for (Rom_session_component *s = _sessions.first(); s; s = s->next())
+				s->notify();
+
+			return true;
+		}
+		return false;
+
+	case File_system::Packet_descriptor::READ: {
+		if (_file_handle != packet.handle())
+			return false;
+
+		_reads_in_flight--;
+
+		if (!packet.succeeded() || packet.position() >= _file_size) {
+			_read_failed = true;
+			return true;
+		}
+
+		/* packets may be acknowledged out of order */
+		size_t const n = min(packet.length(), _file_size - packet.position());
+		memcpy(_version->ds.local_addr<char>() + packet.position(),
+		       _fs.tx()->packet_content(packet), n);
+		return true;
+	}
+
+	default:
+		Genode::error("discarding strange packet acknowledgement");
+		return true;
+	}
+	return false;
+}
+
+
 struct Fs_rom::Packet_handler : Genode::Io_signal_handler<Packet_handler>
 {
 	Tx_source &source;
 
-	/* list of open sessions */
-	Sessions sessions;
+	/* list of requested files */
+	Rom_files files;
 
 	void handle_packets()
 	{
 		while (source.ack_avail()) {
 			File_system::Packet_descriptor pack = source.get_acked_packet();
-			for (Rom_session_component *session = sessions.first();
-	   		     session; session = session->next())
+			for (Rom_file *file = files.first(); file; file = file->next())
 			{
-				if (session->process_packet(pack))
+				if (file->process_packet(pack))
 					break;
 			}
 			source.release_packet(pack);
@@ -404,6 +551,21 @@ class Fs_rom::Rom_root : public Genode::Root_component<Fs_rom::Rom_session_compo
 
 		Packet_handler _packet_handler { _env.ep(), *_fs.tx() };
 
+		/**
+		 * Look up file shared by all sessions for the path or create it
+		 */
+		Rom_file &_file(char const *path)
+		{
+			for (Rom_file *file = _packet_handler.files.first(); file;
+			     file = file->next())
+				if (file->has_path(path))
+					return *file;
+
+			Rom_file *file = new (_heap) Rom_file(_env, _heap, _fs, path);
+			_packet_handler.files.insert(file);
+			return *file;
+		}
+
 		Rom_session_component *_create_session(const char *args) override
 		{
 			Genode::Session_label const label = label_from_args(args);
@@ -412,17 +574,20 @@ class Fs_rom::Rom_root : public Genode::Root_component<Fs_rom::Rom_session_compo
 			Genode::log("request for ", label);
 
 			/* create new session for the requested file */
-			Rom_session_component *session = new (md_alloc())
-				Rom_session_component(_env, _fs, module_name.string());
-
-			_packet_handler.sessions.insert(session);
-			return session;
+			return new (md_alloc())
+				Rom_session_component(_file(module_name.string()));
 		}
 
 		void _destroy_session(Rom_session_component *session) override
 		{
-			_packet_handler.sessions.remove(session);
+			Rom_file &file = session->file();
 			Genode::destroy(md_alloc(), session);
+
+			/* release file when the last session referring to it vanishes */
+			if (file.unused()) {
+				_packet_handler.files.remove(&file);
+				Genode::destroy(_heap, &file);
+			}
 		}
 
 	public:
@@ -35,6 +35,14 @@ class File_system::Directory : public Node
 		Path       _path;
 		Allocator &_alloc;
 
+		/*
+		 * Index of the entry returned by the next 'readdir' on '_fd'
+		 *
+		 * A sequential traversal continues reading the directory stream
+		 * instead of rewinding it for each entry.
+		 */
+		mutable seek_off_t _cursor = 0;
+
 		unsigned long _inode(char const *path, bool create)
 		{
 			int ret;
@@ -144,29 +152,42 @@ class File_system::Directory : public Node
 
 			seek_off_t index = seek_offset / sizeof(Directory_entry);
 
-			/* seek to index and read entry */
-			struct dirent *dent;
-			rewinddir(_fd);
-			for (unsigned i = 0; i <= index; ++i) {
-				dent = readdir(_fd);
+			/* seek to index, rewind only if the cursor lies beyond it */
+			if (index < _cursor) {
+				rewinddir(_fd);
+				_cursor = 0;
 			}
+			for (; _cursor < index; ++_cursor)
+				if (!readdir(_fd))
+					return 0;
 
-			if (!dent)
-				return 0;
+			/* read as many entries as fit into the buffer */
+			size_t n = 0;
+			while (len - n >= sizeof(Directory_entry)) {
 
-			Directory_entry *e = (Directory_entry *)(dst);
+				struct dirent *dent = readdir(_fd);
+				if (!dent)
+					break;
 
-			switch (dent->d_type) {
-			case DT_REG: e->type = Directory_entry::TYPE_FILE;      break;
-			case DT_DIR: e->type = Directory_entry::TYPE_DIRECTORY; break;
-			case DT_LNK: e->type = Directory_entry::TYPE_SYMLINK;   break;
-			default:
-				return 0;
-			}
+				++_cursor;
 
-			strncpy(e->name, dent->d_name, sizeof(e->name));
+				Directory_entry *e = (Directory_entry *)(dst + n);
+
+				switch (dent->d_type) {
+				case DT_REG: e->type = Directory_entry::TYPE_FILE;      break;
+				case DT_DIR: e->type = Directory_entry::TYPE_DIRECTORY; break;
+				case DT_LNK: e->type = Directory_entry::TYPE_SYMLINK;   break;
+				default:
+					return n;
+				}
+
+				e->inode = dent->d_ino;
+				strncpy(e->name, dent->d_name, sizeof(e->name));
+
+				n += sizeof(Directory_entry);
+			}
 
-			return sizeof(Directory_entry);
+			return n;
 		}
 
 		size_t write(char const *src, size_t len, seek_off_t seek_offset)
@@ -182,6 +203,7 @@ class File_system::Directory : public Node
 			rewinddir(_fd);
 			while (readdir(_fd)) ++num;
 
+			_cursor = num;
 			return num;
 		}
 };
@@ -0,0 +1,206 @@
+/*
+ * \brief  Pool of threads that perform file I/O asynchronously
+ * \author Christian Helmuth
+ * \date   2017-06-14
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _IO_POOL_H_
+#define _IO_POOL_H_
+
+/* Genode includes */
+#include <base/thread.h>
+#include <base/semaphore.h>
+#include <util/fifo.h>
+
+/* local includes */
+#include <file.h>
+
+
+namespace File_system {
+	struct Io_job;
+	struct Io_completion;
+	class  Io_pool;
+
+	typedef Genode::Fifo<Io_job> Io_job_queue;
+}
+
+
+/**
+ * Interface for getting informed about executed I/O jobs
+ */
+struct File_system::Io_completion
+{
+	/**
+	 * Called by a pool thread after executing the job
+	 */
+	virtual void io_completed(Io_job &job) = 0;
+};
+
+
+/**
+ * Read or write operation of a packet on a file
+ */
+struct File_system::Io_job : Io_job_queue::Element
+{
+	Io_completion     *completion = nullptr;
+	File              *file       = nullptr;
+	char              *content    = nullptr;
+	Packet_descriptor  packet;
+	size_t             result     = 0;
+
+	void execute()
+	{
+		/* serialize with the RPC functions operating on the file */
+		file->lock();
+		Node_lock_guard guard(file);
+
+		switch (packet.operation()) {
+
+		case Packet_descriptor::READ:
+			result = file->read(content, packet.length(), packet.position());
+			return;
+
+		case Packet_descriptor::WRITE:
+			result = file->write(content, packet.length(), packet.position());
+			return;
+
+		default:
+			result = 0;
+		}
+	}
+};
+
+
+/**
+ * Threads that execute I/O jobs of all sessions
+ *
+ * Each thread blocks in a host system call while performing a job. Hence,
+ * a slow host disk access delays only the jobs of one thread instead of the
+ * whole server, and jobs complete in the order the host finishes them.
+ *
+ * The jobs of one file are executed one after another in the order of their
+ * submission. A job whose file is already in the works is deferred until
+ * the preceding job of the file is completed.
+ */
+class File_system::Io_pool
+{
+	private:
+
+		struct Worker : Genode::Thread
+		{
+			enum { STACK_SIZE = 4*1024*sizeof(long) };
+
+			Io_pool &_pool;
+
+			Worker(Genode::Env &env, Io_pool &pool)
+			: Genode::Thread(env, "io", STACK_SIZE), _pool(pool) { start(); }
+
+			void entry() override
+			{
+				for (;;)
+					_pool._execute_next_job();
+			}
+		};
+
+		Genode::Lock      _lock;
+		Genode::Semaphore _num_pending;
+		Io_job_queue      _pending;   /* ready for execution */
+		Io_job_queue      _running;
+		Io_job_queue      _deferred;  /* waiting for a job of the same file */
+
+		static Io_job *_job_of_file(Io_job_queue const &queue, File const *file)
+		{
+			for (Io_job *job = queue.head(); job; job = job->next())
+				if (job->file == file)
+					return job;
+			return nullptr;
+		}
+
+		/**
+		 * Return true if a job of the file is pending or running
+		 *
+		 * A file with deferred jobs always has a pending or running job.
+		 */
+		bool _in_the_works(File const *file) const
+		{
+			return _job_of_file(_pending, file) || _job_of_file(_running, file);
+		}
+
+		void _execute_next_job()
+		{
+			_num_pending.down();
+
+			Io_job *job = nullptr;
+			{
+				Genode::Lock::Guard guard(_lock);
+				job = _pending.dequeue();
+				if (job)
+					_running.enqueue(job);
+			}
+			if (!job)
+				return;
+
+			job->execute();
+
+			bool next_pending = false;
+			{
+				Genode::Lock::Guard guard(_lock);
+				_running.remove(job);
+
+				/* release the next job of the file */
+				if (Io_job *next = _job_of_file(_deferred, job->file)) {
+					_deferred.remove(next);
+					_pending.enqueue(next);
+					next_pending = true;
+				}
+			}
+			if (next_pending)
+				_num_pending.up();
+
+			job->completion->io_completed(*job);
+		}
+
+	public:
+
+		enum { DEFAULT_THREADS = 4, MAX_THREADS = 64 };
+
+		Io_pool(Genode::Env &env, Genode::Allocator &alloc, unsigned num_threads)
+		{
+			num_threads = Genode::max(1U, Genode::min(num_threads,
+			                                          (unsigned)MAX_THREADS));
+
+			/* the threads live as long as the server */
+			for (unsigned i = 0; i < num_threads; i++)
+				new (alloc) Worker(env, *this);
+		}
+
+		/**
+		 * Hand over a batch of jobs to the pool
+		 */
+		void submit(Io_job_queue &jobs)
+		{
+			unsigned num_jobs = 0;
+			{
+				Genode::Lock::Guard guard(_lock);
+				while (Io_job *job = jobs.dequeue()) {
+					if (_in_the_works(job->file)) {
+						_deferred.enqueue(job);
+						continue;
+					}
+					_pending.enqueue(job);
+					num_jobs++;
+				}
+			}
+			for (; num_jobs; num_jobs--)
+				_num_pending.up();
+		}
+};
+
+#endif /* _IO_POOL_H_ */
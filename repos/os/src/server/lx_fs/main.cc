@@ -23,6 +23,7 @@
 
 /* local includes */
 #include <directory.h>
+#include <io_pool.h>
 
 
 namespace File_system {
@@ -32,18 +33,65 @@ namespace File_system {
 }
 
 
-class File_system::Session_component : public Session_rpc_object
+class File_system::Session_component : public Session_rpc_object,
+                                       private Io_completion
 {
 	private:
 
+		enum { MAX_JOBS = TX_QUEUE_SIZE };
+
 		Genode::Env          &_env;
 		Allocator            &_md_alloc;
 		Directory            &_root;
 		Node_handle_registry  _handle_registry;
 		bool                  _writable;
+		Io_pool              &_io_pool;
 
 		Signal_handler<Session_component> _process_packet_dispatcher;
 
+		/*
+		 * Read and write packets on files are executed by the I/O pool
+		 * while the entrypoint continues to fetch packets. Jobs are
+		 * acknowledged in the order of their completion.
+		 */
+		Io_job        _jobs[MAX_JOBS];
+		Io_job_queue  _free_jobs;
+		Genode::Lock  _completion_lock;
+		Io_job_queue  _completed_jobs;          /* protected by lock */
+		unsigned      _jobs_in_flight = 0;      /* protected by lock */
+		bool          _draining       = false;  /* protected by lock */
+		Semaphore     _drained;
+
+
+		/******************************
+		 ** I/O-completion interface **
+		 ******************************/
+
+		/**
+		 * Called by the threads of the I/O pool
+		 */
+		void io_completed(Io_job &job) override
+		{
+			Signal_context_capability notify;
+			{
+				Genode::Lock::Guard guard(_completion_lock);
+
+				/* the entrypoint is already notified if jobs are pending */
+				if (_completed_jobs.empty())
+					notify = _process_packet_dispatcher;
+
+				_completed_jobs.enqueue(&job);
+				_jobs_in_flight--;
+
+				if (_draining) {
+					_drained.up();
+					return;
+				}
+			}
+			if (notify.valid())
+				Signal_transmitter(notify).submit();
+		}
+
 
 		/******************************
 		 ** Packet-stream processing **
@@ -91,7 +139,43 @@ class File_system::Session_component : public Session_rpc_object
 			tx_sink()->acknowledge_packet(packet);
 		}
 
-		void _process_packet()
+		/**
+		 * Prepare I/O job if the packet can be processed asynchronously
+		 *
+		 * All reads and writes of a file, including appending writes, are
+		 * executed as jobs so that the I/O pool keeps them in order.
+		 */
+		Io_job *_io_job(Packet_descriptor &packet, Node &node)
+		{
+			File *file = dynamic_cast<File *>(&node);
+			if (!file)
+				return nullptr;
+
+			switch (packet.operation()) {
+			case Packet_descriptor::READ:
+			case Packet_descriptor::WRITE: break;
+			default:
+				return nullptr;
+			}
+
+			char * const content = tx_sink()->packet_content(packet);
+			if (!content || (packet.length() > packet.size()))
+				return nullptr;
+
+			Io_job *job = _free_jobs.dequeue();
+			job->file    = file;
+			job->content = content;
+			job->packet  = packet;
+			job->result  = 0;
+			return job;
+		}
+
+		/**
+		 * Process packet or add it to the batch of I/O jobs
+		 *
+		 * \return true if the packet was added to the batch
+		 */
+		bool _process_packet(Io_job_queue &batch)
 		{
 			Packet_descriptor packet = tx_sink()->get_packet();
 
@@ -102,9 +186,37 @@ class File_system::Session_component : public Session_rpc_object
 				Node *node = _handle_registry.lookup_and_lock(packet.handle());
 				Node_lock_guard guard(node);
 
+				if (Io_job *job = _io_job(packet, *node)) {
+					batch.enqueue(job);
+					return true;
+				}
 				_process_packet_op(packet, *node);
 			}
 			catch (Invalid_handle) { Genode::error("Invalid_handle"); }
+			return false;
+		}
+
+		/**
+		 * Acknowledge completed I/O jobs as long as the client takes them
+		 */
+		void _ack_completed_jobs()
+		{
+			while (tx_sink()->ready_to_ack()) {
+
+				Io_job *job = nullptr;
+				{
+					Genode::Lock::Guard guard(_completion_lock);
+					job = _completed_jobs.dequeue();
+				}
+				if (!job)
+					return;
+
+				job->packet.length(job->result);
+				job->packet.succeeded(job->result > 0);
+				tx_sink()->acknowledge_packet(job->packet);
+
+				_free_jobs.enqueue(job);
+			}
 		}
 
 		/**
@@ -113,6 +225,11 @@ class File_system::Session_component : public Session_rpc_object
 		 */
 		void _process_packets()
 		{
+			_ack_completed_jobs();
+
+			Io_job_queue batch;
+			unsigned     batch_size = 0;
+
 			while (tx_sink()->packet_avail()) {
 
 				/*
@@ -128,10 +245,24 @@ class File_system::Session_component : public Session_rpc_object
 				 * for receiving any subsequent 'ready-to-ack' signals.
 				 */
 				if (!tx_sink()->ready_to_ack())
-					return;
+					break;
+
+				/* continue once a job completed if all jobs are in flight */
+				if (_free_jobs.empty())
+					break;
+
+				if (_process_packet(batch))
+					batch_size++;
+			}
+
+			if (batch.empty())
+				return;
 
-				_process_packet();
+			{
+				Genode::Lock::Guard guard(_completion_lock);
+				_jobs_in_flight += batch_size;
 			}
+			_io_pool.submit(batch);
 		}
 
 		/**
@@ -154,15 +285,22 @@ class File_system::Session_component : public Session_rpc_object
 		                  Genode::Env &env,
 		                  char const  *root_dir,
 		                  bool         writable,
-		                  Allocator   &md_alloc)
+		                  Allocator   &md_alloc,
+		                  Io_pool     &io_pool)
 		:
 			Session_rpc_object(env.ram().alloc(tx_buf_size), env.rm(), env.ep().rpc_ep()),
 			_env(env),
 			_md_alloc(md_alloc),
 			_root(*new (&_md_alloc) Directory(_md_alloc, root_dir, false)),
 			_writable(writable),
+			_io_pool(io_pool),
 			_process_packet_dispatcher(env.ep(), *this, &Session_component::_process_packets)
 		{
+			for (unsigned i = 0; i < MAX_JOBS; i++) {
+				_jobs[i].completion = this;
+				_free_jobs.enqueue(&_jobs[i]);
+			}
+
 			/*
 			 * Register '_process_packets' dispatch function as signal
 			 * handler for packet-avail and ready-to-ack signals.
@@ -176,6 +314,18 @@ class File_system::Session_component : public Session_rpc_object
 		 */
 		~Session_component()
 		{
+			/* wait until the I/O pool is done with the jobs of the session */
+			for (;;) {
+				{
+					Genode::Lock::Guard guard(_completion_lock);
+					if (!_jobs_in_flight)
+						break;
+
+					_draining = true;
+				}
+				_drained.down();
+			}
+
 			Dataspace_capability ds = tx_sink()->dataspace();
 			_env.ram().free(static_cap_cast<Ram_dataspace>(ds));
 			destroy(&_md_alloc, &_root);
@@ -319,6 +469,10 @@ class File_system::Root : public Root_component<Session_component>
 
 		Genode::Attached_rom_dataspace _config { _env, "config" };
 
+		Io_pool _io_pool { _env, *md_alloc(),
+		                   _config.xml().attribute_value("io_threads",
+		                                                 (unsigned)Io_pool::DEFAULT_THREADS) };
+
 	protected:
 
 		Session_component *_create_session(const char *args)
@@ -400,7 +554,8 @@ class File_system::Root : public Root_component<Session_component>
 
 			try {
 				return new (md_alloc())
-				       Session_component(tx_buf_size, _env, root_dir, writeable, *md_alloc());
+				       Session_component(tx_buf_size, _env, root_dir, writeable,
+				                         *md_alloc(), _io_pool);
 			}
 			catch (Lookup_failed) {
 				Genode::error("session root directory \"", Genode::Cstring(root), "\" "
@@ -0,0 +1,76 @@
+/*
+ * \brief  Sample kernels of the mixer
+ * \author Josef Soentgen
+ * \date   2017-07-12
+ *
+ * The kernels process blocks of 'LANES' samples by using the vector
+ * extensions of GCC. On x86, the compiler translates the operations to SSE
+ * instructions, on ARM to NEON instructions if the FPU supports them, and
+ * to scalar code otherwise. The samples of an Audio_out packet are not
+ * aligned to the vector size, hence the vector type is declared with the
+ * alignment of a single sample.
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _MIX_H_
+#define _MIX_H_
+
+namespace Mixer {
+
+	enum { LANES = 4 };
+
+	typedef float Samples __attribute__((vector_size(LANES*sizeof(float)),
+	                                     aligned(sizeof(float))));
+
+	/*
+	 * The number of samples 'n' passed to the kernels must be a multiple of
+	 * 'LANES', which is the case for every valid Audio_out period.
+	 */
+
+	/**
+	 * Store 'src' scaled by 'vol' in 'dst'
+	 */
+	static inline void scale(float *dst, float const *src, float vol, unsigned n)
+	{
+		Samples const v = Samples { } + vol;
+
+		for (unsigned i = 0; i < n; i += LANES)
+			*(Samples *)(dst + i) = *(Samples const *)(src + i) * v;
+	}
+
+	/**
+	 * Add 'src' scaled by 'vol' to 'dst'
+	 */
+	static inline void scale_add(float *dst, float const *src, float vol, unsigned n)
+	{
+		Samples const v = Samples { } + vol;
+
+		for (unsigned i = 0; i < n; i += LANES)
+			*(Samples *)(dst + i) += *(Samples const *)(src + i) * v;
+	}
+
+	/**
+	 * Clip 'dst' to [-1.0, 1.0] and scale it by 'vol'
+	 */
+	static inline void clip_scale(float *dst, float vol, unsigned n)
+	{
+		Samples const v   = Samples { } + vol;
+		Samples const max = Samples { } + 1.0f;
+		Samples const min = Samples { } - 1.0f;
+
+		for (unsigned i = 0; i < n; i += LANES) {
+			Samples s = *(Samples *)(dst + i);
+			s = s > max ? max : s;
+			s = s < min ? min : s;
+			*(Samples *)(dst + i) = s * v;
+		}
+	}
+}
+
+#endif /* _MIX_H_ */
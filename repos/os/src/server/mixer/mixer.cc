@@ -13,7 +13,8 @@
  * contains multiple input sessions (Audio_out::Session_elem). For every packet
  * in the output queue the mixer sums the corresponding packets from all input
  * sessions up. The volume level of an input packet is applied in a linear way
- * (sample_value * volume_level) and the output packet is clipped at [1.0,-1.0].
+ * (sample_value * volume_level) and the output packet is clipped at [1.0,-1.0]
+ * before the output volume level is applied.
  */
 
 /*
@@ -38,6 +39,9 @@
 #include <base/component.h>
 #include <base/log.h>
 
+/* local includes */
+#include "mix.h"
+
 
 static bool verbose = false;
 
@@ -144,14 +148,37 @@ class Audio_out::Mixer
 
 		Genode::Attached_rom_dataspace _config_rom { env, "config" };
 
+		/**
+		 * Return period requested from the output driver
+		 *
+		 * The period is configured via the 'period' attribute of the
+		 * '<config>' node and evaluated at startup only.
+		 */
+		unsigned _config_period()
+		{
+			unsigned const period =
+				_config_rom.xml().attribute_value("period", (unsigned)Audio_out::PERIOD);
+
+			if (valid_period(period))
+				return period;
+
+			Genode::warning("invalid period ", period, ", using ", (int)PERIOD);
+			return PERIOD;
+		}
+
 		/*
 		 * Mixer output Audio_out connection
 		 */
-		Connection  _left  { env, "left",  false, true };
-		Connection  _right { env, "right", false, true };;
+		Connection  _left  { env, "left",  false, true, _config_period() };
+		Connection  _right { env, "right", false, true, _config_period() };
 		Connection *_out[MAX_CHANNELS];
 		float       _out_volume[MAX_CHANNELS];
 
+		/*
+		 * Period of the output driver, which applies to all sessions
+		 */
+		unsigned const _period { _left.stream()->period() };
+
 		/*
 		 * Default settings used as fallback for new sessions
 		 */
@@ -296,30 +323,16 @@ class Audio_out::Mixer
 		/*
 		 * Mix input packet into output packet
 		 *
-		 * Packets are mixed in a linear way with min/max clipping.
+		 * Packets are summed up in a linear way. Clipping and the output
+		 * volume are applied once all input packets are mixed, see
+		 * '_mix_channel'.
 		 */
-		void _mix_packet(Packet *out, Packet *in, bool clear,
-		                 float const out_vol, float const vol)
+		void _mix_packet(Packet *out, Packet *in, bool clear, float const vol)
 		{
-			if (clear) {
-				for_each_index(Audio_out::PERIOD, [&] (int const i) {
-					out->content()[i]  = (in->content()[i] * vol);
-
-					if (out->content()[i] > 1) out->content()[i] = 1;
-					if (out->content()[i] < -1) out->content()[i] = -1;
-
-					out->content()[i] *= out_vol;
-				});
-			} else {
-				for_each_index(Audio_out::PERIOD, [&] (int const i) {
-					out->content()[i] += (in->content()[i] * vol);
-
-					if (out->content()[i] > 1) out->content()[i] = 1;
-					if (out->content()[i] < -1) out->content()[i] = -1;
-
-					out->content()[i] *= out_vol;
-				});
-			}
+			if (clear)
+				::Mixer::scale(out->content(), in->content(), vol, _period);
+			else
+				::Mixer::scale_add(out->content(), in->content(), vol, _period);
 
 			/* mark the packet as processed by invalidating it */
 			in->invalidate();
@@ -357,7 +370,7 @@ class Audio_out::Mixer
 						/* skip if packet has been processed or was already played */
 						if ((!in->valid() && !mix_all) || in->played()) return;
 
-						_mix_packet(out, in, clear, out_vol, session.volume);
+						_mix_packet(out, in, clear, session.volume);
 
 						clear = false;
 					});
@@ -371,6 +384,9 @@ class Audio_out::Mixer
 					mix_all = true;
 				});
 
+			if (!clear)
+				::Mixer::clip_scale(out->content(), out_vol, _period);
+
 			return !clear;
 		}
 
@@ -549,6 +565,11 @@ class Audio_out::Mixer
 			_out[LEFT]->progress_sigh(Genode::Signal_context_capability());
 		}
 
+		/**
+		 * Get number of samples per packet
+		 */
+		unsigned period() const { return _period; }
+
 		/**
 		 * Get current playback position of output stream
 		 */
@@ -615,6 +636,8 @@ class Audio_out::Session_component : public Audio_out::Session_elem
 		                  Mixer           &mixer)
 		: Session_elem(env, label, mixer.sig_cap()), _mixer(mixer)
 		{
+			stream()->period(_mixer.period());
+
 			Session_elem::number = number;
 			_mixer.add_session(Session_elem::number, *this);
 		}
@@ -683,6 +706,19 @@ class Audio_out::Root : public Audio_out::Root_component
 			if (ch == Channel::Number::INVALID)
 				throw Genode::Service_denied();
 
+			/*
+			 * All sessions are mixed at the period of the output. A client
+			 * that is unaware of the period would submit packets that are
+			 * played only partially.
+			 */
+			unsigned const period =
+				Arg_string::find_arg(args, "period").ulong_value(PERIOD);
+			if (period != _mixer.period()) {
+				Genode::error("session '", Cstring(label), "' requested period ",
+				              period, ", mixer period is ", _mixer.period());
+				throw Genode::Service_denied();
+			}
+
 			Session_component *session = new (md_alloc())
 				Session_component(_env, label, (Channel::Number)ch, _mixer);
 
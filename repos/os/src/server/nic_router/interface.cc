@@ -15,6 +15,7 @@
 #include <net/tcp.h>
 #include <net/udp.h>
 #include <net/arp.h>
+#include <net/internet_checksum.h>
 
 /* local includes */
 #include <interface.h>
@@ -75,23 +76,49 @@ static void _link_packet(uint8_t  const  prot,
 }
 
 
-static void _update_checksum(uint8_t       const prot,
-                             void         *const prot_base,
-                             size_t        const prot_size,
-                             Ipv4_address  const src,
-                             Ipv4_address  const dst)
+static uint16_t _checksum(uint8_t const prot, void *const prot_base)
 {
 	switch (prot) {
-	case Tcp_packet::IP_ID:
-		((Tcp_packet *)prot_base)->update_checksum(src, dst, prot_size);
-		return;
-	case Udp_packet::IP_ID:
-		((Udp_packet *)prot_base)->update_checksum(src, dst);
-		return;
+	case Tcp_packet::IP_ID: return (*(Tcp_packet *)prot_base).checksum();
+	case Udp_packet::IP_ID: return (*(Udp_packet *)prot_base).checksum();
 	default: throw Interface::Bad_transport_protocol(); }
 }
 
 
+static void _checksum(uint8_t  const prot,
+                      void    *const prot_base,
+                      uint16_t const checksum)
+{
+	switch (prot) {
+	case Tcp_packet::IP_ID: (*(Tcp_packet *)prot_base).checksum(checksum); return;
+	case Udp_packet::IP_ID: (*(Udp_packet *)prot_base).checksum(checksum); return;
+	default: throw Interface::Bad_transport_protocol(); }
+}
+
+
+static uint16_t _adapt_checksum(uint16_t     const  checksum,
+                                Ipv4_address const &old_ip,
+                                Ipv4_address const &new_ip)
+{
+	if (old_ip == new_ip) {
+		return checksum; }
+
+	return internet_checksum_update(checksum, old_ip.addr, new_ip.addr,
+	                                Ipv4_packet::ADDR_LEN);
+}
+
+
+static uint16_t _adapt_checksum(uint16_t const  checksum,
+                                Port     const &old_port,
+                                Port     const &new_port)
+{
+	if (old_port == new_port) {
+		return checksum; }
+
+	return internet_checksum_update(checksum, old_port.value, new_port.value);
+}
+
+
 static Port _dst_port(uint8_t const prot, void *const prot_base)
 {
 	switch (prot) {
@@ -143,19 +170,50 @@ static void *_prot_base(uint8_t const  prot,
 }
 
 
+/**
+ * Update the checksums of a packet according to its rewritten addresses and
+ * ports instead of recalculating them over the whole packet (RFC 1624)
+ */
+static void _adapt_checksums(Ipv4_packet        &ip,
+                             uint8_t      const  prot,
+                             void        *const  prot_base,
+                             Link_side_id const &orig)
+{
+	Ipv4_address const src_ip = ip.src();
+	Ipv4_address const dst_ip = ip.dst();
+
+	uint16_t ip_sum = ip.checksum();
+	ip_sum = _adapt_checksum(ip_sum, orig.src_ip, src_ip);
+	ip_sum = _adapt_checksum(ip_sum, orig.dst_ip, dst_ip);
+	ip.checksum(ip_sum);
+
+	/* a zero UDP checksum means that the sender did not calculate one */
+	uint16_t sum = _checksum(prot, prot_base);
+	bool const udp = prot == Udp_packet::IP_ID;
+	if (udp && !sum) {
+		return; }
+
+	/* the pseudo header covers the IP addresses as well */
+	sum = _adapt_checksum(sum, orig.src_ip,   src_ip);
+	sum = _adapt_checksum(sum, orig.dst_ip,   dst_ip);
+	sum = _adapt_checksum(sum, orig.src_port, _src_port(prot, prot_base));
+	sum = _adapt_checksum(sum, orig.dst_port, _dst_port(prot, prot_base));
+	_checksum(prot, prot_base, udp && !sum ? 0xffff : sum);
+}
+
+
 /***************
  ** Interface **
  ***************/
 
-void Interface::_pass_ip(Ethernet_frame &eth,
-                         size_t   const  eth_size,
-                         Ipv4_packet    &ip,
-                         uint8_t  const  prot,
-                         void    *const  prot_base,
-                         size_t   const  prot_size)
+void Interface::_pass_ip(Ethernet_frame     &eth,
+                         size_t       const  eth_size,
+                         Ipv4_packet        &ip,
+                         uint8_t      const  prot,
+                         void        *const  prot_base,
+                         Link_side_id const &orig)
 {
-	_update_checksum(prot, prot_base, prot_size, ip.src(), ip.dst());
-	ip.checksum(Ipv4_packet::calculate_checksum(ip));
+	_adapt_checksums(ip, prot, prot_base, orig);
 	_send(eth, eth_size);
 }
 
@@ -270,7 +328,6 @@ void Interface::_nat_link_and_pass(Ethernet_frame      &eth,
                                    Ipv4_packet         &ip,
                                    uint8_t       const  prot,
                                    void         *const  prot_base,
-                                   size_t        const  prot_size,
                                    Link_side_id  const &local,
                                    Interface           &interface)
 {
@@ -288,7 +345,7 @@ void Interface::_nat_link_and_pass(Ethernet_frame      &eth,
 	Link_side_id const remote = { ip.dst(), _dst_port(prot, prot_base),
 	                              ip.src(), _src_port(prot, prot_base) };
 	_new_link(prot, local, remote_port_alloc, interface, remote);
-	interface._pass_ip(eth, eth_size, ip, prot, prot_base, prot_size);
+	interface._pass_ip(eth, eth_size, ip, prot, prot_base, local);
 }
 
 
@@ -325,7 +382,7 @@ void Interface::_handle_ip(Ethernet_frame          &eth,
 		_src_port(prot, prot_base, remote_side.dst_port());
 		_dst_port(prot, prot_base, remote_side.src_port());
 
-		interface._pass_ip(eth, eth_size, ip, prot, prot_base, prot_size);
+		interface._pass_ip(eth, eth_size, ip, prot, prot_base, local);
 		_link_packet(prot, prot_base, link, client);
 		return;
 	}
@@ -343,8 +400,8 @@ void Interface::_handle_ip(Ethernet_frame          &eth,
 
 			_adapt_eth(eth, eth_size, rule.to(), pkt, interface);
 			ip.dst(rule.to());
-			_nat_link_and_pass(eth, eth_size, ip, prot, prot_base, prot_size,
-			                   local, interface);
+			_nat_link_and_pass(eth, eth_size, ip, prot, prot_base, local,
+			                   interface);
 			return;
 		}
 		catch (Forward_rule_tree::No_match) { }
@@ -363,8 +420,8 @@ void Interface::_handle_ip(Ethernet_frame          &eth,
 			    " ", permit_rule); }
 
 		_adapt_eth(eth, eth_size, local.dst_ip, pkt, interface);
-		_nat_link_and_pass(eth, eth_size, ip, prot, prot_base, prot_size,
-		                   local, interface);
+		_nat_link_and_pass(eth, eth_size, ip, prot, prot_base, local,
+		                   interface);
 		return;
 	}
 	catch (Transport_rule_list::No_match) { }
@@ -380,7 +437,7 @@ void Interface::_handle_ip(Ethernet_frame          &eth,
 			log("Using IP rule: ", rule); }
 
 		_adapt_eth(eth, eth_size, local.dst_ip, pkt, interface);
-		interface._pass_ip(eth, eth_size, ip, prot, prot_base, prot_size);
+		interface._pass_ip(eth, eth_size, ip, prot, prot_base, local);
 		return;
 	}
 	catch (Ip_rule_list::No_match) { }
@@ -19,34 +19,62 @@
 #include <os/session_policy.h>
 #include <root/component.h>
 #include <block_session/rpc_object.h>
+#include <rm_session/connection.h>
+#include <region_map/client.h>
+#include <timer_session/connection.h>
+#include <util/retry.h>
 
 #include "gpt.h"
+#include "scheduler.h"
 
 namespace Block {
 
 	using namespace Genode;
 
+	struct Transfer_buffer;
 	class Session_component;
 	class Root;
 };
 
 
+/**
+ * Buffer for the block data exchanged with a client
+ *
+ * If possible, the buffer is a window into the packet buffer of the back-end
+ * session so that requests can be forwarded without copying. Otherwise, it
+ * is a RAM dataspace of its own.
+ */
+struct Block::Transfer_buffer
+{
+	Dataspace_capability      ds;
+	Ram_dataspace_capability  ram_ds;
+	Capability<Region_map>    region_map;
+	Driver::Transfer_range   *range = nullptr;
+};
+
+
 class Block::Session_component : public Block::Session_rpc_object,
-                                 public List<Block::Session_component>::Element,
+                                 public Block::Io_queue,
                                  public Block_dispatcher
 {
 	private:
 
-		Ram_dataspace_capability          _rq_ds;
-		addr_t                            _rq_phys;
+		Transfer_buffer const             _rq_buffer;
 		Partition                        *_partition;
+		Session_label const               _label;
 		Signal_handler<Session_component> _sink_ack;
 		Signal_handler<Session_component> _sink_submit;
-		bool                              _req_queue_full;
 		bool                              _ack_queue_full;
-		Packet_descriptor                 _p_to_handle;
 		unsigned                          _p_in_fly;
 		Block::Driver                    &_driver;
+		Io_scheduler                     &_scheduler;
+		Timer::Connection                *_timer;
+
+		/**
+		 * Return current time in microseconds if latencies are measured
+		 */
+		unsigned long _now_us() {
+			return _timer ? _timer->curr_time().trunc_to_plain_us().value : 0; }
 
 		/**
 		 * Acknowledge a packet already handled
@@ -67,31 +95,42 @@ class Block::Session_component : public Block::Session_rpc_object,
 			return p.block_number() + p.block_count() <= _partition->sectors; }
 
 		/**
-		 * Handle a single request
+		 * Return true if the packet can be forwarded without copying
+		 *
+		 * This is the case if the client buffer is part of the back end's
+		 * packet buffer and the packet is aligned like packets allocated at
+		 * the back end.
+		 */
+		bool _direct(Packet_descriptor const &p) const
+		{
+			enum { ALIGN_MASK = (1UL << Packet_descriptor::PACKET_ALIGNMENT) - 1 };
+			return _rq_buffer.range && !(p.offset() & ALIGN_MASK);
+		}
+
+		/**
+		 * Check a new request and put it into the queue
 		 */
-		void _handle_packet(Packet_descriptor packet)
+		void _queue_packet(Packet_descriptor packet)
 		{
-			_p_to_handle = packet;
-			_p_to_handle.succeeded(false);
+			packet.succeeded(false);
 
 			/* ignore invalid packets */
-			if (!packet.size() || !_range_check(_p_to_handle)) {
-				_ack_packet(_p_to_handle);
+			if (!packet.size() || !_range_check(packet)) {
+				_ack_packet(packet);
 				return;
 			}
 
-			bool write   = _p_to_handle.operation() == Packet_descriptor::WRITE;
-			sector_t off = _p_to_handle.block_number() + _partition->lba;
-			size_t cnt   = _p_to_handle.block_count();
-			void* addr   = tx_sink()->packet_content(_p_to_handle);
-			try {
-				_driver.io(write, off, cnt, addr, *this, _p_to_handle);
-			} catch (Block::Session::Tx::Source::Packet_alloc_failed) {
-				if (!_req_queue_full) {
-					_req_queue_full = true;
-					Session_component::wait_queue().insert(this);
-				}
+			/* ignore packets whose buffer does not hold the blocks */
+			if (!tx_sink()->packet_content(packet) ||
+			    packet.size() < packet.block_count() * _driver.blk_size()) {
+				_ack_packet(packet);
+				return;
 			}
+
+			Client_request request;
+			request.packet     = packet;
+			request.arrival_us = _now_us();
+			enqueue(request);
 		}
 
 		/**
@@ -103,13 +142,15 @@ class Block::Session_component : public Block::Session_rpc_object,
 
 			/*
 			 * as long as more packets are available, and we're able to ack
-			 * them, and the driver's request queue isn't full,
-			 * direct the packet request to the driver backend
+			 * them, and our request queue isn't full, queue the packet
+			 * request for the scheduler
 			 */
-			for (; !_req_queue_full && tx_sink()->packet_avail() &&
+			for (; !full() && tx_sink()->packet_avail() &&
 					 !_ack_queue_full; _p_in_fly++,
 					 _ack_queue_full = _p_in_fly >= tx_sink()->ack_slots_free())
-					_handle_packet(tx_sink()->get_packet());
+					_queue_packet(tx_sink()->get_packet());
+
+			_scheduler.schedule();
 		}
 
 		/**
@@ -117,75 +158,160 @@ class Block::Session_component : public Block::Session_rpc_object,
 		 */
 		void _ready_to_ack() { _packet_avail(); }
 
+	protected:
+
+		/**
+		 * Forward queued request to the driver backend
+		 *
+		 * Requests of the zero-copy path that are adjacent on disk as well
+		 * as in the transfer buffer are merged into one request.
+		 */
+		size_t _submit(Io_queue::Entry &head) override
+		{
+			Packet_descriptor const &p = head.request.packet;
+
+			bool const   write = p.operation() == Packet_descriptor::WRITE;
+			sector_t const off = p.block_number() + _partition->lba;
+			size_t const   blk = _driver.blk_size();
+
+			try {
+				if (!_direct(p)) {
+					_driver.io(write, off, p.block_count(),
+					           tx_sink()->packet_content(p), *this, head.request);
+
+					size_t const cnt = p.block_count();
+					_remove(head);
+					return cnt;
+				}
+
+				Io_queue::Entry *merged[Driver::MAX_MERGED] = { &head };
+				Client_request   requests[Driver::MAX_MERGED];
+				requests[0] = head.request;
+
+				size_t const max_cnt = _driver.max_request_blocks();
+
+				unsigned n   = 1;
+				size_t   cnt = p.block_count();
+				for (; n < Driver::MAX_MERGED; n++) {
+
+					Io_queue::Entry const &last = *merged[n - 1];
+					Packet_descriptor const &lp = last.request.packet;
+
+					/* the data of the previous request must fill its packet */
+					if (lp.size() != lp.block_count() * blk)
+						break;
+
+					Io_queue::Entry *e = _successor(last, [&] (Io_queue::Entry const &s) {
+						Packet_descriptor const &sp = s.request.packet;
+						return sp.operation() == p.operation()
+						    && sp.offset() == lp.offset() + (off_t)lp.size(); });
+
+					if (!e || cnt + e->request.packet.block_count() > max_cnt)
+						break;
+
+					merged[n]   = e;
+					requests[n] = e->request;
+					cnt        += e->request.packet.block_count();
+				}
+
+				_driver.io_direct(write, off, cnt, p.offset(), *this,
+				                  requests, n, *_rq_buffer.range);
+
+				for (unsigned i = 0; i < n; i++)
+					_remove(*merged[i]);
+
+				return cnt;
+
+			} catch (Block::Session::Tx::Source::Packet_alloc_failed) {
+				return 0; }
+		}
+
 	public:
 
 		/**
 		 * Constructor
+		 *
+		 * \param weight  share of the back end relative to other sessions
+		 * \param timer   timer used for measuring latencies, or nullptr
 		 */
-		Session_component(Ram_dataspace_capability  rq_ds,
+		Session_component(Transfer_buffer const    &rq_buffer,
 		                  Partition                *partition,
+		                  Session_label const      &label,
+		                  unsigned                  weight,
 		                  Genode::Entrypoint       &ep,
 		                  Genode::Region_map       &rm,
-		                  Block::Driver            &driver)
-		: Session_rpc_object(rm, rq_ds, ep.rpc_ep()),
-		  _rq_ds(rq_ds),
-		  _rq_phys(Dataspace_client(_rq_ds).phys_addr()),
+		                  Block::Driver            &driver,
+		                  Io_scheduler             &scheduler,
+		                  Timer::Connection        *timer)
+		: Session_rpc_object(rm, rq_buffer.ds, ep.rpc_ep()),
+		  Io_queue(weight),
+		  _rq_buffer(rq_buffer),
 		  _partition(partition),
+		  _label(label),
 		  _sink_ack(ep, *this, &Session_component::_ready_to_ack),
 		  _sink_submit(ep, *this, &Session_component::_packet_avail),
-		  _req_queue_full(false),
 		  _ack_queue_full(false),
 		  _p_in_fly(0),
-		  _driver(driver)
+		  _driver(driver),
+		  _scheduler(scheduler),
+		  _timer(timer)
 		{
 			_tx.sigh_ready_to_ack(_sink_ack);
 			_tx.sigh_packet_avail(_sink_submit);
+
+			_scheduler.attach(*this);
 		}
 
 		~Session_component()
 		{
+			_scheduler.detach(*this);
 			_driver.remove_dispatcher(*this);
-
-			if (_req_queue_full)
-				wait_queue().remove(this);
 		}
 
-		Ram_dataspace_capability const rq_ds() const { return _rq_ds; }
+		Transfer_buffer const &rq_buffer() const { return _rq_buffer; }
 		Partition *partition() { return _partition; }
+		Session_label const &label() const { return _label; }
 
-		void dispatch(Packet_descriptor &request, Packet_descriptor &reply)
+		void report(Xml_generator &xml) override
 		{
-			if (request.operation() == Block::Packet_descriptor::READ) {
+			Io_queue::Stats const &s = stats();
+
+			xml.node("session", [&] () {
+				xml.attribute("label",    _label);
+				xml.attribute("weight",   weight());
+				xml.attribute("requests", s.requests);
+				xml.attribute("blocks",   s.blocks);
+				if (_timer) {
+					xml.attribute("avg_latency_us",
+					              s.requests ? s.latency_us / s.requests : 0);
+					xml.attribute("max_latency_us", s.max_latency_us);
+				}
+			});
+			reset_max_latency();
+		}
+
+		void dispatch(Client_request &request, Packet_descriptor &reply,
+		              bool copy)
+		{
+			Packet_descriptor &packet = request.packet;
+
+			if (copy && packet.operation() == Block::Packet_descriptor::READ) {
 				void *src =
 					_driver.session().tx()->packet_content(reply);
 				Genode::size_t sz =
-					request.block_count() * _driver.blk_size();
-				Genode::memcpy(tx_sink()->packet_content(request), src, sz);
+					packet.block_count() * _driver.blk_size();
+				Genode::memcpy(tx_sink()->packet_content(packet), src, sz);
 			}
-			request.succeeded(reply.succeeded());
-			_ack_packet(request);
+			packet.succeeded(reply.succeeded());
+			_ack_packet(packet);
+
+			completed(packet.block_count(),
+			          _timer ? _now_us() - request.arrival_us : 0);
 
 			if (_ack_queue_full)
 				_packet_avail();
 		}
 
-		static List<Session_component>& wait_queue()
-		{
-			static List<Session_component> l;
-			return l;
-		}
-
-		static void wake_up()
-		{
-			for (; Session_component *c = wait_queue().first();)
-			{
-				wait_queue().remove(c);
-				c->_req_queue_full = false;
-				c->_handle_packet(c->_p_to_handle);
-				c->_packet_avail();
-			}
-		}
-
 		/*******************************
 		 **  Block session interface  **
 		 *******************************/
@@ -214,14 +340,101 @@ class Block::Root :
 		Genode::Xml_node        _config;
 		Block::Driver          &_driver;
 		Block::Partition_table &_table;
+		Block::Io_scheduler    &_scheduler;
+		Timer::Connection      *_timer;
 
 	protected:
 
+		/*
+		 * RM session for creating the windows into the back-end buffer,
+		 * requests are copied if it is not available
+		 */
+		Genode::Constructible<Genode::Rm_connection> _rm;
+		bool _rm_unavailable = false;
+
+		bool _rm_available()
+		{
+			if (!_rm.constructed() && !_rm_unavailable) {
+				try { _rm.construct(_env); }
+				catch (...) {
+					warning("no RM session available, copy requests");
+					_rm_unavailable = true;
+				}
+			}
+			return _rm.constructed();
+		}
+
+		enum { PAGE_SIZE_LOG2 = 12 };
+
+		/**
+		 * Execute 'fn', upgrading the shared RM session if it runs out of quota
+		 *
+		 * The initial quota of the RM session covers only a few region maps,
+		 * yet each session gets one.
+		 */
+		template <typename FN>
+		void _with_rm_upgrade(FN const &fn)
+		{
+			enum { ATTEMPTS = 4 };
+
+			retry<Out_of_ram>(
+				[&] () {
+					retry<Out_of_caps>(fn, [&] () { _rm->upgrade_caps(2); },
+					                   ATTEMPTS); },
+				[&] () { _rm->upgrade_ram(8*1024); },
+				ATTEMPTS);
+		}
+
+		/**
+		 * Set up transfer buffer of a new session
+		 */
+		Transfer_buffer _alloc_transfer_buffer(size_t size)
+		{
+			Transfer_buffer buffer;
+
+			if (_rm_available())
+				buffer.range = _driver.alloc_transfer_range(size);
+
+			if (buffer.range) {
+				try {
+					size = align_addr(size, PAGE_SIZE_LOG2);
+					_with_rm_upgrade([&] () {
+						buffer.region_map = _rm->create(size); });
+
+					Region_map_client rm(buffer.region_map);
+					_with_rm_upgrade([&] () {
+						rm.attach_at(_driver.buffer_ds(), 0, size,
+						             buffer.range->offset()); });
+					buffer.ds = rm.dataspace();
+					return buffer;
+				} catch (Out_of_ram) {
+				} catch (Out_of_caps) {
+				} catch (Region_map::Region_conflict) {
+				} catch (Region_map::Invalid_dataspace) { }
+
+				warning("could not share back-end buffer, copy requests");
+				if (buffer.region_map.valid())
+					_rm->destroy(buffer.region_map);
+				_driver.free_transfer_range(*buffer.range);
+				buffer = Transfer_buffer();
+			}
+
+			buffer.ram_ds = _env.ram().alloc(size);
+			buffer.ds     = buffer.ram_ds;
+			return buffer;
+		}
+
 		void _destroy_session(Session_component *session) override
 		{
-			Ram_dataspace_capability rq_ds = session->rq_ds();
+			Transfer_buffer const rq_buffer = session->rq_buffer();
 			Genode::Root_component<Session_component>::_destroy_session(session);
-			_env.ram().free(rq_ds);
+
+			if (rq_buffer.range) {
+				_rm->destroy(rq_buffer.region_map);
+				_driver.free_transfer_range(*rq_buffer.range);
+			} else {
+				_env.ram().free(rq_buffer.ram_ds);
+			}
 		}
 
 		/**
@@ -230,6 +443,7 @@ class Block::Root :
 		Session_component *_create_session(const char *args) override
 		{
 			long num = -1;
+			unsigned weight = 1;
 
 			Session_label const label = label_from_args(args);
 			char const *label_str = label.string();
@@ -239,6 +453,9 @@ class Block::Root :
 				/* read partition attribute */
 				policy.attribute("partition").value(&num);
 
+				/* share of the device relative to other sessions */
+				weight = policy.attribute_value("weight", weight);
+
 			} catch (Xml_node::Nonexistent_attribute) {
 				error("policy does not define partition number for for '",
 				      label_str, "'");
@@ -280,11 +497,11 @@ class Block::Root :
 				throw Insufficient_ram_quota();
 			}
 
-			Ram_dataspace_capability ds_cap;
-			ds_cap = _env.ram().alloc(tx_buf_size);
+			Transfer_buffer const rq_buffer = _alloc_transfer_buffer(tx_buf_size);
 			Session_component *session = new (md_alloc())
-				Session_component(ds_cap, _table.partition(num),
-				                  _env.ep(), _env.rm(), _driver);
+				Session_component(rq_buffer, _table.partition(num), label,
+				                  weight, _env.ep(), _env.rm(), _driver,
+				                  _scheduler, _timer);
 
 			log("session opened at partition ", num, " for '", label_str, "'");
 			return session;
@@ -292,10 +509,18 @@ class Block::Root :
 
 	public:
 
+		/**
+		 * Constructor
+		 *
+		 * \param timer  timer used for measuring the latencies of requests,
+		 *               or nullptr
+		 */
 		Root(Genode::Env &env, Genode::Xml_node config, Genode::Heap &heap,
-		     Block::Driver &driver, Block::Partition_table &table)
+		     Block::Driver &driver, Block::Partition_table &table,
+		     Block::Io_scheduler &scheduler, Timer::Connection *timer)
 		: Root_component(env.ep(), heap), _env(env), _config(config),
-		  _driver(driver), _table(table) { }
+		  _driver(driver), _table(table), _scheduler(scheduler),
+		  _timer(timer) { }
 };
 
 #endif /* _PART_BLK__COMPONENT_H_ */
@@ -23,8 +23,22 @@
 #include <block_session/connection.h>
 
 namespace Block {
-	class Block_dispatcher;
-	class Driver;
+	struct Client_request;
+	class  Block_dispatcher;
+	class  Io_scheduler;
+	class  Driver;
+};
+
+
+/**
+ * Client request as forwarded to the back end
+ */
+struct Block::Client_request
+{
+	Packet_descriptor packet;
+
+	/* time of arrival at the server in microseconds, used for statistics */
+	unsigned long arrival_us = 0;
 };
 
 
@@ -32,7 +46,14 @@ class Block::Block_dispatcher
 {
 	public:
 
-		virtual void dispatch(Packet_descriptor&, Packet_descriptor&) = 0;
+		/**
+		 * Complete client request
+		 *
+		 * \param copy  true if the request was forwarded via a packet of
+		 *              the back end's own and a read result must be copied
+		 */
+		virtual void dispatch(Client_request&, Packet_descriptor&,
+		                      bool copy) = 0;
 };
 
 
@@ -41,7 +62,8 @@ bool operator== (const Block::Packet_descriptor& p1,
 {
 	return p1.operation()    == p2.operation()    &&
 	       p1.block_number() == p2.block_number() &&
-	       p1.block_count()  == p2.block_count();
+	       p1.block_count()  == p2.block_count()  &&
+	       p1.offset()       == p2.offset();
 }
 
 
@@ -49,72 +71,182 @@ class Block::Driver
 {
 	public:
 
+	/**
+	 * Range of the back end's packet buffer used as client buffer
+	 *
+	 * A client session whose transport buffer is located within the packet
+	 * buffer of the back-end session can have its requests forwarded
+	 * without copying. The packet offsets just need to be translated by
+	 * the offset of the range.
+	 */
+	class Transfer_range
+	{
+		private:
+
+			friend class Driver;
+
+			Genode::off_t const _offset;
+
+			/* number of requests in flight at the back end */
+			unsigned _pending  = 0;
+			bool     _released = false;
+
+		public:
+
+			Transfer_range(Genode::off_t offset) : _offset(offset) { }
+
+			Genode::off_t offset() const { return _offset; }
+	};
+
+	/**
+	 * Maximum number of adjacent client requests merged into one request
+	 */
+	enum { MAX_MERGED = 8 };
+
 	class Request : public Genode::List<Request>::Element
 	{
 		private:
 
-			Block_dispatcher &_dispatcher;
-			Packet_descriptor _cli;
+			Block_dispatcher *_dispatcher;
+			Client_request    _cli[MAX_MERGED];
+			unsigned          _num_cli;
 			Packet_descriptor _srv;
+			Transfer_range   *_range;
 
 		public:
 
-			Request(Block_dispatcher &d,
-			        Packet_descriptor &cli,
-			        Packet_descriptor &srv)
-			: _dispatcher(d), _cli(cli), _srv(srv) {}
+			Request(Block_dispatcher     &d,
+			        Client_request const *cli,
+			        unsigned              num_cli,
+			        Packet_descriptor    &srv,
+			        Transfer_range       *range = nullptr)
+			: _dispatcher(&d), _num_cli(Genode::min(num_cli, (unsigned)MAX_MERGED)),
+			  _srv(srv), _range(range)
+			{
+				for (unsigned i = 0; i < _num_cli; i++)
+					_cli[i] = cli[i];
+			}
 
 			bool handle(Packet_descriptor& reply)
 			{
 				bool ret =  reply == _srv;
-				if (ret) _dispatcher.dispatch(_cli, reply);
+				if (ret && _dispatcher)
+					for (unsigned i = 0; i < _num_cli; i++)
+						_dispatcher->dispatch(_cli[i], reply, !_range);
 				return ret;
 			}
 
 			bool same_dispatcher(Block_dispatcher &same) {
-				return &same == &_dispatcher; }
+				return &same == _dispatcher; }
+
+			/**
+			 * Return transfer range if the request was forwarded directly
+			 */
+			Transfer_range *range() { return _range; }
+
+			/**
+			 * Forget about the client, e.g., when its session is closed
+			 */
+			void orphan() { _dispatcher = nullptr; }
 	};
 
 	private:
 
 		enum { BLK_SZ = Session::TX_QUEUE_SIZE*sizeof(Request) };
 
+		/**
+		 * Part of the packet buffer kept free from transfer ranges to
+		 * always allow for copied requests
+		 */
+		enum { MIN_COPY_BUFFER_FRACTION = 4 };
+
+		Genode::Heap                  &_heap;
 		Genode::Tslab<Request, BLK_SZ> _r_slab;
 		Genode::List<Request>          _r_list;
 		Genode::Allocator_avl          _block_alloc;
 		Block::Connection              _session;
+		Genode::size_t const           _buffer_size;
 		Block::sector_t                _blk_cnt;
 		Genode::size_t                 _blk_size;
 		Genode::Signal_handler<Driver> _source_ack;
 		Genode::Signal_handler<Driver> _source_submit;
 		Block::Session::Operations     _ops;
+		Io_scheduler                  *_scheduler   = nullptr;
+		unsigned                       _queue_depth = Session::TX_QUEUE_SIZE;
+		unsigned                       _in_flight   = 0;
+		Genode::size_t                 _max_request_size = DEFAULT_MAX_REQUEST_SIZE;
 
 		void _ready_to_submit();
 
+		void _release_range(Transfer_range &range)
+		{
+			_block_alloc.free((void *)range._offset);
+			Genode::destroy(&_heap, &range);
+		}
+
 		void _ack_avail()
 		{
 			/* check for acknowledgements */
 			while (_session.tx()->ack_avail()) {
 				Packet_descriptor p = _session.tx()->get_acked_packet();
+				Transfer_range *range = nullptr;
 				for (Request *r = _r_list.first(); r; r = r->next()) {
 					if (r->handle(p)) {
+						range = r->range();
 						_r_list.remove(r);
 						Genode::destroy(&_r_slab, r);
+						_in_flight--;
 						break;
 					}
 				}
-				_session.tx()->release_packet(p);
-			}
 
+				/* the packet of a direct request belongs to a transfer range */
+				if (!range) {
+					_session.tx()->release_packet(p);
+					continue;
+				}
+
+				range->_pending--;
+				if (range->_released && !range->_pending)
+					_release_range(*range);
+			}
 			_ready_to_submit();
 		}
 
+		void _submit(bool write, sector_t nr, Genode::size_t cnt,
+		             Packet_descriptor p, Block_dispatcher &dispatcher,
+		             Client_request const *cli, unsigned num_cli,
+		             Transfer_range *range)
+		{
+			Block::Packet_descriptor::Opcode op = write
+			    ? Block::Packet_descriptor::WRITE
+			    : Block::Packet_descriptor::READ;
+
+			Packet_descriptor srv(p, op, nr, cnt);
+
+			Request *r = new (&_r_slab) Request(dispatcher, cli, num_cli,
+			                                    srv, range);
+			_r_list.insert(r);
+			_in_flight++;
+
+			if (range)
+				range->_pending++;
+
+			_session.tx()->submit_packet(srv);
+		}
+
 	public:
 
-		Driver(Genode::Env &env, Genode::Heap &heap)
-		: _r_slab(&heap),
+		enum { DEFAULT_BUFFER_SIZE      = 4 * 1024 * 1024,
+		       DEFAULT_MAX_REQUEST_SIZE = 128 * 1024 };
+
+		Driver(Genode::Env &env, Genode::Heap &heap,
+		       Genode::size_t buffer_size = DEFAULT_BUFFER_SIZE)
+		: _heap(heap),
+		  _r_slab(&heap),
 		  _block_alloc(&heap),
-		  _session(env, &_block_alloc, 4 * 1024 * 1024),
+		  _session(env, &_block_alloc, buffer_size),
+		  _buffer_size(buffer_size),
 		  _source_ack(env.ep(), *this, &Driver::_ack_avail),
 		  _source_submit(env.ep(), *this, &Driver::_ready_to_submit)
 		{
@@ -134,42 +266,130 @@ class Block::Driver
 
 		static Driver& driver();
 
+		/**
+		 * Install scheduler that gets called whenever the back end is able
+		 * to take new requests
+		 */
+		void scheduler(Io_scheduler &scheduler) { _scheduler = &scheduler; }
+
+		/**
+		 * Limit number of requests in flight at the back end
+		 *
+		 * Requests beyond the limit stay queued at the scheduler, which can
+		 * thereby decide on their order.
+		 */
+		void queue_depth(unsigned depth) {
+			_queue_depth = Genode::max(1U, Genode::min(depth,
+			                           (unsigned)Session::TX_QUEUE_SIZE)); }
+
+		/**
+		 * Limit size of merged requests
+		 *
+		 * The block session does not tell the largest request the back end
+		 * can handle. Hence, merging stops at this size, whereas a single
+		 * client request is always forwarded as is.
+		 */
+		void max_request_size(Genode::size_t size) {
+			_max_request_size = Genode::min(size, _buffer_size); }
+
+		/**
+		 * Return maximum number of blocks of a merged request
+		 */
+		Genode::size_t max_request_blocks() const {
+			return Genode::max((Genode::size_t)1, _max_request_size / _blk_size); }
+
+		/**
+		 * Return true if the back end takes another request
+		 */
+		bool ready() {
+			return _in_flight < _queue_depth && _session.tx()->ready_to_submit(); }
+
+		/**
+		 * Return dataspace of the back end's packet buffer
+		 */
+		Genode::Dataspace_capability buffer_ds() {
+			return _session.tx()->dataspace(); }
+
+		/**
+		 * Reserve page-aligned range of the packet buffer for a client
+		 *
+		 * \return  transfer range, or nullptr if the remaining buffer
+		 *          does not suffice
+		 */
+		Transfer_range *alloc_transfer_range(Genode::size_t size)
+		{
+			enum { PAGE_SIZE_LOG2 = 12 };
+
+			size = Genode::align_addr(size, PAGE_SIZE_LOG2);
+
+			if (_block_alloc.avail() < size + _buffer_size/MIN_COPY_BUFFER_FRACTION)
+				return nullptr;
+
+			void *base = nullptr;
+			if (_block_alloc.alloc_aligned(size, &base, PAGE_SIZE_LOG2).error())
+				return nullptr;
+
+			return new (&_heap) Transfer_range((Genode::off_t)base);
+		}
+
+		/**
+		 * Release transfer range once all of its requests are finished
+		 */
+		void free_transfer_range(Transfer_range &range)
+		{
+			range._released = true;
+			if (!range._pending)
+				_release_range(range);
+		}
+
 		void io(bool write, sector_t nr, Genode::size_t cnt, void* addr,
-		        Block_dispatcher &dispatcher, Packet_descriptor& cli)
+		        Block_dispatcher &dispatcher, Client_request const &cli)
 		{
-			if (!_session.tx()->ready_to_submit())
+			if (!ready())
 				throw Block::Session::Tx::Source::Packet_alloc_failed();
 
-			Block::Packet_descriptor::Opcode op = write
-			    ? Block::Packet_descriptor::WRITE
-			    : Block::Packet_descriptor::READ;
 			Genode::size_t size = _blk_size * cnt;
-			Packet_descriptor p(_session.dma_alloc_packet(size),
-			                    op,  nr, cnt);
-			Request *r = new (&_r_slab) Request(dispatcher, cli, p);
-			_r_list.insert(r);
+			Packet_descriptor const p = _session.dma_alloc_packet(size);
 
 			if (write)
 				Genode::memcpy(_session.tx()->packet_content(p),
 				               addr, size);
 
-			_session.tx()->submit_packet(p);
+			_submit(write, nr, cnt, p, dispatcher, &cli, 1, nullptr);
 		}
 
-		void remove_dispatcher(Block_dispatcher &dispatcher)
+		/**
+		 * Forward request located within a transfer range without copying
+		 *
+		 * \param offset   offset of the request data within the transfer
+		 *                 range
+		 * \param cli      client requests covered by the request, which
+		 *                 must be adjacent on disk and in the transfer range
+		 * \param num_cli  number of client requests, at most 'MAX_MERGED'
+		 */
+		void io_direct(bool write, sector_t nr, Genode::size_t cnt,
+		               Genode::off_t offset, Block_dispatcher &dispatcher,
+		               Client_request const *cli, unsigned num_cli,
+		               Transfer_range &range)
 		{
-			for (Request *r = _r_list.first(); r;) {
-				if (!r->same_dispatcher(dispatcher)) {
-					r = r->next();
-					continue;
-				}
+			if (!ready())
+				throw Block::Session::Tx::Source::Packet_alloc_failed();
 
-				Request *remove = r;
-				r = r->next();
+			Packet_descriptor const p(range.offset() + offset, _blk_size * cnt);
 
-				_r_list.remove(remove);
-				Genode::destroy(&_r_slab, remove);
-			}
+			_submit(write, nr, cnt, p, dispatcher, cli, num_cli, &range);
+		}
+
+		void remove_dispatcher(Block_dispatcher &dispatcher)
+		{
+			/*
+			 * The requests stay known until acknowledged because their
+			 * packets are still in flight at the back end and count for
+			 * the queue depth.
+			 */
+			for (Request *r = _r_list.first(); r; r = r->next())
+				if (r->same_dispatcher(dispatcher))
+					r->orphan();
 		}
 };
 
@@ -15,15 +15,20 @@
 
 #include <base/attached_rom_dataspace.h>
 #include <block_session/rpc_object.h>
+#include <timer_session/connection.h>
 
 #include "component.h"
 #include "driver.h"
 #include "gpt.h"
 #include "mbr.h"
+#include "scheduler.h"
 
 
-void Block::Driver::_ready_to_submit() {
-	Block::Session_component::wake_up(); }
+void Block::Driver::_ready_to_submit()
+{
+	if (_scheduler)
+		_scheduler->schedule();
+}
 
 
 class Main
@@ -32,16 +37,41 @@ class Main
 
 		Block::Partition_table & _table();
 
+		Timer::Connection * _latency_timer();
+
 		Genode::Env &_env;
 
 		Genode::Attached_rom_dataspace _config { _env, "config" };
 
 		Genode::Heap        _heap     { _env.ram(), _env.rm() };
-		Block::Driver       _driver   { _env, _heap      };
+		Block::Driver       _driver   { _env, _heap, _config.xml().attribute_value("io_buffer",
+		                                  Genode::Number_of_bytes(Block::Driver::DEFAULT_BUFFER_SIZE)) };
 		Genode::Reporter    _reporter { _env, "partitions" };
 		Mbr_partition_table _mbr      { _heap, _driver, _reporter };
 		Gpt                 _gpt      { _heap, _driver, _reporter };
-		Block::Root         _root     { _env, _config.xml(), _heap, _driver, _table() };
+
+		Block::Fair_io_scheduler _scheduler { _driver };
+
+		/*
+		 * Latencies are measured only if reported so that no timer session
+		 * is needed otherwise
+		 */
+		enum { LATENCY_REPORT_PERIOD_US = 1000*1000 };
+
+		Genode::Reporter                                   _latency_reporter { _env, "latency" };
+		Genode::Constructible<Timer::Connection>           _timer;
+		Genode::Constructible<Timer::Periodic_timeout<Main>> _latency_timeout;
+
+		Block::Root _root { _env, _config.xml(), _heap, _driver, _table(),
+		                    _scheduler, _latency_timer() };
+
+		void _report_latency(Genode::Duration)
+		{
+			Genode::Reporter::Xml_generator xml(_latency_reporter, [&] () {
+				_scheduler.for_each_queue([&] (Block::Io_queue &queue) {
+					queue.report(xml); });
+			});
+		}
 
 	public:
 
@@ -53,8 +83,17 @@ class Main
 			 * we read all partition information,
 			 * now it's safe to turn in asynchronous mode
 			 */
+			_driver.queue_depth(_config.xml().attribute_value("queue_depth",
+			                    (unsigned)Block::Session::TX_QUEUE_SIZE));
+			_driver.max_request_size(_config.xml().attribute_value("max_request_size",
+			                         Genode::Number_of_bytes(Block::Driver::DEFAULT_MAX_REQUEST_SIZE)));
+			_driver.scheduler(_scheduler);
 			_driver.work_asynchronously();
 
+			if (_timer.constructed())
+				_latency_timeout.construct(*_timer, *this, &Main::_report_latency,
+				                           Genode::Microseconds(LATENCY_REPORT_PERIOD_US));
+
 			/* announce at parent */
 			env.parent().announce(env.ep().manage(_root));
 		}
@@ -101,4 +140,17 @@ Block::Partition_table & Main::_table()
 }
 
 
+Timer::Connection * Main::_latency_timer()
+{
+	try {
+		if (_config.xml().sub_node("report").attribute_value("latency", false)) {
+			_timer.construct(_env);
+			_latency_reporter.enabled(true);
+		}
+	} catch (...) { }
+
+	return _timer.constructed() ? &*_timer : nullptr;
+}
+
+
 void Component::construct(Genode::Env &env) { static Main main(env); }
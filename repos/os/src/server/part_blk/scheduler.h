@@ -0,0 +1,378 @@
+/*
+ * \brief  I/O scheduler of the partition server
+ * \author Stefan Kalkowski
+ * \date   2017-06-20
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _PART_BLK__SCHEDULER_H_
+#define _PART_BLK__SCHEDULER_H_
+
+#include <util/list.h>
+#include <util/xml_generator.h>
+
+#include "driver.h"
+
+namespace Block {
+	class Io_queue;
+	class Io_scheduler;
+	class Fair_io_scheduler;
+};
+
+
+/**
+ * Requests of one client that wait for being forwarded to the back end
+ *
+ * Within a queue, requests are served in ascending order of their block
+ * numbers, wrapping around at the end of the partition (C-SCAN). A request
+ * never overtakes an older request that covers an overlapping range of
+ * blocks.
+ */
+class Block::Io_queue : public Genode::List<Io_queue>::Element
+{
+	public:
+
+		enum { SIZE = Session::TX_QUEUE_SIZE };
+
+		struct Entry
+		{
+			Client_request request;
+			unsigned long  seq   = 0;
+			bool           valid = false;
+
+			sector_t first() const { return request.packet.block_number(); }
+			sector_t end()   const { return first() + request.packet.block_count(); }
+
+			bool overlaps(Entry const &other) const {
+				return first() < other.end() && other.first() < end(); }
+		};
+
+		struct Stats
+		{
+			unsigned long long requests     = 0;
+			unsigned long long blocks       = 0;
+			unsigned long long latency_us   = 0;
+			unsigned long      max_latency_us = 0;
+		};
+
+	private:
+
+		friend class Fair_io_scheduler;
+
+		unsigned const _weight;
+
+		Entry         _entries[SIZE];
+		unsigned      _count     = 0;
+		unsigned long _seq       = 0;
+		sector_t      _position  = 0;
+		Entry        *_head      = nullptr;
+
+		/* credit of the queue in blocks, maintained by the scheduler */
+		long _deficit = 0;
+
+		Stats _stats;
+
+		/**
+		 * Return oldest request that overlaps 'e' and arrived before it
+		 */
+		Entry *_older_overlapping(Entry const &e)
+		{
+			Entry *oldest = nullptr;
+			for (unsigned i = 0; i < SIZE; i++) {
+				Entry &o = _entries[i];
+				if (o.valid && o.seq < e.seq && o.overlaps(e)
+				 && (!oldest || o.seq < oldest->seq))
+					oldest = &o;
+			}
+			return oldest;
+		}
+
+		/**
+		 * Determine request served next
+		 */
+		Entry *_select_head()
+		{
+			Entry *ahead = nullptr, *lowest = nullptr;
+			for (unsigned i = 0; i < SIZE; i++) {
+				Entry &e = _entries[i];
+				if (!e.valid)
+					continue;
+
+				if (e.first() >= _position && (!ahead || e.first() < ahead->first()))
+					ahead = &e;
+				if (!lowest || e.first() < lowest->first())
+					lowest = &e;
+			}
+
+			/* preserve the order of overlapping requests */
+			Entry *head = ahead ? ahead : lowest;
+			while (Entry *older = head ? _older_overlapping(*head) : nullptr)
+				head = older;
+
+			return head;
+		}
+
+	protected:
+
+		/**
+		 * Return queued request following 'e' on disk, or nullptr
+		 *
+		 * \param match  functor called with the candidate entry, returns
+		 *               true if the entry may be merged with 'e'
+		 */
+		template <typename FN>
+		Entry *_successor(Entry const &e, FN const &match)
+		{
+			for (unsigned i = 0; i < SIZE; i++) {
+				Entry &s = _entries[i];
+				if (s.valid && s.first() == e.end() && match(s)
+				 && !_older_overlapping(s))
+					return &s;
+			}
+			return nullptr;
+		}
+
+		/**
+		 * Remove entry after its request got forwarded
+		 */
+		void _remove(Entry &e)
+		{
+			_position = e.end();
+			e.valid   = false;
+			_count--;
+
+			if (_head == &e)
+				_head = nullptr;
+		}
+
+		/**
+		 * Forward the request at the head of the queue
+		 *
+		 * \return  number of blocks forwarded, zero if the back end is
+		 *          unable to take the request
+		 */
+		virtual Genode::size_t _submit(Entry &head) = 0;
+
+	public:
+
+		Io_queue(unsigned weight) : _weight(Genode::max(1U, weight)) { }
+
+		virtual ~Io_queue() { }
+
+		unsigned weight() const { return _weight; }
+		bool     empty()  const { return !_count; }
+		bool     full()   const { return _count == SIZE; }
+
+		Stats const &stats() const { return _stats; }
+
+		void enqueue(Client_request const &request)
+		{
+			for (unsigned i = 0; i < SIZE; i++) {
+				Entry &e = _entries[i];
+				if (e.valid)
+					continue;
+
+				e.request = request;
+				e.seq     = _seq++;
+				e.valid   = true;
+				_count++;
+				_head = nullptr;
+				return;
+			}
+		}
+
+		/**
+		 * Return request to be served next, or nullptr if queue is empty
+		 */
+		Entry *head()
+		{
+			if (!_head && _count)
+				_head = _select_head();
+			return _head;
+		}
+
+		/**
+		 * Forward request at the head of the queue
+		 */
+		Genode::size_t submit_head()
+		{
+			Entry *e = head();
+			return e ? _submit(*e) : 0;
+		}
+
+		/**
+		 * Account completed request
+		 *
+		 * \param latency_us  time between arrival and completion, zero if
+		 *                    not measured
+		 */
+		void completed(Genode::size_t blocks, unsigned long latency_us)
+		{
+			_stats.requests++;
+			_stats.blocks     += blocks;
+			_stats.latency_us += latency_us;
+			_stats.max_latency_us = Genode::max(_stats.max_latency_us, latency_us);
+		}
+
+		/**
+		 * Reset maximum latency, e.g., after reporting it
+		 */
+		void reset_max_latency() { _stats.max_latency_us = 0; }
+
+		/**
+		 * Generate report node of the queue
+		 */
+		virtual void report(Genode::Xml_generator &xml) = 0;
+};
+
+
+/**
+ * Interface of policies for distributing the back end among the queues
+ */
+class Block::Io_scheduler
+{
+	private:
+
+		Driver &_driver;
+
+	protected:
+
+		Genode::List<Io_queue> _queues;
+
+		/**
+		 * Select queue to be served next
+		 *
+		 * \return  queue with a pending request, or nullptr
+		 */
+		virtual Io_queue *_select() = 0;
+
+		/**
+		 * Account request of 'blocks' forwarded from 'queue'
+		 */
+		virtual void _served(Io_queue &queue, Genode::size_t blocks) = 0;
+
+	public:
+
+		Io_scheduler(Driver &driver) : _driver(driver) { }
+
+		virtual ~Io_scheduler() { }
+
+		virtual void attach(Io_queue &queue) { _queues.insert(&queue); }
+		virtual void detach(Io_queue &queue) { _queues.remove(&queue); }
+
+		template <typename FN>
+		void for_each_queue(FN const &fn)
+		{
+			for (Io_queue *q = _queues.first(); q; q = q->next())
+				fn(*q);
+		}
+
+		/**
+		 * Forward requests as long as the back end takes them
+		 */
+		void schedule()
+		{
+			while (_driver.ready()) {
+				Io_queue *queue = _select();
+				if (!queue)
+					return;
+
+				Genode::size_t const blocks = queue->submit_head();
+				if (!blocks)
+					return;
+
+				_served(*queue, blocks);
+			}
+		}
+};
+
+
+/**
+ * Weighted deficit round robin among the queues
+ *
+ * Whenever it is a queue's turn, the queue's credit is increased by a
+ * quantum of blocks multiplied by the weight of the queue. The queue is
+ * served as long as its credit covers the request at its head. Thus, the
+ * bandwidth of a busy back end is shared in proportion to the weights,
+ * independent of the size of the requests.
+ */
+class Block::Fair_io_scheduler : public Block::Io_scheduler
+{
+	private:
+
+		enum { QUANTUM_BLOCKS = 64 };
+
+		Io_queue *_current  = nullptr;
+		bool      _credited = false;
+
+		bool _pending() const
+		{
+			for (Io_queue const *q = _queues.first(); q; q = q->next())
+				if (!q->empty())
+					return true;
+			return false;
+		}
+
+		void _next()
+		{
+			_current  = _current ? _current->next() : nullptr;
+			_credited = false;
+		}
+
+	protected:
+
+		Io_queue *_select() override
+		{
+			if (!_pending())
+				return nullptr;
+
+			for (;;) {
+				if (!_current) {
+					_current  = _queues.first();
+					_credited = false;
+				}
+
+				Io_queue &q = *_current;
+				Io_queue::Entry *head = q.head();
+
+				/* an idle queue does not accumulate credit */
+				if (!head) {
+					q._deficit = 0;
+					_next();
+					continue;
+				}
+
+				if (!_credited) {
+					q._deficit += (long)QUANTUM_BLOCKS * q.weight();
+					_credited   = true;
+				}
+
+				if ((long)head->request.packet.block_count() <= q._deficit)
+					return &q;
+
+				_next();
+			}
+		}
+
+		void _served(Io_queue &queue, Genode::size_t blocks) override {
+			queue._deficit -= blocks; }
+
+	public:
+
+		Fair_io_scheduler(Driver &driver) : Io_scheduler(driver) { }
+
+		void detach(Io_queue &queue) override
+		{
+			if (_current == &queue)
+				_next();
+			Io_scheduler::detach(queue);
+		}
+};
+
+#endif /* _PART_BLK__SCHEDULER_H_ */
@@ -16,14 +16,24 @@
 #include <base/component.h>
 #include <base/log.h>
 #include <base/heap.h>
+#include <base/thread.h>
 #include <base/attached_rom_dataspace.h>
-#include <timer_session/connection.h>
 #include <base/session_label.h>
+#include <os/reporter.h>
+#include <util/reconstructible.h>
 
 namespace Rom_prefetcher {
+	class Rom_module;
+	class Prefetch_queue;
+	class Prefetch_thread;
 	class Rom_session_component;
 	class Rom_root;
 	struct Main;
+
+	using Genode::size_t;
+
+	typedef Genode::String<64>           Name;
+	typedef Genode::List<Rom_module>     Rom_modules;
 }
 
 
@@ -45,24 +55,270 @@ static void prefetch_dataspace(Genode::Region_map &rm, Genode::Dataspace_capabil
 }
 
 
+/**
+ * ROM module listed in the config, kept open once it is prefetched
+ */
+class Rom_prefetcher::Rom_module : public Rom_modules::Element
+{
+	public:
+
+		enum State { PENDING, FETCHING, WARM, FAILED };
+
+	private:
+
+		Name const _name;
+		long const _priority;
+
+		State _state = PENDING;
+
+		Genode::Constructible<Genode::Rom_connection> _rom;
+
+		Genode::Rom_dataspace_capability _ds;
+
+		size_t _size = 0;
+
+		/**
+		 * Lock held until the module is prefetched or failed
+		 */
+		Genode::Lock _fetched { Genode::Lock::LOCKED };
+
+		friend class Prefetch_queue;
+
+	public:
+
+		Rom_module(Name const &name, long priority)
+		: _name(name), _priority(priority) { }
+
+		Name  const &name()     const { return _name; }
+		long         priority() const { return _priority; }
+		State        state()    const { return _state; }
+		size_t       size()     const { return _size; }
+
+		/**
+		 * Open and prefetch the module, called by exactly one thread
+		 */
+		void fetch(Genode::Env &env)
+		{
+			try {
+				_rom.construct(env, _name.string());
+				_ds = _rom->dataspace();
+				prefetch_dataspace(env.rm(), _ds);
+				_size = Genode::Dataspace_client(_ds).size();
+			} catch (...) {
+				Genode::error("could not open ROM module ", _name);
+				_rom.destruct();
+				_ds = Genode::Rom_dataspace_capability();
+			}
+		}
+
+		/**
+		 * Block until the module is prefetched or failed
+		 */
+		void wait_until_fetched() { Genode::Lock::Guard guard(_fetched); }
+
+		/**
+		 * Return dataspace of the warm module, or an invalid capability
+		 */
+		Genode::Rom_dataspace_capability dataspace() const { return _ds; }
+};
+
+
+/**
+ * ROM modules of the config ordered by descending priority
+ *
+ * The queue is accessed by the prefetch threads and by the entrypoint, which
+ * may claim a pending module for a session request to avoid waiting for the
+ * threads to get to it.
+ */
+class Rom_prefetcher::Prefetch_queue
+{
+	private:
+
+		Genode::Lock  _lock;
+		Rom_modules   _modules;
+		Rom_module   *_next = nullptr;
+
+		unsigned _total = 0, _warm = 0, _failed = 0;
+
+		Genode::Signal_context_capability _progress_sigh;
+
+	public:
+
+		Prefetch_queue(Genode::Signal_context_capability progress_sigh)
+		: _progress_sigh(progress_sigh) { }
+
+		/**
+		 * Insert module behind all modules of equal or higher priority
+		 */
+		void insert(Rom_module &module)
+		{
+			Genode::Lock::Guard guard(_lock);
+
+			Rom_module *at = nullptr;
+			for (Rom_module *m = _modules.first();
+			     m && m->priority() >= module.priority(); m = m->next())
+				at = m;
+
+			_modules.insert(&module, at);
+			_next = _modules.first();
+			_total++;
+		}
+
+		/**
+		 * Claim the next pending module, return nullptr if there is none
+		 */
+		Rom_module *claim_next()
+		{
+			Genode::Lock::Guard guard(_lock);
+
+			for (; _next; _next = _next->next()) {
+				if (_next->_state == Rom_module::PENDING) {
+					_next->_state = Rom_module::FETCHING;
+					return _next;
+				}
+			}
+			return nullptr;
+		}
+
+		/**
+		 * Look up module by name
+		 *
+		 * \param claimed  set to true if the module was pending and got
+		 *                 handed over to the caller for fetching
+		 */
+		Rom_module *lookup(Name const &name, bool &claimed)
+		{
+			Genode::Lock::Guard guard(_lock);
+
+			claimed = false;
+			for (Rom_module *m = _modules.first(); m; m = m->next()) {
+				if (m->name() != name)
+					continue;
+
+				if (m->_state == Rom_module::PENDING) {
+					m->_state = Rom_module::FETCHING;
+					claimed = true;
+				}
+				return m;
+			}
+			return nullptr;
+		}
+
+		/**
+		 * Mark claimed module as done and wake up threads waiting for it
+		 */
+		void fetched(Rom_module &module)
+		{
+			{
+				Genode::Lock::Guard guard(_lock);
+
+				if (module.dataspace().valid()) {
+					module._state = Rom_module::WARM;
+					_warm++;
+				} else {
+					module._state = Rom_module::FAILED;
+					_failed++;
+				}
+			}
+			module._fetched.unlock();
+
+			Genode::Signal_transmitter(_progress_sigh).submit();
+		}
+
+		bool complete()
+		{
+			Genode::Lock::Guard guard(_lock);
+			return _warm + _failed == _total;
+		}
+
+		void generate(Genode::Xml_generator &xml)
+		{
+			Genode::Lock::Guard guard(_lock);
+
+			xml.attribute("total",  _total);
+			xml.attribute("warm",   _warm);
+			xml.attribute("failed", _failed);
+
+			for (Rom_module *m = _modules.first(); m; m = m->next()) {
+				xml.node("rom", [&] () {
+					xml.attribute("name", m->name());
+					switch (m->state()) {
+					case Rom_module::PENDING:  xml.attribute("state", "pending");  break;
+					case Rom_module::FETCHING: xml.attribute("state", "fetching"); break;
+					case Rom_module::WARM:
+						xml.attribute("state", "warm");
+						xml.attribute("size", m->size());
+						break;
+					case Rom_module::FAILED:   xml.attribute("state", "failed");   break;
+					}
+				});
+			}
+		}
+};
+
+
+/**
+ * Thread that prefetches pending modules in the order of the queue
+ */
+class Rom_prefetcher::Prefetch_thread : public Genode::Thread
+{
+	private:
+
+		enum { STACK_SIZE = 2*1024*sizeof(long) };
+
+		Genode::Env    &_env;
+		Prefetch_queue &_queue;
+
+		void entry() override
+		{
+			while (Rom_module *module = _queue.claim_next()) {
+				Genode::log("prefetching ROM module ", module->name());
+				module->fetch(_env);
+				_queue.fetched(*module);
+			}
+		}
+
+	public:
+
+		Prefetch_thread(Genode::Env &env, Prefetch_queue &queue)
+		:
+			Genode::Thread(env, "prefetch", STACK_SIZE),
+			_env(env), _queue(queue)
+		{ start(); }
+};
+
+
 class Rom_prefetcher::Rom_session_component : public Genode::Rpc_object<Genode::Rom_session>
 {
 	private:
 
-		Genode::Rom_connection _rom;
+		/*
+		 * ROM connection used if the module is not listed in the config
+		 * or could not be prefetched
+		 */
+		Genode::Constructible<Genode::Rom_connection> _rom;
+
+		Genode::Rom_dataspace_capability _ds;
 
 	public:
 
 		/**
 		 * Constructor
 		 *
-		 * \param  filename  name of the requested file
+		 * \param  label   name of the requested module
+		 * \param  module  prefetched module or nullptr
 		 */
-		Rom_session_component(Genode::Env &env, Genode::Session_label const &label)
+		Rom_session_component(Genode::Env &env, Genode::Session_label const &label,
+		                      Rom_module *module)
 		:
-			_rom(env, label.string())
+			_ds(module ? module->dataspace() : Genode::Rom_dataspace_capability())
 		{
-			prefetch_dataspace(env.rm(), _rom.dataspace());
+			if (_ds.valid())
+				return;
+
+			_rom.construct(env, label.string());
+			_ds = _rom->dataspace();
+			prefetch_dataspace(env.rm(), _ds);
 		}
 
 
@@ -70,7 +326,7 @@ class Rom_prefetcher::Rom_session_component : public Genode::Rpc_object<Genode::
 		 ** ROM session interface **
 		 ***************************/
 
-		Genode::Rom_dataspace_capability dataspace() { return _rom.dataspace(); }
+		Genode::Rom_dataspace_capability dataspace() { return _ds; }
 
 		void sigh(Genode::Signal_context_capability) { }
 };
@@ -80,23 +336,42 @@ class Rom_prefetcher::Rom_root : public Genode::Root_component<Rom_session_compo
 {
 	private:
 
-		Genode::Env &_env;
+		Genode::Env    &_env;
+		Prefetch_queue &_queue;
 
 		Rom_session_component *_create_session(const char *args)
 		{
 			Genode::Session_label const label = Genode::label_from_args(args);
+			Genode::Session_label const name  = label.last_element();
+
+			/*
+			 * A warm module is handed out immediately. A pending one is
+			 * fetched right away, one that is currently fetched by a prefetch
+			 * thread is waited for.
+			 */
+			bool claimed = false;
+			Rom_module *module = _queue.lookup(name.string(), claimed);
+
+			if (module && claimed) {
+				module->fetch(_env);
+				_queue.fetched(*module);
+			}
+
+			if (module)
+				module->wait_until_fetched();
 
 			/* create new session for the requested file */
 			return new (md_alloc())
-				Rom_session_component(_env, label.last_element());
+				Rom_session_component(_env, name, module);
 		}
 
 	public:
 
-		Rom_root(Genode::Env &env, Genode::Allocator &md_alloc)
+		Rom_root(Genode::Env &env, Genode::Allocator &md_alloc,
+		         Prefetch_queue &queue)
 		:
 			Genode::Root_component<Rom_session_component>(env.ep(), md_alloc),
-			_env(env)
+			_env(env), _queue(queue)
 		{ }
 };
 
@@ -107,31 +382,62 @@ struct Rom_prefetcher::Main
 
 	Genode::Attached_rom_dataspace _config { _env, "config" };
 
+	Genode::Heap        _heap        { _env.ram(), _env.rm() };
 	Genode::Sliced_heap _sliced_heap { _env.ram(), _env.rm() };
 
-	Rom_root _root { _env, _sliced_heap };
+	Genode::Reporter _reporter { _env, "progress" };
+
+	bool _completion_logged = false;
+
+	void _handle_progress()
+	{
+		if (_reporter.enabled())
+			Genode::Reporter::Xml_generator xml(_reporter, [&] () {
+				_queue.generate(xml); });
+
+		if (_queue.complete() && !_completion_logged) {
+			Genode::log("prefetching finished");
+			_completion_logged = true;
+		}
+	}
+
+	Genode::Signal_handler<Main> _progress_handler {
+		_env.ep(), *this, &Main::_handle_progress };
+
+	Prefetch_queue _queue { _progress_handler };
+
+	Rom_root _root { _env, _sliced_heap, _queue };
+
+	enum { DEFAULT_THREADS = 2, MAX_THREADS = 16 };
 
 	Main(Genode::Env &env) : _env(env)
 	{
-		Timer::Connection timer(_env);
+		Genode::Xml_node const config = _config.xml();
 
-		_config.xml().for_each_sub_node("rom", [&] (Genode::Xml_node entry) {
+		try {
+			_reporter.enabled(config.sub_node("report")
+			                        .attribute_value("progress", false));
+		} catch (...) { }
 
-			typedef Genode::String<64> Name;
-			Name const name = entry.attribute_value("name", Name());
+		config.for_each_sub_node("rom", [&] (Genode::Xml_node entry) {
 
-			try {
-				Genode::Rom_connection rom(_env, name.string());
-				log("prefetching ROM module ", name);
-				prefetch_dataspace(_env.rm(), rom.dataspace());
-			} catch (...) {
-				error("could not open ROM module ", name);
-			}
+			Name const name     = entry.attribute_value("name", Name());
+			long const priority = entry.attribute_value("priority", 0L);
 
-			/* yield */
-			timer.msleep(1);
+			_queue.insert(*new (_heap) Rom_module(name, priority));
 		});
 
+		unsigned const num_threads =
+			Genode::max(1U, Genode::min(config.attribute_value("threads",
+			                                                  (unsigned)DEFAULT_THREADS),
+			                            (unsigned)MAX_THREADS));
+
+		/* the threads terminate once the queue is drained */
+		for (unsigned i = 0; i < num_threads; i++)
+			new (_heap) Prefetch_thread(_env, _queue);
+
+		_handle_progress();
+
 		/* announce server */
 		_env.parent().announce(_env.ep().manage(_root));
 	}
@@ -139,4 +445,3 @@ struct Rom_prefetcher::Main
 
 
 void Component::construct(Genode::Env &env) { static Rom_prefetcher::Main main(env); }
-
@@ -14,15 +14,22 @@
 
 /* Genode includes */
 #include <base/component.h>
+#include <base/entrypoint.h>
 #include <base/attached_rom_dataspace.h>
 #include <base/heap.h>
 #include <base/log.h>
 #include <base/session_label.h>
 #include <root/component.h>
+#include <rm_session/connection.h>
+#include <region_map/client.h>
+#include <util/avl_string.h>
+#include <util/retry.h>
 
 namespace Tar_rom {
 
 	using namespace Genode;
+	struct Archive_entry;
+	class Archive_index;
 	class Rom_session_component;
 	class Rom_root;
 	struct Main;
@@ -30,18 +37,31 @@ namespace Tar_rom {
 
 
 /**
- * A 'Rom_session_component' exports a single file of the tar archive
+ * File of the tar archive as recorded in the archive index
  */
-class Tar_rom::Rom_session_component : public Rpc_object<Rom_session>
+struct Tar_rom::Archive_entry : Avl_string_base
 {
-	private:
+	char const * const content;
+	size_t       const size;
+
+	Archive_entry(char const *name, char const *content, size_t size)
+	: Avl_string_base(name), content(content), size(size) { }
+};
 
-		Ram_session &_ram;
 
-		char const * const _tar_addr;
-		size_t       const _tar_size;
+/**
+ * Index of the files of a tar archive by name
+ *
+ * The archive is scanned only once at startup. Session requests look up
+ * the requested file in the index instead of scanning the archive again.
+ */
+class Tar_rom::Archive_index
+{
+	private:
 
-		Ram_dataspace_capability _file_ds;
+		Allocator                 &_alloc;
+		Avl_tree<Avl_string_base>  _entries;
+		unsigned                   _count = 0;
 
 		enum {
 			/* length of on data block in tar */
@@ -51,52 +71,47 @@ class Tar_rom::Rom_session_component : public Rpc_object<Rom_session>
 			_FIELD_SIZE_LEN = 124
 		};
 
-		/**
-		 * Copy file content into dataspace
-		 *
-		 * \param dst  destination dataspace
-		 */
-		void _copy_content_to_dataspace(Region_map &rm, Dataspace_capability dst,
-		                                char const *src, size_t len)
+		void _insert(char const *name, char const *content, size_t size)
 		{
-			/* temporarily map dataspace */
-			Attached_dataspace ds(rm, dst);
+			/* the first record of a file name takes precedence */
+			if (lookup(name))
+				return;
 
-			/* copy content */
-			size_t bytes_to_copy = min(len, ds.size());
-			memcpy(ds.local_addr<char>(), src, bytes_to_copy);
+			_entries.insert(new (_alloc) Archive_entry(name, content, size));
+			_count++;
 		}
 
+	public:
+
 		/**
-		 * Initialize dataspace containing the content of the archived file
+		 * Constructor
+		 *
+		 * \param tar_addr  local address of tar archive
+		 * \param tar_size  size of tar archive in bytes
 		 */
-		Ram_dataspace_capability _init_file_ds(Ram_session &ram, Region_map &rm,
-		                                       Session_label const &name)
+		Archive_index(Allocator &alloc, char const *tar_addr, size_t tar_size)
+		:
+			_alloc(alloc)
 		{
 			/* measure size of archive in blocks */
-			unsigned block_id = 0, block_cnt = _tar_size/_BLOCK_LEN;
-
-			char   const *file_content = nullptr;
-			unsigned long file_size    = 0;
+			unsigned block_id = 0, block_cnt = tar_size/_BLOCK_LEN;
 
 			/* scan metablocks of archive */
 			while (block_id < block_cnt) {
 
-				ascii_to_unsigned(_tar_addr + block_id*_BLOCK_LEN +
+				unsigned long file_size = 0;
+				ascii_to_unsigned(tar_addr + block_id*_BLOCK_LEN +
 				                  _FIELD_SIZE_LEN, file_size, 8);
 
 				/* get name of tar record */
-				char const *record_filename = _tar_addr + block_id*_BLOCK_LEN;
+				char const *record_filename = tar_addr + block_id*_BLOCK_LEN;
 
 				/* skip leading dot of path if present */
 				if (record_filename[0] == '.' && record_filename[1] == '/')
 					record_filename++;
 
-				/* get infos about current file */
-				if (name == record_filename) {
-					file_content = _tar_addr + (block_id+1) * _BLOCK_LEN;
-					break;
-				}
+				_insert(record_filename, tar_addr + (block_id+1) * _BLOCK_LEN,
+				        file_size);
 
 				/* some datablocks */       /* one metablock */
 				block_id = block_id + (file_size / _BLOCK_LEN) + 1;
@@ -105,53 +120,171 @@ class Tar_rom::Rom_session_component : public Rpc_object<Rom_session>
 				if (file_size % _BLOCK_LEN != 0) block_id++;
 
 				/* check for end of tar archive */
-				if (block_id*_BLOCK_LEN >= _tar_size)
+				if (block_id*_BLOCK_LEN >= tar_size)
 					break;
 
 				/* lookout for empty eof-blocks */
-				if (*(_tar_addr + (block_id*_BLOCK_LEN)) == 0x00)
-					if (*(_tar_addr + (block_id*_BLOCK_LEN + 1)) == 0x00)
+				if (*(tar_addr + (block_id*_BLOCK_LEN)) == 0x00)
+					if (*(tar_addr + (block_id*_BLOCK_LEN + 1)) == 0x00)
 						break;
 			}
+		}
 
-			if (!file_content) {
-				error("couldn't find file '", name, "', empty result");
-				return Ram_dataspace_capability();
+		~Archive_index()
+		{
+			while (Avl_string_base *entry = _entries.first()) {
+				_entries.remove(entry);
+				destroy(_alloc, static_cast<Archive_entry *>(entry));
 			}
+		}
+
+		Archive_entry const *lookup(char const *name)
+		{
+			Avl_string_base *first = _entries.first();
+			return first ? static_cast<Archive_entry *>(first->find_by_name(name))
+			             : nullptr;
+		}
+
+		unsigned count() const { return _count; }
+};
+
+
+/**
+ * A 'Rom_session_component' exports a single file of the tar archive
+ */
+class Tar_rom::Rom_session_component : public Rpc_object<Rom_session>
+{
+	private:
+
+		enum { PAGE_SIZE_LOG2 = 12 };
+
+		Ram_session   &_ram;
+		Rm_connection &_rm_session;
+
+		/* backing store of the file if its content got copied */
+		Ram_dataspace_capability _copied_ds;
+
+		/* managed dataspace if the archive content is handed out directly */
+		Capability<Region_map> _region_map;
+
+		Dataspace_capability _file_ds;
+
+		/**
+		 * Return true if the file content can be handed out directly
+		 *
+		 * This is the case if the content starts at a page boundary within
+		 * the archive dataspace and the rest of its last page contains only
+		 * zeros. Thereby, the client cannot tell the difference to a copy.
+		 */
+		static bool _direct_access_possible(Archive_entry const &file,
+		                                    char const *tar_addr,
+		                                    size_t      tar_ds_size)
+		{
+			addr_t const offset = file.content - tar_addr;
+			size_t const size   = align_addr(file.size, PAGE_SIZE_LOG2);
+
+			if (!file.size || offset & ((1UL << PAGE_SIZE_LOG2) - 1) ||
+			    offset + size > tar_ds_size)
+				return false;
+
+			for (size_t i = file.size; i < size; i++)
+				if (file.content[i])
+					return false;
+
+			return true;
+		}
+
+		/**
+		 * Call 'fn', upgrading the quota of the RM session on demand
+		 *
+		 * The RM session is shared by all ROM sessions, so its initial
+		 * quota covers only the first few of them.
+		 */
+		template <typename FN>
+		void _with_rm_upgrade(FN const &fn)
+		{
+			enum { ATTEMPTS = 4 };
+
+			retry<Out_of_ram>(
+				[&] () {
+					retry<Out_of_caps>(fn, [&] () { _rm_session.upgrade_caps(2); },
+					                   ATTEMPTS); },
+				[&] () { _rm_session.upgrade_ram(8*1024); },
+				ATTEMPTS);
+		}
+
+		/**
+		 * Hand out the file content as part of the archive dataspace
+		 */
+		Dataspace_capability _init_direct_ds(Archive_entry const &file,
+		                                     Dataspace_capability tar_ds,
+		                                     char const *tar_addr)
+		{
+			size_t const size = align_addr(file.size, PAGE_SIZE_LOG2);
 
-			/* try to allocate memory for file */
-			Ram_dataspace_capability file_ds;
 			try {
-				file_ds = ram.alloc(file_size);
+				_with_rm_upgrade([&] () { _region_map = _rm_session.create(size); });
 
-				/* get content of file copied into dataspace and return */
-				_copy_content_to_dataspace(rm, file_ds, file_content, file_size);
+				Region_map_client rm(_region_map);
+				_with_rm_upgrade([&] () {
+					rm.attach_at(tar_ds, 0, size, file.content - tar_addr); });
+				return rm.dataspace();
+			}
+			catch (...) {
+				if (_region_map.valid()) {
+					_rm_session.destroy(_region_map);
+					_region_map = Capability<Region_map>();
+				}
+				warning("could not map file content directly, copy it");
+			}
+			return Dataspace_capability();
+		}
+
+		/**
+		 * Initialize dataspace containing a copy of the archived file
+		 */
+		Dataspace_capability _init_copied_ds(Region_map &rm,
+		                                     Archive_entry const &file)
+		{
+			try {
+				_copied_ds = _ram.alloc(file.size);
+
+				/* get content of file copied into dataspace */
+				Attached_dataspace ds(rm, _copied_ds);
+				memcpy(ds.local_addr<char>(), file.content,
+				       min(file.size, ds.size()));
 			} catch (...) {
 				error("couldn't allocate memory for file, empty result");
-				return file_ds;
 			}
-
-			return file_ds;
+			return _copied_ds;
 		}
 
 	public:
 
 		/**
-		 * Constructor scans and seeks to file
+		 * Constructor
 		 *
-		 * \param  tar_addr  local address to tar archive
-		 * \param  tar_size  size of tar archive in bytes
-		 * \param  label     name of the requested ROM module
+		 * \param  file         archive entry of the requested ROM module
+		 * \param  tar_ds       dataspace of the tar archive
+		 * \param  tar_addr     local address to tar archive
+		 * \param  tar_ds_size  size of the tar-archive dataspace
 		 *
 		 * \throw Service_denied
 		 */
 		Rom_session_component(Ram_session &ram, Region_map &rm,
-		                      char const *tar_addr, unsigned tar_size,
-		                      Session_label const &label)
+		                      Rm_connection &rm_session,
+		                      Archive_entry const &file,
+		                      Dataspace_capability tar_ds,
+		                      char const *tar_addr, size_t tar_ds_size)
 		:
-			_ram(ram), _tar_addr(tar_addr), _tar_size(tar_size),
-			_file_ds(_init_file_ds(ram, rm, label))
+			_ram(ram), _rm_session(rm_session)
 		{
+			if (_direct_access_possible(file, tar_addr, tar_ds_size))
+				_file_ds = _init_direct_ds(file, tar_ds, tar_addr);
+
+			if (!_file_ds.valid())
+				_file_ds = _init_copied_ds(rm, file);
+
 			if (!_file_ds.valid())
 				throw Service_denied();
 		}
@@ -159,15 +292,21 @@ class Tar_rom::Rom_session_component : public Rpc_object<Rom_session>
 		/**
 		 * Destructor
 		 */
-		~Rom_session_component() { _ram.free(_file_ds); }
+		~Rom_session_component()
+		{
+			if (_region_map.valid())
+				_rm_session.destroy(_region_map);
+
+			if (_copied_ds.valid())
+				_ram.free(_copied_ds);
+		}
 
 		/**
 		 * Return dataspace with content of file
 		 */
 		Rom_dataspace_capability dataspace()
 		{
-			Dataspace_capability ds = _file_ds;
-			return static_cap_cast<Rom_dataspace>(ds);
+			return static_cap_cast<Rom_dataspace>(_file_ds);
 		}
 
 		void sigh(Signal_context_capability) { }
@@ -180,8 +319,13 @@ class Tar_rom::Rom_root : public Root_component<Rom_session_component>
 
 		Env &_env;
 
-		char const * const _tar_addr;
-		unsigned     const _tar_size;
+		Rm_connection _rm_session { _env };
+
+		Dataspace_capability const _tar_ds;
+		char const *         const _tar_addr;
+		size_t               const _tar_size;
+
+		Archive_index &_index;
 
 		Rom_session_component *_create_session(const char *args)
 		{
@@ -189,10 +333,17 @@ class Tar_rom::Rom_root : public Root_component<Rom_session_component>
 			Session_label const module_name = label.last_element();
 			log("connection for module '", module_name, "' requested");
 
+			Archive_entry const *file = _index.lookup(module_name.string());
+			if (!file) {
+				error("couldn't find file '", module_name, "', empty result");
+				throw Service_denied();
+			}
+
 			/* create new session for the requested file */
 			return new (md_alloc()) Rom_session_component(_env.ram(), _env.rm(),
-			                                              _tar_addr, _tar_size,
-			                                              module_name.string());
+			                                              _rm_session, *file,
+			                                              _tar_ds, _tar_addr,
+			                                              _tar_size);
 		}
 
 	public:
@@ -200,14 +351,19 @@ class Tar_rom::Rom_root : public Root_component<Rom_session_component>
 		/**
 		 * Constructor
 		 *
+		 * \param tar_ds    dataspace of tar archive
 		 * \param tar_base  local address of tar archive
-		 * \param tar_size  size of tar archive in bytes
+		 * \param tar_size  size of tar-archive dataspace in bytes
+		 * \param index     index of the files within the archive
+		 * \param ep_pool   entrypoints that serve the ROM sessions
 		 */
-		Rom_root(Env &env, Allocator &md_alloc,
-		         char const *tar_addr, size_t tar_size)
+		Rom_root(Env &env, Allocator &md_alloc, Dataspace_capability tar_ds,
+		         char const *tar_addr, size_t tar_size, Archive_index &index,
+		         Entrypoint_pool &ep_pool)
 		:
-			Root_component<Rom_session_component>(env.ep(), md_alloc),
-			_env(env), _tar_addr(tar_addr), _tar_size(tar_size)
+			Root_component<Rom_session_component>(env.ep(), ep_pool, md_alloc),
+			_env(env), _tar_ds(tar_ds), _tar_addr(tar_addr),
+			_tar_size(tar_size), _index(index)
 		{ }
 };
 
@@ -237,11 +393,29 @@ struct Tar_rom::Main
 
 	Sliced_heap _sliced_heap { _env.ram(), _env.rm() };
 
-	Rom_root _root { _env, _sliced_heap, _tar_ds.local_addr<char>(), _tar_ds.size() };
+	Heap _heap { _env.ram(), _env.rm() };
+
+	Archive_index _index { _heap, _tar_ds.local_addr<char>(), _tar_ds.size() };
+
+	/*
+	 * The ROM sessions are independent from each other and access the
+	 * archive index read-only. Hence, they can be served by several threads.
+	 */
+	enum { EP_STACK_SIZE = 4*1024*sizeof(long) };
+
+	Entrypoint_pool _ep_pool { _env, _heap,
+	                           _config.xml().attribute_value("threads", 1U),
+	                           EP_STACK_SIZE, "tar_rom_ep" };
+
+	Rom_root _root { _env, _sliced_heap, _tar_ds.cap(),
+	                 _tar_ds.local_addr<char>(), _tar_ds.size(), _index,
+	                 _ep_pool };
 
 	Main(Env &env) : _env(env)
 	{
-		log("using tar archive '", _tar_name(), "' with size ", _tar_ds.size());
+		log("using tar archive '", _tar_name(), "' with size ", _tar_ds.size(),
+		    ", ", _index.count(), " files, ", _ep_pool.num_threads(),
+		    " entrypoint threads");
 
 		env.parent().announce(env.ep().manage(_root));
 	}
@@ -373,7 +373,8 @@ struct Vfs_server::Directory : Node
 
 	size_t read(Vfs::File_system &vfs, char *dst, size_t len, seek_off_t seek_offset)
 	{
-		Directory_service::Dirent vfs_dirent;
+		enum { BATCH = 16 };
+		Directory_service::Dirent vfs_dirents[BATCH];
 		size_t blocksize = sizeof(File_system::Directory_entry);
 
 		unsigned index = (seek_offset / blocksize);
@@ -381,28 +382,47 @@ struct Vfs_server::Directory : Node
 		size_t remains = len;
 
 		while (remains >= blocksize) {
-			if (vfs.dirent(path(), index++, vfs_dirent)
+
+			/* obtain the entries for the packet in batches */
+			unsigned const count = min((size_t)BATCH, remains / blocksize);
+			unsigned out_count = 0;
+
+			if (vfs.dirents(path(), index, vfs_dirents, count, out_count)
 				!= Vfs::Directory_service::DIRENT_OK)
 				return len - remains;
 
-			File_system::Directory_entry *fs_dirent = (Directory_entry *)dst;
-			fs_dirent->inode = vfs_dirent.fileno;
-			switch (vfs_dirent.type) {
-			case Vfs::Directory_service::DIRENT_TYPE_DIRECTORY:
-				fs_dirent->type = File_system::Directory_entry::TYPE_DIRECTORY;
-				break;
-			case Vfs::Directory_service::DIRENT_TYPE_SYMLINK:
-				fs_dirent->type = File_system::Directory_entry::TYPE_SYMLINK;
-				break;
-			case Vfs::Directory_service::DIRENT_TYPE_FILE:
-			default:
-				fs_dirent->type = File_system::Directory_entry::TYPE_FILE;
-				break;
+			for (unsigned i = 0; i < out_count; i++) {
+
+				Directory_service::Dirent const &vfs_dirent = vfs_dirents[i];
+
+				/* do not pass the end marker as entry to the client */
+				if (vfs_dirent.type == Vfs::Directory_service::DIRENT_TYPE_END)
+					return len - remains;
+
+				File_system::Directory_entry *fs_dirent = (Directory_entry *)dst;
+				fs_dirent->inode = vfs_dirent.fileno;
+				switch (vfs_dirent.type) {
+				case Vfs::Directory_service::DIRENT_TYPE_DIRECTORY:
+					fs_dirent->type = File_system::Directory_entry::TYPE_DIRECTORY;
+					break;
+				case Vfs::Directory_service::DIRENT_TYPE_SYMLINK:
+					fs_dirent->type = File_system::Directory_entry::TYPE_SYMLINK;
+					break;
+				case Vfs::Directory_service::DIRENT_TYPE_FILE:
+				default:
+					fs_dirent->type = File_system::Directory_entry::TYPE_FILE;
+					break;
+				}
+				strncpy(fs_dirent->name, vfs_dirent.name, MAX_NAME_LEN);
+
+				remains -= blocksize;
+				dst += blocksize;
 			}
-			strncpy(fs_dirent->name, vfs_dirent.name, MAX_NAME_LEN);
 
-			remains -= blocksize;
-			dst += blocksize;
+			if (out_count < count)
+				break;
+
+			index += out_count;
 		}
 		return len - remains;
 	}
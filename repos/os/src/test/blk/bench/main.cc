@@ -3,6 +3,13 @@
  * \author Sebastian Sumpf
  * \author Stefan Kalkowski
  * \date   2015-03-24
+ *
+ * The benchmark executes the jobs given in its config concurrently. Each job
+ * issues requests of a fixed size to a block session with a configurable
+ * number of requests in flight. The block numbers follow a sequential,
+ * uniformly random, or zipfian pattern, and the operation is a read or a
+ * write at a configurable ratio. A job may be run by several threads, each
+ * with a block session of its own.
  */
 
 /*
@@ -13,140 +20,746 @@
  */
 
 #include <base/allocator_avl.h>
+#include <base/attached_rom_dataspace.h>
 #include <base/component.h>
 #include <base/heap.h>
 #include <base/log.h>
+#include <base/thread.h>
 #include <block_session/connection.h>
+#include <os/reporter.h>
 #include <timer_session/connection.h>
+#include <util/list.h>
+
+namespace Bench {
+
+	using namespace Genode;
+
+	struct Random;
+	struct Zipf;
+	struct Latency_histogram;
+	struct Job_config;
+	struct Stats;
+	class  Worker;
+	class  Job;
+	struct Main;
+
+	typedef String<64> Name;
+
+	double ln(double x);
+	double exp(double x);
+	double pow(double x, double y) { return x > 0.0 ? exp(y*ln(x)) : 0.0; }
+}
+
+
+/**
+ * Natural logarithm, accurate enough for setting up the distributions
+ */
+double Bench::ln(double x)
+{
+	double const LN2 = 0.69314718055994530942;
+
+	/* reduce x to [1, 2) */
+	int e = 0;
+	for (; x >= 2.0; x /= 2.0) e++;
+	for (; x <  1.0; x *= 2.0) e--;
+
+	/* ln(x) = 2 atanh((x - 1)/(x + 1)) */
+	double const z = (x - 1.0)/(x + 1.0), z2 = z*z;
+	double sum = 0.0, term = z;
+	for (unsigned i = 1; i < 40; i += 2, term *= z2)
+		sum += term/i;
+
+	return 2.0*sum + e*LN2;
+}
+
+
+double Bench::exp(double x)
+{
+	double const LN2 = 0.69314718055994530942;
+
+	/* reduce x to |r| <= ln(2)/2 with x = k ln(2) + r */
+	long const k = (long)(x/LN2 + (x < 0 ? -0.5 : 0.5));
+	double const r = x - k*LN2;
+
+	double sum = 1.0, term = 1.0;
+	for (unsigned i = 1; i < 20; i++) {
+		term *= r/i;
+		sum  += term;
+	}
+
+	for (long i = 0; i <  k; i++) sum *= 2.0;
+	for (long i = 0; i > k; i--) sum /= 2.0;
+	return sum;
+}
+
+
+/**
+ * Xorshift pseudo-random number generator
+ */
+struct Bench::Random
+{
+	uint64_t state;
+
+	Random(uint64_t seed) : state(seed ? seed : 0x9e3779b97f4a7c15ULL) { }
 
-using namespace Genode;
+	uint64_t next()
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 0x2545f4914f6cdd1dULL;
+	}
 
-enum {
-	TEST_WRITE   = false,
-	TEST_SIZE    = 1024 * 1024 * 1024,
-	REQUEST_SIZE = 8 * 512,
-	TX_BUFFER    = Block::Session::TX_QUEUE_SIZE * REQUEST_SIZE
+	/**
+	 * Return value in [0, 1)
+	 */
+	double uniform() { return (next() >> 11) * (1.0/9007199254740992.0); }
 };
 
 
-class Throughput
+/**
+ * Zipfian distribution of ranks in [0, n)
+ *
+ * The ranks are generated as described by Gray et al., "Quickly Generating
+ * Billion-Record Synthetic Databases", which requires 0 < theta < 1.
+ */
+struct Bench::Zipf
+{
+	enum { MAX_EXACT_ZETA = 1 << 20 };
+
+	uint64_t n;
+	double   theta;
+	double   zetan = 0, alpha = 0, eta = 0, half_pow_theta = 0;
+
+	double _zeta(uint64_t count) const
+	{
+		uint64_t const exact = min(count, (uint64_t)MAX_EXACT_ZETA);
+
+		double sum = 0.0;
+		for (uint64_t i = 1; i <= exact; i++)
+			sum += 1.0/pow((double)i, theta);
+
+		/* approximate the tail of huge ranges by the integral */
+		if (count > exact)
+			sum += (pow((double)count, 1.0 - theta)
+			      - pow((double)exact, 1.0 - theta))/(1.0 - theta);
+
+		return sum;
+	}
+
+	Zipf(uint64_t n, double theta) : n(max(n, (uint64_t)2)), theta(theta)
+	{
+		if (theta <= 0.0 || theta >= 1.0)
+			return;
+
+		zetan          = _zeta(this->n);
+		half_pow_theta = pow(0.5, theta);
+		alpha          = 1.0/(1.0 - theta);
+		eta            = (1.0 - pow(2.0/this->n, 1.0 - theta))
+		               / (1.0 - (1.0 + half_pow_theta)/zetan);
+	}
+
+	bool valid() const { return zetan > 0.0; }
+
+	uint64_t next(Random &random) const
+	{
+		double const u  = random.uniform();
+		double const uz = u*zetan;
+
+		if (uz < 1.0)                  return 0;
+		if (uz < 1.0 + half_pow_theta) return 1;
+
+		uint64_t const rank = (uint64_t)(n*pow(eta*u - eta + 1.0, alpha));
+		return min(rank, n - 1);
+	}
+};
+
+
+/**
+ * Histogram of request latencies in power-of-two buckets of microseconds
+ */
+struct Bench::Latency_histogram
+{
+	enum { BUCKETS = 24 };
+
+	unsigned long long count[BUCKETS] { };
+
+	/**
+	 * Return upper bound of bucket in microseconds
+	 */
+	static unsigned long long below_us(unsigned i) { return 2ULL << i; }
+
+	void add(unsigned long long us)
+	{
+		unsigned i = 0;
+		for (; i < BUCKETS - 1 && us >= below_us(i); i++);
+		count[i]++;
+	}
+
+	void add(Latency_histogram const &other)
+	{
+		for (unsigned i = 0; i < BUCKETS; i++)
+			count[i] += other.count[i];
+	}
+
+	/**
+	 * Return upper bound of the bucket that contains the given percentile
+	 */
+	unsigned long long percentile_us(unsigned percent) const
+	{
+		unsigned long long total = 0;
+		for (unsigned i = 0; i < BUCKETS; i++)
+			total += count[i];
+
+		unsigned long long const limit = (total*percent + 99)/100;
+		unsigned long long acc = 0;
+		for (unsigned i = 0; i < BUCKETS; i++) {
+			acc += count[i];
+			if (acc && acc >= limit)
+				return below_us(i);
+		}
+		return below_us(BUCKETS - 1);
+	}
+};
+
+
+struct Bench::Job_config
+{
+	enum Pattern { SEQUENTIAL, RANDOM, ZIPF };
+
+	Name     name;
+	Pattern  pattern;
+	size_t   request_size;
+	unsigned queue_depth;
+	unsigned read_percent;
+	unsigned threads;
+	uint64_t size;
+	uint64_t range;
+	unsigned long runtime_ms;
+	double   zipf_theta;
+
+	static Pattern _pattern(Xml_node node)
+	{
+		typedef String<16> Value;
+		Value const value = node.attribute_value("pattern", Value("sequential"));
+
+		if (value == "random") return RANDOM;
+		if (value == "zipf")   return ZIPF;
+		return SEQUENTIAL;
+	}
+
+	Job_config(Xml_node node)
+	:
+		name(node.attribute_value("name", Name("bench"))),
+		pattern(_pattern(node)),
+		request_size(node.attribute_value("request_size", Number_of_bytes(4096))),
+		queue_depth(max(1U, min(node.attribute_value("queue_depth", 16U),
+		                        (unsigned)Block::Session::TX_QUEUE_SIZE - 1))),
+		read_percent(min(node.attribute_value("read_percent", 100U), 100U)),
+		threads(max(1U, node.attribute_value("threads", 1U))),
+		size(node.attribute_value("size", Number_of_bytes(1024*1024*1024))),
+		range(node.attribute_value("range", Number_of_bytes(0))),
+		runtime_ms(node.attribute_value("runtime_ms", 0UL)),
+		zipf_theta(node.attribute_value("zipf_theta", 0.99))
+	{ }
+
+	char const *pattern_name() const
+	{
+		switch (pattern) {
+		case RANDOM: return "random";
+		case ZIPF:   return "zipf";
+		default:     return "sequential";
+		}
+	}
+};
+
+
+struct Bench::Stats
+{
+	unsigned long long requests    = 0;
+	unsigned long long errors      = 0;
+	unsigned long long read_bytes  = 0;
+	unsigned long long write_bytes = 0;
+	unsigned long long latency_us  = 0;
+	unsigned long long max_latency_us = 0;
+	unsigned long      duration_ms = 0;
+
+	Latency_histogram histogram;
+
+	void add(Stats const &other)
+	{
+		requests    += other.requests;
+		errors      += other.errors;
+		read_bytes  += other.read_bytes;
+		write_bytes += other.write_bytes;
+		latency_us  += other.latency_us;
+		max_latency_us = max(max_latency_us, other.max_latency_us);
+		duration_ms    = max(duration_ms, other.duration_ms);
+		histogram.add(other.histogram);
+	}
+};
+
+
+/**
+ * Thread that runs a job on a block session of its own
+ *
+ * The thread does not use signal handlers but blocks on the packet stream,
+ * which keeps the entrypoint out of the measured path.
+ *
+ * All times are taken from a timer session of the worker, which provides
+ * microseconds via 'curr_time'. The CPU timestamp is not used directly
+ * because it wraps around within seconds on some architectures and may
+ * not be accessible by user code at all.
+ */
+class Bench::Worker : public Thread, public List<Worker>::Element
 {
 	private:
 
-		typedef Genode::size_t size_t;
+		enum { STACK_SIZE = 4*1024*sizeof(long) };
+
+		/*
+		 * Number of completed requests between two checks of the deadline,
+		 * which keeps the timer RPCs out of the common path
+		 */
+		enum { DEADLINE_CHECK_INTERVAL = 32 };
+
+		Job_config const &_config;
+
+		Timer::Connection _timer;
+
+		Signal_context_capability const _done_sigh;
 
-		Env &             _env;
-		Heap              _heap    { _env.ram(), _env.rm() };
-		Allocator_avl     _alloc   { &_heap };
-		Block::Connection _session { _env, &_alloc, TX_BUFFER };
-		Timer::Connection _timer   { _env };
+		bool volatile _done = false;
 
-		Signal_handler<Throughput> _disp_ack    { _env.ep(), *this,
-		                                          &Throughput::_ack };
-		Signal_handler<Throughput> _disp_submit { _env.ep(), *this,
-		                                          &Throughput::_submit };
-		bool                          _read_done  = false;
-		bool                          _write_done = false;
+		Allocator_avl     _alloc;
+		Block::Connection _session;
 
-		unsigned long   _start = 0;
-		unsigned long   _stop  = 0;
-		size_t          _bytes = 0;
-		Block::sector_t _current = 0;
+		Block::sector_t           _blk_count = 0;
+		size_t                    _blk_size  = 0;
+		Block::Session::Operations _ops;
 
-		size_t          _blk_size;
-		Block::sector_t _blk_count;
+		Block::sector_t _blocks_per_request = 0;
+		uint64_t        _slots              = 0;
+		uint64_t        _next_slot          = 0;
 
-		void _submit()
+		Random _random;
+		Zipf   _zipf;
+
+		struct In_flight
 		{
-			static size_t count = REQUEST_SIZE / _blk_size;
+			Block::Packet_descriptor packet;
+			unsigned long long       submitted_us = 0;
+			bool                     used      = false;
+		};
 
-			if (_read_done && (_write_done || !TEST_WRITE))
-				return;
+		In_flight _in_flight[Block::Session::TX_QUEUE_SIZE];
 
-			try {
-				while (_session.tx()->ready_to_submit()) {
-					Block::Packet_descriptor p(
-						_session.tx()->alloc_packet(REQUEST_SIZE),
-						!_read_done ? Block::Packet_descriptor::READ : Block::Packet_descriptor::WRITE,
-						_current, count);
-
-					_session.tx()->submit_packet(p);
-
-					/* increment for next read */
-					_current += count;
-					if (_current + count >= _blk_count)
-						_current = 0;
+		Stats _stats;
+
+		static size_t _tx_buf_size(Job_config const &config)
+		{
+			enum { ALIGN_LOG2 = Block::Packet_descriptor::PACKET_ALIGNMENT };
+			return config.queue_depth * align_addr(config.request_size, ALIGN_LOG2)
+			       + 4096;
+		}
+
+		static Block::sector_t _slots_in_range(Job_config const &config,
+		                                       Block::sector_t blk_count,
+		                                       size_t blk_size,
+		                                       Block::sector_t blocks_per_request)
+		{
+			Block::sector_t blocks = blk_count;
+			if (config.range)
+				blocks = min(blocks, (Block::sector_t)(config.range/blk_size));
+
+			return blocks_per_request ? blocks/blocks_per_request : 0;
+		}
+
+		uint64_t _select_slot()
+		{
+			switch (_config.pattern) {
+
+			case Job_config::RANDOM:
+				return _random.next() % _slots;
+
+			case Job_config::ZIPF:
+				{
+					/*
+					 * Scatter the ranks over the range so that hot requests
+					 * are not adjacent on disk.
+					 */
+					enum { SCATTER = 2654435761ULL };
+					uint64_t const rank = _zipf.next(_random);
+					return _slots % SCATTER ? (rank*SCATTER) % _slots : rank;
 				}
-			} catch (...) { }
+
+			case Job_config::SEQUENTIAL:
+				break;
+			}
+
+			uint64_t const slot = _next_slot;
+			_next_slot = (_next_slot + 1) % _slots;
+			return slot;
 		}
 
-		void _ack()
+		bool _submit(uint64_t &issued)
 		{
-			while (_session.tx()->ack_avail()) {
+			if (issued >= _config.size)
+				return false;
 
-				Block::Packet_descriptor p = _session.tx()->get_acked_packet();
-				if (!p.succeeded())
-					error("packet error: block: ", p.block_number(), " "
-					      "count: ", p.block_count());
+			In_flight *slot = nullptr;
+			for (unsigned i = 0; i < _config.queue_depth && !slot; i++)
+				if (!_in_flight[i].used)
+					slot = &_in_flight[i];
 
-				if (!_read_done || (_read_done &&  p.operation() == Block::Packet_descriptor::WRITE))
-					_bytes += p.size();
+			if (!slot)
+				return false;
 
-				_session.tx()->release_packet(p);
+			bool const read = (_random.next() % 100) < _config.read_percent;
+
+			Block::Packet_descriptor::Opcode const op = read
+				? Block::Packet_descriptor::READ
+				: Block::Packet_descriptor::WRITE;
+
+			Block::sector_t const block = _select_slot()*_blocks_per_request;
+
+			try {
+				Block::Packet_descriptor const p(
+					_session.tx()->alloc_packet(_config.request_size),
+					op, block, _blocks_per_request);
+
+				slot->packet    = p;
+				slot->used      = true;
+				slot->submitted_us = _now_us();
+
+				_session.tx()->submit_packet(p);
+			} catch (Block::Session::Tx::Source::Packet_alloc_failed) {
+				return false; }
+
+			issued += _config.request_size;
+			return true;
+		}
+
+		unsigned long long _now_us() {
+			return _timer.curr_time().trunc_to_plain_us().value; }
+
+		void _complete(Block::Packet_descriptor const p, unsigned long long now_us)
+		{
+			In_flight *slot = nullptr;
+			for (unsigned i = 0; i < _config.queue_depth && !slot; i++)
+				if (_in_flight[i].used && _in_flight[i].packet.offset() == p.offset())
+					slot = &_in_flight[i];
+
+			if (slot) {
+				unsigned long long const us = now_us - slot->submitted_us;
+
+				_stats.latency_us    += us;
+				_stats.max_latency_us = max(_stats.max_latency_us, us);
+				_stats.histogram.add(us);
+				slot->used = false;
 			}
 
-			if (_bytes >= TEST_SIZE) {
-				_finish();
+			_stats.requests++;
+			if (!p.succeeded())
+				_stats.errors++;
+			else if (p.operation() == Block::Packet_descriptor::READ)
+				_stats.read_bytes += p.size();
+			else
+				_stats.write_bytes += p.size();
+
+			_session.tx()->release_packet(p);
+		}
+
+		void _run()
+		{
+			if (!_slots) {
+				error(_config.name, ": request size ", _config.request_size,
+				      " does not fit block size ", _blk_size, " and device");
 				return;
 			}
 
-			_submit();
+			unsigned long long const start_us = _now_us();
+			unsigned long long const runtime_us = _config.runtime_ms*1000ULL;
+
+			uint64_t issued    = 0;
+			unsigned in_flight = 0;
+			bool     expired   = false;
+
+			for (unsigned completed = 0; ; completed++) {
+
+				if (_config.runtime_ms && !(completed % DEADLINE_CHECK_INTERVAL))
+					expired = _now_us() - start_us >= runtime_us;
+
+				for (; !expired && _submit(issued); in_flight++);
+
+				if (!in_flight)
+					break;
+
+				/* block until the next request is completed */
+				Block::Packet_descriptor const p = _session.tx()->get_acked_packet();
+				_complete(p, _now_us());
+				in_flight--;
+			}
+
+			_stats.duration_ms = (_now_us() - start_us)/1000;
 		}
 
-		void _finish()
+		void entry() override
 		{
-			if (_read_done && (_write_done || !TEST_WRITE))
-				return;
+			_run();
+
+			_done = true;
+			Signal_transmitter(_done_sigh).submit();
+		}
+
+	public:
 
-			_stop = _timer.elapsed_ms();
-			log(!_read_done ? "Read" : "Wrote", " ", _bytes / 1024, " KiB in ",
-			    _stop - _start, " ms (",
-				((double)_bytes / (1024 * 1024)) / ((double)(_stop - _start) / 1000),
-				" MiB/s)");
-
-			/* start write */
-			if (!_read_done ) {
-				_read_done  = true;
-				_start      = _timer.elapsed_ms();
-				_bytes      = 0;
-				_current    = 0;
-				if (TEST_WRITE)
-					_submit();
-				else
-					log("Done");
-			} else if (!_write_done && TEST_WRITE) {
-				_write_done = true;
-				log("Done");
+		Worker(Env &env, Allocator &heap, Job_config const &config,
+		       char const *label, Signal_context_capability done_sigh,
+		       uint64_t seed)
+		:
+			Thread(env, "worker", STACK_SIZE),
+			_config(config), _timer(env), _done_sigh(done_sigh),
+			_alloc(&heap),
+			_session(env, &_alloc, _tx_buf_size(config), label),
+			_random(seed),
+			_zipf(1, 0)
+		{
+			/* switch the timer to 'curr_time' from the entrypoint */
+			_timer.curr_time();
+
+			_session.info(&_blk_count, &_blk_size, &_ops);
+
+			if (_blk_size && !(_config.request_size % _blk_size))
+				_blocks_per_request = _config.request_size/_blk_size;
+
+			_slots = _slots_in_range(_config, _blk_count, _blk_size,
+			                         _blocks_per_request);
+
+			if (_config.pattern == Job_config::ZIPF) {
+				_zipf = Zipf(_slots, _config.zipf_theta);
+				if (!_zipf.valid())
+					warning(_config.name, ": zipf_theta must be within (0, 1)");
 			}
+
+			bool const writes = _config.read_percent < 100;
+			if (writes && !_ops.supported(Block::Packet_descriptor::WRITE))
+				warning(_config.name, ": device is read-only, writes will fail");
 		}
 
+		Stats const &stats() const { return _stats; }
+
+		bool done() const { return _done; }
+};
+
+
+/**
+ * Job of the config with its worker threads
+ */
+class Bench::Job : public List<Job>::Element
+{
+	private:
+
+		Allocator        &_heap;
+		Job_config const  _config;
+		List<Worker>      _workers;
+
 	public:
 
-		Throughput(Env & env)
-		: _env(env)
+		Job(Env &env, Allocator &heap, Xml_node node,
+		    Signal_context_capability done_sigh, unsigned index)
+		: _heap(heap), _config(node)
 		{
-			_session.tx_channel()->sigh_ack_avail(_disp_ack);
-			_session.tx_channel()->sigh_ready_to_submit(_disp_submit);
+			for (unsigned i = 0; i < _config.threads; i++) {
 
-			Block::Session::Operations blk_ops;
-			_session.info(&_blk_count, &_blk_size, &blk_ops);
+				/* distinguish the sessions of several threads by their labels */
+				String<80> const label = _config.threads > 1
+				                       ? String<80>(_config.name, ".", i)
+				                       : String<80>(_config.name);
 
-			warning("block count ", _blk_count, " size ", _blk_size);
-			log("read/write ", TEST_SIZE / 1024, " KiB ...");
-			_start = _timer.elapsed_ms();
-			_submit();
+				_workers.insert(new (heap)
+					Worker(env, heap, _config, label.string(), done_sigh,
+					       ((uint64_t)index << 32) + i + 1));
+			}
 		}
+
+		~Job()
+		{
+			while (Worker *w = _workers.first()) {
+				_workers.remove(w);
+				destroy(_heap, w);
+			}
+		}
+
+		void start() { for (Worker *w = _workers.first(); w; w = w->next()) w->start(); }
+		void join()  { for (Worker *w = _workers.first(); w; w = w->next()) w->join();  }
+
+		bool done() const
+		{
+			for (Worker const *w = _workers.first(); w; w = w->next())
+				if (!w->done())
+					return false;
+			return true;
+		}
+
+		Job_config const &config() const { return _config; }
+
+		Stats stats() const
+		{
+			Stats stats;
+			for (Worker const *w = _workers.first(); w; w = w->next())
+				stats.add(w->stats());
+			return stats;
+		}
+};
+
+
+struct Bench::Main
+{
+	Env &_env;
+
+	Heap _heap { _env.ram(), _env.rm() };
+
+	Timer::Connection _timer { _env };
+
+	Reporter _reporter { _env, "results" };
+
+	List<Job> _jobs;
+
+	/*
+	 * The timer sessions interpolate 'curr_time' in microseconds only after
+	 * a few real-time updates, which happen every 500 ms. Hence, the jobs
+	 * are started after a warm-up period.
+	 */
+	enum { WARM_UP_US = 2*1000*1000 };
+
+	Timer::One_shot_timeout<Main> _warm_up { _timer, *this, &Main::_start };
+
+	Signal_handler<Main> _done_handler { _env.ep(), *this, &Main::_handle_done };
+
+	bool _finished = false;
+
+	void _start(Duration)
+	{
+		log("start job(s)");
+		for (Job *job = _jobs.first(); job; job = job->next()) job->start();
+	}
+
+	void _handle_done()
+	{
+		if (_finished)
+			return;
+
+		for (Job *job = _jobs.first(); job; job = job->next())
+			if (!job->done())
+				return;
+
+		_finished = true;
+
+		for (Job *job = _jobs.first(); job; job = job->next()) job->join();
+
+		if (_reporter.enabled()) {
+			Reporter::Xml_generator xml(_reporter, [&] () {
+				for (Job *job = _jobs.first(); job; job = job->next())
+					_result(*job, &xml);
+			});
+		} else {
+			for (Job *job = _jobs.first(); job; job = job->next())
+				_result(*job, nullptr);
+		}
+
+		log("Done");
+	}
+
+	void _result(Job const &job, Xml_generator *xml)
+	{
+		Job_config const &config = job.config();
+		Stats      const  stats  = job.stats();
+
+		unsigned long long const us    = stats.duration_ms*1000ULL;
+		unsigned long long const bytes = stats.read_bytes + stats.write_bytes;
+
+		unsigned long long const iops = us ? stats.requests*1000*1000/us : 0;
+		unsigned long long const kib_per_s = us ? (bytes*1000*1000/us)/1024 : 0;
+		unsigned long long const avg_us = stats.requests ? stats.latency_us/stats.requests : 0;
+
+		log(config.name, ": ", config.pattern_name(), " ",
+		    config.request_size, " bytes, ", config.read_percent, "% reads, "
+		    "depth ", config.queue_depth, ", ", config.threads, " thread(s): ",
+		    iops, " IOPS, ", kib_per_s, " KiB/s, latency avg ", avg_us, " us "
+		    "p50 ", stats.histogram.percentile_us(50), " us "
+		    "p99 ", stats.histogram.percentile_us(99), " us "
+		    "max ", stats.max_latency_us, " us");
+
+		if (stats.errors)
+			error(config.name, ": ", stats.errors, " requests failed");
+
+		if (!xml)
+			return;
+
+		xml->node("job", [&] () {
+			xml->attribute("name",         config.name);
+			xml->attribute("pattern",      config.pattern_name());
+			xml->attribute("request_size", config.request_size);
+			xml->attribute("queue_depth",  config.queue_depth);
+			xml->attribute("read_percent", config.read_percent);
+			xml->attribute("threads",      config.threads);
+			xml->attribute("requests",     stats.requests);
+			xml->attribute("errors",       stats.errors);
+			xml->attribute("read_bytes",   stats.read_bytes);
+			xml->attribute("write_bytes",  stats.write_bytes);
+			xml->attribute("duration_us",  us);
+			xml->attribute("iops",         iops);
+			xml->attribute("kib_per_s",    kib_per_s);
+			xml->attribute("avg_latency_us", avg_us);
+			xml->attribute("max_latency_us", stats.max_latency_us);
+			xml->attribute("p50_latency_us", stats.histogram.percentile_us(50));
+			xml->attribute("p90_latency_us", stats.histogram.percentile_us(90));
+			xml->attribute("p99_latency_us", stats.histogram.percentile_us(99));
+
+			for (unsigned i = 0; i < Latency_histogram::BUCKETS; i++) {
+				if (!stats.histogram.count[i])
+					continue;
+
+				xml->node("latency", [&] () {
+					xml->attribute("below_us", Latency_histogram::below_us(i));
+					xml->attribute("count",    stats.histogram.count[i]);
+				});
+			}
+		});
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		/*
+		 * Without any job, the benchmark reads the device sequentially
+		 * like the former throughput test.
+		 */
+		Xml_node config("<config><job/></config>");
+		Constructible<Attached_rom_dataspace> config_rom;
+		try {
+			config_rom.construct(_env, "config");
+			if (config_rom->xml().has_sub_node("job"))
+				config = config_rom->xml();
+		} catch (...) { }
+
+		try {
+			_reporter.enabled(config.sub_node("report")
+			                        .attribute_value("results", false));
+		} catch (...) { }
+
+		unsigned index = 0;
+		Job *last = nullptr;
+		config.for_each_sub_node("job", [&] (Xml_node node) {
+			Job *job = new (_heap) Job(_env, _heap, node, _done_handler, index++);
+			_jobs.insert(job, last);
+			last = job;
+		});
+
+		/* all jobs run concurrently, the last one to finish reports */
+		_warm_up.schedule(Microseconds(WARM_UP_US));
+	}
 };
 
 
-void Component::construct(Env &env) { static Throughput test(env); }
+void Component::construct(Genode::Env &env) { static Bench::Main main(env); }
@@ -68,6 +68,8 @@ class Driver : public Block::Driver
 			return ops;
 		}
 
+		unsigned queue_depth() override { return MAX_REQUESTS; }
+
 		void read(Block::sector_t           block_number,
 		          Genode::size_t            block_count,
 		          char                     *buffer,
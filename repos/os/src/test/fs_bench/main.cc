@@ -0,0 +1,155 @@
+/*
+ * \brief  File-system read-throughput benchmark
+ * \author Christian Helmuth
+ * \date   2017-06-14
+ *
+ * The benchmark reads a file sequentially while keeping a configurable
+ * number of read packets in flight. Several instances may be started to
+ * measure the throughput of a file-system server with concurrent readers.
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/heap.h>
+#include <base/log.h>
+#include <base/attached_rom_dataspace.h>
+#include <base/allocator_avl.h>
+#include <file_system_session/connection.h>
+#include <file_system/util.h>
+#include <timer_session/connection.h>
+#include <util/string.h>
+
+namespace Test {
+
+	using namespace Genode;
+
+	struct Main;
+}
+
+
+struct Test::Main
+{
+	typedef String<256> Path;
+
+	Env &_env;
+
+	Attached_rom_dataspace _config { _env, "config" };
+
+	Path const _file_path { _config.xml().attribute_value("file", Path("/bench.dat")) };
+
+	size_t const _request_size {
+		_config.xml().attribute_value("request_size", Number_of_bytes(64*1024)) };
+
+	unsigned const _queue_depth { min(_config.xml().attribute_value("queue_depth", 8U),
+	                                  (unsigned)File_system::Session::TX_QUEUE_SIZE) };
+
+	Heap          _heap     { _env.ram(), _env.rm() };
+	Allocator_avl _tx_alloc { &_heap };
+
+	File_system::Connection _fs { _env, _tx_alloc, "", "/", false,
+	                              _request_size*_queue_depth + 4096 };
+
+	File_system::Session::Tx::Source &_source = *_fs.tx();
+
+	Timer::Connection _timer { _env };
+
+	File_system::File_handle _file;
+
+	File_system::file_size_t _file_size = 0;
+	File_system::seek_off_t  _submit_offset = 0;
+	unsigned long            _bytes_read = 0;
+	unsigned                 _in_flight  = 0;
+	unsigned long            _start_ms   = 0;
+
+	Io_signal_handler<Main> _packet_handler { _env.ep(), *this, &Main::_handle_packets };
+
+	void _submit()
+	{
+		while (_in_flight < _queue_depth && _submit_offset < _file_size
+		    && _source.ready_to_submit()) {
+
+			size_t const length = min((File_system::file_size_t)_request_size,
+			                          _file_size - _submit_offset);
+
+			File_system::Packet_descriptor
+				packet(_source.alloc_packet(length), _file,
+				       File_system::Packet_descriptor::READ, length,
+				       _submit_offset);
+
+			_source.submit_packet(packet);
+			_submit_offset += length;
+			_in_flight++;
+		}
+	}
+
+	void _finish()
+	{
+		unsigned long const ms = max(1UL, _timer.elapsed_ms() - _start_ms);
+		log("read ", _bytes_read / 1024, " KiB in ", ms, " ms, ",
+		    (_bytes_read / 1024) * 1000 / ms / 1024, " MiB/s "
+		    "(request size ", _request_size, ", queue depth ", _queue_depth, ")");
+		log("--- file-system benchmark finished ---");
+		_env.parent().exit(0);
+	}
+
+	void _handle_packets()
+	{
+		while (_source.ack_avail()) {
+			File_system::Packet_descriptor packet = _source.get_acked_packet();
+
+			if (!packet.succeeded()) {
+				error("read at offset ", packet.position(), " failed");
+				_env.parent().exit(-1);
+				return;
+			}
+			_bytes_read += packet.length();
+			_in_flight--;
+			_source.release_packet(packet);
+		}
+
+		if (_bytes_read >= _file_size) {
+			_finish();
+			return;
+		}
+		_submit();
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		using namespace File_system;
+
+		log("--- file-system benchmark started ---");
+
+		Genode::Path<256> dir_path(_file_path.string());
+		dir_path.strip_last_element();
+		Genode::Path<256> file_name(_file_path.string());
+		file_name.keep_only_last_element();
+
+		Dir_handle dir = _fs.dir(dir_path.base(), false);
+		Handle_guard dir_guard(_fs, dir);
+
+		_file      = _fs.file(dir, file_name.base() + 1, READ_ONLY, false);
+		_file_size = _fs.status(_file).size;
+		if (!_file_size) {
+			error("file ", _file_path, " is empty");
+			_env.parent().exit(-1);
+			return;
+		}
+
+		_fs.sigh_ack_avail(_packet_handler);
+		_fs.sigh_ready_to_submit(_packet_handler);
+
+		_start_ms = _timer.elapsed_ms();
+		_submit();
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
@@ -0,0 +1,169 @@
+/*
+ * \brief  Test and benchmark of the internet-checksum implementation
+ * \author agent
+ * \date   2026-10-18
+ */
+
+/*
+ * Copyright (C) 2026 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/log.h>
+#include <timer_session/connection.h>
+#include <net/internet_checksum.h>
+
+using namespace Genode;
+
+
+/**
+ * Straight-forward 16-bit-wise calculation as reference
+ */
+static uint16_t reference_checksum(uint8_t const *data, size_t size)
+{
+	uint32_t sum = 0;
+	for (size_t i = 0; i + 1 < size; i += 2) {
+		sum += (data[i] << 8) | data[i + 1]; }
+
+	if (size & 1) {
+		sum += data[size - 1] << 8; }
+
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16); }
+
+	return ~sum;
+}
+
+
+struct Main
+{
+	enum { DURATION_MS = 1000, MAX_SIZE = 9000, BUF_SIZE = MAX_SIZE + 8 };
+
+	Env               &env;
+	Timer::Connection  timer { env };
+	uint8_t            buf[BUF_SIZE];
+	uint32_t           seed  { 0x12345678 };
+
+	uint8_t random()
+	{
+		seed = seed * 1103515245 + 12345;
+		return seed >> 16;
+	}
+
+	void fill() { for (unsigned i = 0; i < BUF_SIZE; i++) { buf[i] = random(); } }
+
+	bool test_checksum()
+	{
+		for (unsigned round = 0; round < 16; round++) {
+			fill();
+			if (round == 0) {
+				memset(buf, 0xff, BUF_SIZE); }
+
+			for (size_t offset = 0; offset < 8; offset++) {
+				for (size_t size = 0; size < 256; size++) {
+					if (Net::internet_checksum(buf + offset, size) !=
+					    reference_checksum(buf + offset, size))
+					{
+						error("wrong checksum at offset ", offset,
+						      " size ", size);
+						return false;
+					}
+				}
+				if (Net::internet_checksum(buf + offset, MAX_SIZE) !=
+				    reference_checksum(buf + offset, MAX_SIZE))
+				{
+					error("wrong checksum at offset ", offset,
+					      " size ", (size_t)MAX_SIZE);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool test_update()
+	{
+		for (unsigned round = 0; round < 1024; round++) {
+			fill();
+			size_t   const size     = 64 + (round % 64) * 2;
+			uint16_t const checksum = reference_checksum(buf, size);
+
+			/* rewrite an IPv4 address and a port like NAT does */
+			uint8_t const old_ip[4]  = { buf[12], buf[13], buf[14], buf[15] };
+			uint16_t const old_port  = (buf[20] << 8) | buf[21];
+			for (unsigned i = 12; i < 16; i++) {
+				buf[i] = random(); }
+
+			buf[20] = random();
+			buf[21] = random();
+			uint16_t const new_port = (buf[20] << 8) | buf[21];
+
+			uint16_t updated =
+				Net::internet_checksum_update(checksum, old_ip, buf + 12, 4);
+			updated = Net::internet_checksum_update(updated, old_port, new_port);
+
+			/* 0x0000 and 0xffff both represent zero in one's complement */
+			uint16_t const expected = reference_checksum(buf, size);
+			if (updated != expected &&
+			    (uint16_t)(updated + 1) > 1 && (uint16_t)(expected + 1) > 1)
+			{
+				error("wrong updated checksum ", Hex(updated),
+				      " expected ", Hex(expected));
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <typename FN>
+	void bench(char const *name, size_t size, FN const &fn)
+	{
+		unsigned long  bytes    = 0;
+		uint16_t       result   = 0;
+		unsigned const start_ms = timer.elapsed_ms();
+		unsigned       end_ms   = start_ms;
+		for (; end_ms - start_ms < DURATION_MS; end_ms = timer.elapsed_ms()) {
+			/* start two bytes off, like IP headers in ethernet frames */
+			for (unsigned i = 0; i < 1000; i++) {
+				result += fn(buf + 2, size); }
+
+			bytes += size * 1000;
+		}
+		unsigned long long const bytes_per_s =
+			(unsigned long long)bytes * 1000 / (end_ms - start_ms);
+		log(name, " ", size, " bytes: ",
+		    bytes_per_s / (1024*1024), " MiB/s (", result, ")");
+	}
+
+	Main(Env &env) : env(env)
+	{
+		log("--- Internet checksum test ---");
+
+		if (!test_checksum() || !test_update()) {
+			env.parent().exit(-1);
+			return;
+		}
+		log("checksum results match the reference");
+
+		fill();
+
+		/* MTU-sized and jumbo frames */
+		size_t const sizes[] = { 1500, MAX_SIZE };
+		for (size_t size : sizes) {
+			bench("reference", size, [&] (uint8_t const *data, size_t size) {
+				return reference_checksum(data, size); });
+
+			bench("optimized", size, [&] (uint8_t const *data, size_t size) {
+				return Net::internet_checksum(data, size); });
+		}
+		log("--- Internet checksum test finished ---");
+		env.parent().exit(0);
+	}
+};
+
+
+void Component::construct(Env &env) { static Main main(env); }
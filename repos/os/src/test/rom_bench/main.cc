@@ -0,0 +1,132 @@
+/*
+ * \brief  Benchmark for ROM servers with concurrent clients
+ * \author Christian Helmuth
+ * \date   2017-06-20
+ *
+ * Several client threads each open a ROM session and call the session's
+ * 'dataspace' function in a loop. The benchmark is repeated for each
+ * '<server>' node of the config. The session labels are prefixed with the
+ * server name so that the sessions can be routed to different servers.
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/heap.h>
+#include <base/log.h>
+#include <base/thread.h>
+#include <base/semaphore.h>
+#include <base/attached_rom_dataspace.h>
+#include <rom_session/connection.h>
+#include <timer_session/connection.h>
+
+namespace Test {
+
+	using namespace Genode;
+
+	struct Client_thread;
+	struct Main;
+
+	typedef String<64>  Server_name;
+	typedef String<128> Label;
+}
+
+
+struct Test::Client_thread : Thread
+{
+	enum { STACK_SIZE = 4*1024*sizeof(long) };
+
+	Env           &_env;
+	Label    const _label;
+	unsigned const _rounds;
+	Semaphore     &_done;
+
+	Client_thread(Env &env, Label const &label, unsigned rounds,
+	              Semaphore &done, Affinity::Location location)
+	:
+		Thread(env, "client", STACK_SIZE, location, Weight(), env.cpu()),
+		_env(env), _label(label), _rounds(rounds), _done(done)
+	{ }
+
+	struct Invalid_dataspace : Exception { };
+
+	void entry() override
+	{
+		Rom_connection rom(_env, _label.string());
+
+		for (unsigned i = 0; i < _rounds; i++)
+			if (!rom.dataspace().valid())
+				throw Invalid_dataspace();
+
+		_done.up();
+	}
+};
+
+
+struct Test::Main
+{
+	Env &_env;
+
+	Attached_rom_dataspace _config { _env, "config" };
+
+	Heap _heap { _env.ram(), _env.rm() };
+
+	Timer::Connection _timer { _env };
+
+	unsigned const _threads { _config.xml().attribute_value("threads", 4U) };
+	unsigned const _rounds  { _config.xml().attribute_value("rounds", 10000U) };
+
+	void _measure(Server_name const &server)
+	{
+		Affinity::Space cpus = _env.cpu().affinity_space();
+
+		Semaphore done;
+		Client_thread **clients = new (_heap) Client_thread*[_threads];
+
+		for (unsigned i = 0; i < _threads; i++)
+			clients[i] = new (_heap)
+				Client_thread(_env, Label(server, " -> file", i), _rounds, done,
+				              cpus.location_of_index(i % cpus.total()));
+
+		unsigned long const start_ms = _timer.elapsed_ms();
+
+		for (unsigned i = 0; i < _threads; i++)
+			clients[i]->start();
+
+		for (unsigned i = 0; i < _threads; i++)
+			done.down();
+
+		unsigned long const duration_ms =
+			max(_timer.elapsed_ms() - start_ms, 1UL);
+
+		for (unsigned i = 0; i < _threads; i++) {
+			clients[i]->join();
+			destroy(_heap, clients[i]);
+		}
+		destroy(_heap, clients);
+
+		unsigned long const calls = (unsigned long)_threads*_rounds;
+
+		log(server, ": ", _threads, " clients, ", calls, " calls in ",
+		    duration_ms, " ms, ", calls*1000/duration_ms, " calls/s");
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- ROM benchmark started ---");
+
+		_config.xml().for_each_sub_node("server", [&] (Xml_node server) {
+			_measure(server.attribute_value("name", Server_name())); });
+
+		log("--- ROM benchmark finished ---");
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
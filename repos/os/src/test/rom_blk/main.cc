@@ -68,7 +68,7 @@ struct Main
 				throw Read_request_failed(); }
 
 			char const *rom_src = rom.local_addr<char>() + i * blk_sz;
-			if (strcmp(rom_src, src.packet_content(pkt), rom.size())) {
+			if (memcmp(rom_src, src.packet_content(pkt), cnt * blk_sz)) {
 				throw Files_differ(); }
 
 			src.release_packet(pkt);
@@ -356,7 +356,7 @@ struct Noux::Sysio
 
 	enum Kill_error      { KILL_ERR_SRCH };
 
-	union {
+	union Error {
 		Vfs::Directory_service::General_error   general;
 		Vfs::Directory_service::Stat_result     stat;
 		Vfs::File_io_service::Ftruncate_result  ftruncate;
@@ -389,6 +389,59 @@ struct Noux::Sysio
 
 	} error;
 
+	/**
+	 * Syscalls queued by the child
+	 *
+	 * The queued syscalls are executed in order by Noux at the beginning of
+	 * the next syscall. Each entry carries the leading part of the
+	 * arguments, which suffices for syscalls without bulk data. The
+	 * results are stored in the entries.
+	 */
+	struct Batch
+	{
+		enum { MAX_ENTRIES = 16, ARGS_SIZE = 576 };
+
+		struct Entry
+		{
+			int             syscall;
+			bool            result;
+			Error           error;
+			char            args[ARGS_SIZE];
+
+			/**
+			 * Return arguments as the type of a sysio member, e.g.,
+			 * 'decltype(Sysio::close_in)'
+			 */
+			template <typename T>
+			T &args_as()
+			{
+				static_assert(sizeof(T) <= ARGS_SIZE, "arguments too large");
+				return *reinterpret_cast<T *>(args);
+			}
+		};
+
+		unsigned count;
+		Entry    entries[MAX_ENTRIES];
+
+		bool full() const { return count >= MAX_ENTRIES; }
+
+	} batch;
+
+	/**
+	 * Return start of the arguments and results of the current syscall
+	 */
+	char *args() { return reinterpret_cast<char *>(&write_in); }
+
+	/**
+	 * Return size of the arguments and results of the current syscall
+	 */
+	size_t args_size() const {
+		return reinterpret_cast<char const *>(this + 1)
+		     - reinterpret_cast<char const *>(&write_in); }
+
+	/*
+	 * The arguments must remain the last member of the structure
+	 */
 	union {
 
 		SYSIO_DECL(write,       { int fd; size_t count; Chunk chunk; },
@@ -428,7 +481,7 @@ struct Noux::Sysio
 		                        { Select_fds fds; });
 
 		SYSIO_DECL(fork,        { addr_t ip; addr_t sp;
-		                          addr_t parent_cap_addr; },
+		                          addr_t parent_cap_addr; bool vfork; },
 		                        { int pid; });
 
 		SYSIO_DECL(getpid,      { }, { int pid; });
@@ -166,6 +166,10 @@ static struct sigaction signal_action[NSIG+1];
 static sigset_t signal_mask;
 
 
+/* true while a signal handler is executed */
+static bool in_sigh = false;
+
+
 static bool noux_syscall(Noux::Session::Syscall opcode)
 {
 	/*
@@ -178,8 +182,6 @@ static bool noux_syscall(Noux::Session::Syscall opcode)
 
 	bool ret = noux()->syscall(opcode);
 
-	static bool in_sigh = false; /* true if called from signal handler */
-
 	if (in_sigh)
 		return ret;
 
@@ -219,6 +221,36 @@ static bool noux_syscall(Noux::Session::Syscall opcode)
 }
 
 
+/**
+ * Queueing of syscalls can be disabled via the environment variable
+ * 'NOUX_SYSCALL_BATCH=no', e.g., for comparing the performance
+ */
+static bool syscall_batching = true;
+
+
+/**
+ * Queue syscall to be executed by Noux prior the next syscall
+ *
+ * Used for syscalls whose result is of no interest to the caller. Within
+ * a signal handler, syscalls are not queued because the sysio content is
+ * restored after executing the handler.
+ *
+ * \return  entry to be filled with the syscall arguments, or nullptr if
+ *          the syscall must be issued immediately
+ */
+static Noux::Sysio::Batch::Entry *queue_syscall(Noux::Session::Syscall opcode)
+{
+	Noux::Sysio::Batch &batch = sysio()->batch;
+
+	if (!syscall_batching || in_sigh || batch.full())
+		return nullptr;
+
+	Noux::Sysio::Batch::Entry &entry = batch.entries[batch.count++];
+	entry.syscall = opcode;
+	return &entry;
+}
+
+
 enum { FS_BLOCK_SIZE = 1024 };
 
 
@@ -580,6 +612,7 @@ extern "C" void fork_trampoline()
 
 
 static pid_t fork_result;
+static bool  fork_is_vfork;
 
 
 /**
@@ -614,6 +647,7 @@ static void suspended_callback()
 		sysio()->fork_in.ip = (Genode::addr_t)(&fork_trampoline);
 		sysio()->fork_in.sp = Abi::stack_align((Genode::addr_t)&stack[STACK_SIZE]);
 		sysio()->fork_in.parent_cap_addr = (Genode::addr_t)(&new_parent);
+		sysio()->fork_in.vfork = fork_is_vfork;
 
 		if (!noux_syscall(Noux::Session::SYSCALL_FORK)) {
 			error("fork error ", (int)sysio()->error.general);
@@ -635,13 +669,27 @@ namespace Libc { void schedule_suspend(void (*suspended) ()); }
 
 extern "C" pid_t fork(void)
 {
+	fork_is_vfork = false;
+
 	Libc::schedule_suspend(suspended_callback);
 
 	return fork_result;
 }
 
 
-extern "C" pid_t vfork(void) { return fork(); }
+/*
+ * The parent stays blocked until the child calls 'execve' or exits. In
+ * contrast to the traditional 'vfork', the child operates on a copy of the
+ * address space, which is populated on demand.
+ */
+extern "C" pid_t vfork(void)
+{
+	fork_is_vfork = true;
+
+	Libc::schedule_suspend(suspended_callback);
+
+	return fork_result;
+}
 
 
 extern "C" pid_t getpid(void)
@@ -936,6 +984,30 @@ static Libc::Plugin_context *noux_context(int noux_fd)
 }
 
 
+/**
+ * File descriptors that may be closed lazily
+ *
+ * The close of a pipe or socket must reach Noux immediately because the
+ * peer waits for it, e.g., a reader for the end of file. Hence, only the
+ * close of descriptors obtained via 'open' is queued. Inherited descriptors
+ * are closed immediately as their kind is unknown.
+ */
+enum { MAX_LAZY_CLOSE_FDS = 64 };
+
+static bool lazy_close_fd[MAX_LAZY_CLOSE_FDS];
+
+static void lazy_close(int noux_fd, bool lazy)
+{
+	if (noux_fd >= 0 && noux_fd < MAX_LAZY_CLOSE_FDS)
+		lazy_close_fd[noux_fd] = lazy;
+}
+
+static bool lazy_close(int noux_fd)
+{
+	return noux_fd >= 0 && noux_fd < MAX_LAZY_CLOSE_FDS && lazy_close_fd[noux_fd];
+}
+
+
 namespace {
 
 	class Plugin : public Libc::Plugin
@@ -1175,6 +1247,7 @@ namespace {
 		Libc::Plugin_context *context = noux_context(sysio()->open_out.fd);
 		Libc::File_descriptor *fd =
 		    Libc::file_descriptor_allocator()->alloc(this, context, sysio()->open_out.fd);
+		lazy_close(sysio()->open_out.fd, true);
 		if ((flags & O_TRUNC) && (ftruncate(fd, 0) == -1))
 			return 0;
 		return fd;
@@ -1312,7 +1385,25 @@ namespace {
 
 	int Plugin::close(Libc::File_descriptor *fd)
 	{
-		sysio()->close_in.fd = noux_fd(fd->context);
+		int const nfd = noux_fd(fd->context);
+
+		/*
+		 * Closing a valid file descriptor cannot fail, so we save the RPC
+		 * by letting the close piggyback on the next syscall.
+		 */
+		Noux::Sysio::Batch::Entry *entry = nullptr;
+		if (lazy_close(nfd))
+			entry = queue_syscall(Noux::Session::SYSCALL_CLOSE);
+
+		lazy_close(nfd, false);
+
+		if (entry) {
+			entry->args_as<decltype(Noux::Sysio::close_in)>().fd = nfd;
+			Libc::file_descriptor_allocator()->free(fd);
+			return 0;
+		}
+
+		sysio()->close_in.fd = nfd;
 		if (!noux_syscall(Noux::Session::SYSCALL_CLOSE)) {
 			error("close error");
 			/* XXX set errno */
@@ -1501,6 +1592,9 @@ namespace {
 		 */
 		new_fd->context = noux_context(new_fd->libc_fd);
 
+		/* the descriptor may become a pipe or socket */
+		lazy_close(noux_fd(new_fd->context), false);
+
 		sysio()->dup2_in.fd    = noux_fd(fd->context);
 		sysio()->dup2_in.to_fd = noux_fd(new_fd->context);
 
@@ -1595,6 +1689,16 @@ namespace {
 			return 0;
 
 		case F_SETFD:
+
+			/* setting the close-on-execve flag of a valid fd cannot fail */
+			if (Noux::Sysio::Batch::Entry *entry = queue_syscall(Noux::Session::SYSCALL_FCNTL)) {
+				auto &args = entry->args_as<decltype(Noux::Sysio::fcntl_in)>();
+				args.fd       = noux_fd(fd->context);
+				args.cmd      = Noux::Sysio::FCNTL_CMD_SET_FD_FLAGS;
+				args.long_arg = arg;
+				return 0;
+			}
+
 			sysio()->fcntl_in.cmd      = Noux::Sysio::FCNTL_CMD_SET_FD_FLAGS;
 			sysio()->fcntl_in.long_arg = arg;
 			break;
@@ -2321,6 +2425,10 @@ void Plugin::init(Genode::Env &env)
 		    (strncmp(env_string, "NOUX_CWD=", strlen("NOUX_CWD=")) == 0)) {
 			noux_cwd.import(&env_string[strlen("NOUX_CWD=")]);
 		} else {
+			/* the variable stays in the environment for child processes */
+			if (strcmp(env_string, "NOUX_SYSCALL_BATCH=no") == 0)
+				syscall_batching = false;
+
 			env_array[num_entries++] = env_string;
 		}
 		env_string += (strlen(env_string) + 1);
@@ -37,6 +37,7 @@
 #include <verbose.h>
 #include <user_info.h>
 #include <timeout_scheduler.h>
+#include <lazy_fork.h>
 
 namespace Noux {
 
@@ -60,6 +61,17 @@ namespace Noux {
 	 */
 	bool init_process(Child *child);
 	void init_process_exited(int);
+
+	/**
+	 * Return true if the address space of a forking process is copied
+	 * on demand
+	 */
+	bool lazy_fork_enabled();
+
+	/**
+	 * Return buffer size of pipes in bytes
+	 */
+	size_t pipe_size();
 }
 
 
@@ -219,6 +231,78 @@ class Noux::Child : public Rpc_object<Session>,
 
 		Genode::Child _child;
 
+		/**
+		 * Lazy fork of the parent's address space, present until the
+		 * parent got released
+		 */
+		Lazy_fork_state *_lazy_fork = nullptr;
+		bool             _vforked   = false;
+
+		/**
+		 * Release the parent blocked in the fork syscall
+		 *
+		 * \param complete  copy the remaining parts of the address space,
+		 *                  otherwise they are abandoned
+		 */
+		void _release_lazy_fork(bool complete)
+		{
+			if (!_lazy_fork)
+				return;
+
+			if (complete) _lazy_fork->complete();
+			else          _lazy_fork->abandon();
+
+			_lazy_fork->unref();
+			_lazy_fork = nullptr;
+		}
+
+		/**
+		 * Return true if syscall does not require the parent to resume
+		 */
+		static bool _harmless_for_lazy_fork(Syscall sc)
+		{
+			switch (sc) {
+			case SYSCALL_GETPID:       case SYSCALL_CLOSE:
+			case SYSCALL_DUP2:         case SYSCALL_FCNTL:
+			case SYSCALL_STAT:         case SYSCALL_LSTAT:
+			case SYSCALL_FSTAT:        case SYSCALL_GETTIMEOFDAY:
+			case SYSCALL_CLOCK_GETTIME:case SYSCALL_GETDTABLESIZE:
+			case SYSCALL_USERINFO:     case SYSCALL_EXECVE:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		/**
+		 * Buffer for preserving the arguments of a syscall while executing
+		 * the syscalls queued in front of it, allocated on first use
+		 */
+		char *_saved_args = nullptr;
+
+		/**
+		 * Execute syscalls queued by the child
+		 */
+		void _execute_batch();
+
+		/**
+		 * Return true if syscall may be queued in the sysio batch
+		 *
+		 * Only the syscalls queued by libc_noux are accepted, which neither
+		 * block nor transfer bulk data and whose results are of no interest
+		 * to the caller.
+		 */
+		static bool _batchable(Syscall sc)
+		{
+			switch (sc) {
+			case SYSCALL_CLOSE:
+			case SYSCALL_FCNTL:
+				return true;
+			default:
+				return false;
+			}
+		}
+
 		/**
 		 * Exception type for failed file-descriptor lookup
 		 */
@@ -254,9 +338,11 @@ class Noux::Child : public Rpc_object<Session>,
 		 * \param rd  check for data available for reading
 		 * \param wr  check for readiness for writing
 		 * \param ex  check for exceptions
+		 * \param offer  buffer for receiving data directly, or nullptr
 		 */
 		void _block_for_io_channel(Shared_pointer<Io_channel> &io,
-		                           bool rd, bool wr, bool ex)
+		                           bool rd, bool wr, bool ex,
+		                           Read_offer *offer = nullptr)
 		{
 			/* reset the blocker lock to the 'locked' state */
 			_blocker.unlock();
@@ -267,6 +353,7 @@ class Noux::Child : public Rpc_object<Session>,
 
 			for (;;) {
 				if (io->check_unblock(rd, wr, ex) ||
+				    (offer && offer->count) ||
 				    !_pending_signals.empty())
 					break;
 
@@ -371,10 +458,30 @@ class Noux::Child : public Rpc_object<Session>,
 			}
 		}
 
-		~Child() { _destruct(); }
+		~Child()
+		{
+			_release_lazy_fork(false);
+			_destruct();
+
+			if (_saved_args)
+				_heap.free(_saved_args, _sysio.args_size());
+		}
 
 		void start() { _ep.activate(); }
 
+		/**
+		 * Assign lazy fork of the parent's address space
+		 *
+		 * \param vfork  keep the parent blocked until the child calls
+		 *               'execve' or exits
+		 */
+		void lazy_fork(Lazy_fork_state &lazy_fork, bool vfork)
+		{
+			lazy_fork.ref();
+			_lazy_fork = &lazy_fork;
+			_vforked   = vfork;
+		}
+
 		void start_forked_main_thread(addr_t ip, addr_t sp, addr_t parent_cap_addr)
 		{
 			/* poke parent_cap_addr into child's address space */
@@ -493,6 +600,12 @@ class Noux::Child : public Rpc_object<Session>,
 		 ** Family_member interface **
 		 *****************************/
 
+		void exit(int exit_status) override
+		{
+			_release_lazy_fork(false);
+			Family_member::exit(exit_status);
+		}
+
 		void submit_signal(Noux::Sysio::Signal sig)
 		{
 			try {
@@ -531,6 +644,9 @@ class Noux::Child : public Rpc_object<Session>,
 
 			_assign_io_channels_to(child);
 
+			/* our address space is not needed by the parent anymore */
+			_release_lazy_fork(false);
+
 			/* move the signal queue */
 			while (!_pending_signals.empty())
 				child->_pending_signals.add(_pending_signals.get());
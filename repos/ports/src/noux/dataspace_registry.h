@@ -23,6 +23,8 @@ namespace Noux {
 	class Dataspace_info;
 	class Dataspace_registry;
 
+	struct Lazy_fork;
+
 	struct Static_dataspace_info;
 
 	using namespace Genode;
@@ -35,6 +37,24 @@ struct Noux::Dataspace_user : List<Dataspace_user>::Element
 };
 
 
+/**
+ * Interface for creating copies of RAM dataspaces that are populated on
+ * demand, used while forking a process
+ */
+struct Noux::Lazy_fork
+{
+	/**
+	 * Create copy of dataspace
+	 *
+	 * \param content  dataspace holding the content to be copied
+	 *
+	 * \return  capability for the new dataspace, or an invalid capability
+	 *          if the dataspace must be copied eagerly
+	 */
+	virtual Dataspace_capability fork(Dataspace_capability content) = 0;
+};
+
+
 class Noux::Dataspace_info : public Object_pool<Dataspace_info>::Entry
 {
 	private:
@@ -108,6 +128,18 @@ class Noux::Dataspace_info : public Object_pool<Dataspace_info>::Entry
 		                                  Dataspace_registry &ds_registry,
 		                                  Rpc_entrypoint     &ep) = 0;
 
+		/**
+		 * Create copy of dataspace that is populated on demand
+		 *
+		 * \return  capability for the new dataspace, or an invalid
+		 *          capability if the dataspace cannot be forked lazily,
+		 *          in which case 'fork' is used
+		 */
+		virtual Dataspace_capability fork_lazily(Lazy_fork &)
+		{
+			return Dataspace_capability();
+		}
+
 		/**
 		 * Write raw byte sequence into dataspace
 		 *
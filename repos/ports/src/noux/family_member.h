@@ -135,7 +135,7 @@ class Noux::Family_member : public List<Family_member>::Element,
 		/**
 		 * Tell the parent that we exited
 		 */
-		void exit(int exit_status)
+		virtual void exit(int exit_status)
 		{
 			_exit_status = exit_status;
 			_has_exited  = true;
@@ -32,6 +32,7 @@ namespace Noux {
 
 	class Io_channel_backend;
 	class Io_channel;
+	struct Read_offer;
 
 	class Terminal_io_channel;
 }
@@ -50,6 +51,22 @@ struct Noux::Io_channel_backend
 };
 
 
+/**
+ * Destination buffer of a blocking read
+ *
+ * While blocked, a reader offers its buffer to the I/O channel, which may
+ * fill it directly instead of buffering the data.
+ */
+struct Noux::Read_offer : List<Read_offer>::Element
+{
+	char   * const dst;
+	size_t   const max;
+	size_t         count = 0;
+
+	Read_offer(char *dst, size_t max) : dst(dst), max(max) { }
+};
+
+
 /**
  * Input/output channel interface
  */
@@ -95,6 +112,16 @@ class Noux::Io_channel : public Reference_counter
 		virtual bool check_unblock(bool rd, bool wr, bool ex) const {
 			return false; }
 
+		/**
+		 * Offer buffer of a reader that is about to block
+		 *
+		 * Once the channel stored data in the buffer, it sets 'count' and
+		 * wakes up the reader. The offer must be withdrawn before 'read'
+		 * is called.
+		 */
+		virtual void    offer_read(Read_offer &) { }
+		virtual void withdraw_read(Read_offer &) { }
+
 		/**
 		 * Return true if the channel is set to non-blocking mode
 		 */
@@ -0,0 +1,475 @@
+/*
+ * \brief  Fork of RAM dataspaces that are populated on demand
+ * \author Norman Feske
+ * \date   2017-06-22
+ *
+ * Copying the complete address space at fork time is wasted effort if the
+ * new process calls 'execve' or '_exit' right away, which is the common case
+ * for shells and build tools. Instead of a plain copy, each forked RAM
+ * dataspace is represented by a managed dataspace. A fault within the
+ * managed dataspace populates the faulting chunk by copying it from the
+ * parent's dataspace and attaching the corresponding window of a backing
+ * RAM dataspace. There is no way to write-protect the parent's memory.
+ * Hence, the parent stays blocked within the fork syscall until the child
+ * calls 'execve' or exits, or the remaining chunks got copied. The latter
+ * happens as soon as the child performs a syscall that may interact with
+ * the parent or after a short timeout.
+ */
+
+/*
+ * Copyright (C) 2017 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _NOUX__LAZY_FORK_H_
+#define _NOUX__LAZY_FORK_H_
+
+/* Genode includes */
+#include <rm_session/connection.h>
+#include <region_map/client.h>
+
+/* Noux includes */
+#include <pd_session_component.h>
+#include <timeout_scheduler.h>
+
+namespace Noux {
+	class Lazy_ram_dataspace_info;
+	class Lazy_fork_state;
+}
+
+
+class Noux::Lazy_ram_dataspace_info : public Ram_dataspace_info,
+                                      public List<Lazy_ram_dataspace_info>::Element
+{
+	private:
+
+		friend class Lazy_fork_state;
+
+		enum { CHUNK_SIZE = 64*1024 };
+
+		Env             &_env;
+		Allocator       &_alloc;
+		Lazy_fork_state &_state;
+
+		Region_map_client        _sub_rm;
+		Ram_dataspace_capability _backing;
+
+		/* dataspace of the parent holding the content to be copied */
+		Dataspace_capability const _content;
+
+		size_t const _num_chunks = (size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+		bool * const _populated = (bool *)_alloc.alloc(_num_chunks*sizeof(bool));
+
+		/* local mappings, present while the parent is blocked */
+		char *_content_local = nullptr;
+		char *_backing_local = nullptr;
+
+		Signal_handler<Lazy_ram_dataspace_info> _fault_handler {
+			_env.ep(), *this, &Lazy_ram_dataspace_info::_handle_fault };
+
+		Lazy_ram_dataspace_info *_next_info() {
+			return List<Lazy_ram_dataspace_info>::Element::next(); }
+
+		inline void _handle_fault();
+
+		inline void _attach_locally();
+		inline void _detach_locally();
+
+		/**
+		 * Make chunks [first, first + num) accessible to the child
+		 *
+		 * The chunks are copied from the parent unless the lazy fork is
+		 * released already.
+		 */
+		inline void _populate(size_t first, size_t num);
+
+		/**
+		 * Populate all remaining chunks
+		 */
+		void _complete()
+		{
+			for (size_t i = 0; i < _num_chunks; ) {
+				size_t n = 0;
+				while (i + n < _num_chunks && !_populated[i + n])
+					n++;
+
+				if (n)
+					_populate(i, n);
+
+				i += n ? n : 1;
+			}
+		}
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param sub_rm   region map of the managed dataspace handed out
+		 *                 to the child
+		 * \param backing  RAM dataspace of the size of 'content'
+		 */
+		inline Lazy_ram_dataspace_info(Env &, Allocator &, Lazy_fork_state &,
+		                               Capability<Region_map>   sub_rm,
+		                               Ram_dataspace_capability backing,
+		                               Dataspace_capability     content);
+
+		inline ~Lazy_ram_dataspace_info();
+
+		inline void release(Ram_allocator &) override;
+
+		inline Dataspace_capability fork(Ram_allocator &, Region_map &,
+		                                 Allocator &, Dataspace_registry &,
+		                                 Rpc_entrypoint &) override;
+
+		inline Dataspace_capability fork_lazily(Lazy_fork &) override;
+
+		inline void poke(Region_map &, addr_t, char const *, size_t) override;
+};
+
+
+class Noux::Lazy_fork_state : public Lazy_fork
+{
+	public:
+
+		struct Stats
+		{
+			size_t total  = 0;
+			size_t copied = 0;
+		};
+
+	private:
+
+		friend class Lazy_ram_dataspace_info;
+
+		/*
+		 * Period the parent is blocked at most unless the fork is done on
+		 * behalf of 'vfork'
+		 */
+		enum { RELEASE_TIMEOUT_MS = 20 };
+
+		Env                  &_env;
+		Allocator            &_alloc;
+		Pd_session_component &_dst_pd;
+
+		Rm_connection _rm { _env };
+
+		Lock     _lock;
+		unsigned _refs     = 1;
+		bool     _released = false;
+		Stats    _stats;
+
+		List<Lazy_ram_dataspace_info> _infos;
+
+		/* blocks the parent until the fork is released */
+		Lock _parent_blocker { Lock::LOCKED };
+
+		template <typename FN>
+		auto _with_rm_upgrade(FN const &fn) -> decltype(fn())
+		{
+			for (;;) {
+				try { return fn(); }
+				catch (Out_of_ram)  { _rm.upgrade_ram(8*1024); }
+				catch (Out_of_caps) { _rm.upgrade_caps(2); }
+			}
+		}
+
+		void _release()
+		{
+			for (Lazy_ram_dataspace_info *i = _infos.first(); i; i = i->_next_info())
+				i->_detach_locally();
+
+			_released = true;
+			_parent_blocker.unlock();
+		}
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param dst_pd  PD of the forked process
+		 *
+		 * \throw Service_denied  RM service is unavailable
+		 */
+		Lazy_fork_state(Env &env, Allocator &alloc, Pd_session_component &dst_pd)
+		: _env(env), _alloc(alloc), _dst_pd(dst_pd) { }
+
+		void ref()
+		{
+			Lock::Guard guard(_lock);
+			_refs++;
+		}
+
+		/**
+		 * Drop reference, destroy object when the last reference is gone
+		 */
+		void unref()
+		{
+			bool last = false;
+			{
+				Lock::Guard guard(_lock);
+				last = !--_refs;
+			}
+			if (last)
+				destroy(_alloc, this);
+		}
+
+		Stats stats()
+		{
+			Lock::Guard guard(_lock);
+			return _stats;
+		}
+
+		/**
+		 * Copy all chunks not populated yet and release the parent
+		 */
+		void complete()
+		{
+			Lock::Guard guard(_lock);
+
+			if (_released)
+				return;
+
+			try {
+				for (Lazy_ram_dataspace_info *i = _infos.first(); i; i = i->_next_info())
+					i->_complete();
+			} catch (...) { error("failed to complete lazy fork"); }
+
+			_release();
+		}
+
+		/**
+		 * Release the parent without copying the remaining chunks
+		 *
+		 * Used once the child's address space is no longer of interest,
+		 * i.e., if the child exits or replaces itself via 'execve'.
+		 */
+		void abandon()
+		{
+			Lock::Guard guard(_lock);
+
+			if (!_released)
+				_release();
+		}
+
+		/**
+		 * Block the calling parent until the fork is released
+		 *
+		 * \param vfork  if true, wait until the child calls 'execve' or
+		 *               exits, otherwise complete the fork after a
+		 *               timeout at the latest
+		 */
+		void wait_for_release(Timeout_scheduler &scheduler, bool vfork)
+		{
+			if (vfork) {
+				_parent_blocker.lock();
+				return;
+			}
+
+			Timeout_state state;
+			Timeout_alarm alarm(state, _parent_blocker, scheduler, RELEASE_TIMEOUT_MS);
+
+			_parent_blocker.lock();
+			alarm.discard();
+
+			complete();
+		}
+
+
+		/************************
+		 ** Lazy_fork interface **
+		 ************************/
+
+		Dataspace_capability fork(Dataspace_capability content) override
+		{
+			size_t const size = Dataspace_client(content).size();
+
+			Capability<Region_map>   sub_rm;
+			Ram_dataspace_capability backing;
+
+			try {
+				sub_rm  = _with_rm_upgrade([&] () { return _rm.create(size); });
+				backing = _env.ram().alloc(size);
+
+				Lazy_ram_dataspace_info *info = new (_alloc)
+					Lazy_ram_dataspace_info(_env, _alloc, *this,
+					                        sub_rm, backing, content);
+				_dst_pd.adopt(*info);
+
+				return info->ds_cap();
+
+			} catch (...) {
+
+				if (backing.valid()) _env.ram().free(backing);
+				if (sub_rm.valid())  _rm.destroy(sub_rm);
+
+				/* let the caller fall back to copying eagerly */
+				return Dataspace_capability();
+			}
+		}
+};
+
+
+Noux::Lazy_ram_dataspace_info::Lazy_ram_dataspace_info(Env &env,
+                                                       Allocator &alloc,
+                                                       Lazy_fork_state &state,
+                                                       Capability<Region_map>   sub_rm,
+                                                       Ram_dataspace_capability backing,
+                                                       Dataspace_capability     content)
+:
+	Ram_dataspace_info(static_cap_cast<Ram_dataspace>(Region_map_client(sub_rm).dataspace())),
+	_env(env), _alloc(alloc), _state(state), _sub_rm(sub_rm),
+	_backing(backing), _content(content)
+{
+	for (size_t i = 0; i < _num_chunks; i++)
+		_populated[i] = false;
+
+	_sub_rm.fault_handler(_fault_handler);
+
+	_state.ref();
+
+	Lock::Guard guard(_state._lock);
+	_state._infos.insert(this);
+	_state._stats.total += size();
+}
+
+
+Noux::Lazy_ram_dataspace_info::~Lazy_ram_dataspace_info()
+{
+	{
+		Lock::Guard guard(_state._lock);
+		_detach_locally();
+		_state._infos.remove(this);
+	}
+
+	_state._rm.destroy(_sub_rm);
+	_env.ram().free(_backing);
+	_alloc.free(_populated, _num_chunks*sizeof(bool));
+
+	_state.unref();
+}
+
+
+void Noux::Lazy_ram_dataspace_info::_handle_fault()
+{
+	Lock::Guard guard(_state._lock);
+
+	for (;;) {
+		Region_map::State const fault = _sub_rm.state();
+		if (fault.type == Region_map::State::READY)
+			return;
+
+		size_t const chunk = fault.addr / CHUNK_SIZE;
+		if (chunk >= _num_chunks || _populated[chunk]) {
+			error("unresolvable fault in lazily forked dataspace at ",
+			      Hex(fault.addr));
+			return;
+		}
+
+		/* attaching the chunk resolves all faults within the chunk */
+		try { _populate(chunk, 1); }
+		catch (...) {
+			error("failed to populate lazily forked dataspace at ",
+			      Hex(fault.addr));
+			return;
+		}
+	}
+}
+
+
+void Noux::Lazy_ram_dataspace_info::_attach_locally()
+{
+	if (!_content_local)
+		_content_local = _env.rm().attach(_content);
+
+	if (!_backing_local)
+		_backing_local = _env.rm().attach(_backing);
+}
+
+
+void Noux::Lazy_ram_dataspace_info::_detach_locally()
+{
+	if (_content_local) _env.rm().detach(_content_local);
+	if (_backing_local) _env.rm().detach(_backing_local);
+
+	_content_local = _backing_local = nullptr;
+}
+
+
+void Noux::Lazy_ram_dataspace_info::_populate(size_t first, size_t num)
+{
+	addr_t const offset = first*CHUNK_SIZE;
+	size_t const len    = min(num*CHUNK_SIZE, size() - offset);
+
+	if (!_state._released) {
+		_attach_locally();
+		memcpy(_backing_local + offset, _content_local + offset, len);
+		_state._stats.copied += len;
+	}
+
+	_state._with_rm_upgrade([&] () {
+		return _sub_rm.attach(_backing, len, offset, true, offset); });
+
+	for (size_t i = first; i < first + num; i++)
+		_populated[i] = true;
+}
+
+
+void Noux::Lazy_ram_dataspace_info::release(Ram_allocator &)
+{
+	/* the backing store is freed by the destructor */
+}
+
+
+Noux::Dataspace_capability
+Noux::Lazy_ram_dataspace_info::fork(Ram_allocator      &ram,
+                                    Region_map         &local_rm,
+                                    Allocator          &alloc,
+                                    Dataspace_registry &ds_registry,
+                                    Rpc_entrypoint     &)
+{
+	_state.complete();
+
+	return copy(_backing, ram, local_rm, alloc, ds_registry);
+}
+
+
+Noux::Dataspace_capability
+Noux::Lazy_ram_dataspace_info::fork_lazily(Lazy_fork &lazy_fork)
+{
+	_state.complete();
+
+	return lazy_fork.fork(_backing);
+}
+
+
+void Noux::Lazy_ram_dataspace_info::poke(Region_map &local_rm, addr_t dst_offset,
+                                         char const *src, size_t len)
+{
+	if (!src) return;
+
+	if ((dst_offset >= size()) || (dst_offset + len > size())) {
+		error("illegal attemt to write beyond dataspace boundary");
+		return;
+	}
+
+	Lock::Guard guard(_state._lock);
+
+	/* make sure that the chunks do not get overwritten when populated */
+	size_t const first = dst_offset / CHUNK_SIZE;
+	size_t const last  = (dst_offset + len - 1) / CHUNK_SIZE;
+	for (size_t i = first; i <= last; i++)
+		if (!_populated[i])
+			_populate(i, 1);
+
+	try {
+		Attached_dataspace ds(local_rm, _backing);
+		memcpy(ds.local_addr<char>() + dst_offset, src, len);
+	} catch (...) { warning("poke: failed to attach RAM dataspace"); }
+}
+
+#endif /* _NOUX__LAZY_FORK_H_ */
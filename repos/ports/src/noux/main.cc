@@ -22,6 +22,7 @@
 #include <noux_session/sysio.h>
 #include <vfs_io_channel.h>
 #include <terminal_io_channel.h>
+#include <pipe_io_channel.h>
 #include <user_info.h>
 #include <io_receptor_registry.h>
 #include <destruct_queue.h>
@@ -35,6 +36,14 @@ namespace Noux {
 
 	bool init_process(Child *child) { return child == init_child; }
 	void init_process_exited(int exit) { init_child = 0; exit_value = exit; }
+
+	static bool lazy_fork = true;
+
+	bool lazy_fork_enabled() { return lazy_fork; }
+
+	static size_t pipe_buffer_size = Pipe::DEFAULT_SIZE;
+
+	size_t pipe_size() { return pipe_buffer_size; }
 }
 
 extern void init_network();
@@ -292,6 +301,11 @@ struct Noux::Main
 	{
 		log("--- noux started ---");
 
+		lazy_fork = _config.xml().attribute_value("lazy_fork", true);
+
+		pipe_buffer_size = _config.xml().attribute_value("pipe_size",
+			Number_of_bytes((size_t)Pipe::DEFAULT_SIZE));
+
 		_init_child.add_io_channel(_channel_0, 0);
 		_init_child.add_io_channel(_channel_1, 1);
 		_init_child.add_io_channel(_channel_2, 2);
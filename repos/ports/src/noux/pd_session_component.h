@@ -45,19 +45,22 @@ struct Noux::Ram_dataspace_info : Dataspace_info,
 	Ram_dataspace_info(Ram_dataspace_capability ds_cap)
 	: Dataspace_info(ds_cap) { }
 
-	Dataspace_capability fork(Ram_allocator      &ram,
-	                          Region_map         &local_rm,
-	                          Allocator          &alloc,
-	                          Dataspace_registry &ds_registry,
-	                          Rpc_entrypoint     &) override
+	/**
+	 * Create RAM dataspace with a copy of the content of 'src'
+	 */
+	static Dataspace_capability copy(Dataspace_capability  src,
+	                                 Ram_allocator        &ram,
+	                                 Region_map           &local_rm,
+	                                 Allocator            &alloc,
+	                                 Dataspace_registry   &ds_registry)
 	{
-		size_t const size = Dataspace_client(ds_cap()).size();
+		size_t const size = Dataspace_client(src).size();
 		Ram_dataspace_capability dst_ds_cap;
 
 		try {
 			dst_ds_cap = ram.alloc(size);
 
-			Attached_dataspace src_ds(local_rm, ds_cap());
+			Attached_dataspace src_ds(local_rm, src);
 			Attached_dataspace dst_ds(local_rm, dst_ds_cap);
 			memcpy(dst_ds.local_addr<char>(), src_ds.local_addr<char>(), size);
 
@@ -74,6 +77,28 @@ struct Noux::Ram_dataspace_info : Dataspace_info,
 		}
 	}
 
+	Dataspace_capability fork(Ram_allocator      &ram,
+	                          Region_map         &local_rm,
+	                          Allocator          &alloc,
+	                          Dataspace_registry &ds_registry,
+	                          Rpc_entrypoint     &) override
+	{
+		return copy(ds_cap(), ram, local_rm, alloc, ds_registry);
+	}
+
+	Dataspace_capability fork_lazily(Lazy_fork &lazy_fork) override
+	{
+		return lazy_fork.fork(ds_cap());
+	}
+
+	/**
+	 * Free backing store of the dataspace
+	 */
+	virtual void release(Ram_allocator &ram)
+	{
+		ram.free(static_cap_cast<Ram_dataspace>(ds_cap()));
+	}
+
 	void poke(Region_map &rm, addr_t dst_offset, char const *src, size_t len) override
 	{
 		if (!src) return;
@@ -177,16 +202,24 @@ class Noux::Pd_session_component : public Rpc_object<Pd_session>
 		Region_map &linker_area_region_map()   { return _linker_area;   }
 		Region_map &stack_area_region_map()    { return _stack_area;    }
 
+		/**
+		 * Replay address space into the protection domain of a forked
+		 * process
+		 *
+		 * \param lazy_fork  creator of RAM dataspace copies populated on
+		 *                   demand, or nullptr for copying eagerly
+		 */
 		void replay(Pd_session_component &dst_pd,
 		            Region_map           &local_rm,
 		            Allocator            &alloc,
 		            Dataspace_registry   &ds_registry,
-		            Rpc_entrypoint       &ep)
+		            Rpc_entrypoint       &ep,
+		            Lazy_fork            *lazy_fork = nullptr)
 		{
 			/* replay region map into new protection domain */
-			_stack_area   .replay(dst_pd, dst_pd.stack_area_region_map(),    local_rm, alloc, ds_registry, ep);
-			_linker_area  .replay(dst_pd, dst_pd.linker_area_region_map(),   local_rm, alloc, ds_registry, ep);
-			_address_space.replay(dst_pd, dst_pd.address_space_region_map(), local_rm, alloc, ds_registry, ep);
+			_stack_area   .replay(dst_pd, dst_pd.stack_area_region_map(),    local_rm, alloc, ds_registry, ep, lazy_fork);
+			_linker_area  .replay(dst_pd, dst_pd.linker_area_region_map(),   local_rm, alloc, ds_registry, ep, lazy_fork);
+			_address_space.replay(dst_pd, dst_pd.address_space_region_map(), local_rm, alloc, ds_registry, ep, lazy_fork);
 
 			Region_map &dst_address_space = dst_pd.address_space_region_map();
 			Region_map &dst_stack_area    = dst_pd.stack_area_region_map();
@@ -263,6 +296,18 @@ class Noux::Pd_session_component : public Rpc_object<Pd_session>
 		Cap_quota cap_quota() const { return _pd.cap_quota(); }
 		Cap_quota used_caps() const { return _pd.used_caps(); }
 
+		/**
+		 * Take over RAM dataspace created on behalf of the PD, e.g., by a
+		 * lazy fork
+		 */
+		void adopt(Ram_dataspace_info &ds_info)
+		{
+			_ds_registry.insert(&ds_info);
+			_ds_list.insert(&ds_info);
+
+			_used_ram_quota = Ram_quota { _used_ram_quota.value + ds_info.size() };
+		}
+
 		Ram_dataspace_capability alloc(size_t size, Cache_attribute cached) override
 		{
 			Ram_dataspace_capability ds_cap = _ram.alloc(size, cached);
@@ -294,7 +339,7 @@ class Noux::Pd_session_component : public Rpc_object<Pd_session>
 				_ds_registry.remove(ds_info);
 				ds_info->dissolve_users();
 				_ds_list.remove(ds_info);
-				_ram.free(ds_cap);
+				ds_info->release(_ram);
 
 				_used_ram_quota = Ram_quota { _used_ram_quota.value - ds_size };
 			};
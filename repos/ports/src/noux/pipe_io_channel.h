@@ -26,15 +26,43 @@ namespace Noux {
 
 class Noux::Pipe : public Reference_counter
 {
+	public:
+
+		enum { DEFAULT_SIZE = 64*1024, MAX_SIZE = 1024*1024 };
+
 	private:
 
 		Lock mutable _lock;
 
-		enum { BUFFER_SIZE = 4096 };
-		char _buffer[BUFFER_SIZE];
+		/**
+		 * Part of the pipe buffer, allocated on demand
+		 */
+		struct Segment
+		{
+			enum { SIZE = 4096 };
+
+			Segment *next  = nullptr;
+			size_t   start = 0;
+			size_t   end   = 0;
+			char     data[SIZE];
+		};
+
+		Allocator &_alloc;
 
-		unsigned _read_offset;
-		unsigned _write_offset;
+		size_t const _capacity;
+
+		/* queue of segments holding the buffered data */
+		Segment *_head = nullptr;
+		Segment *_tail = nullptr;
+
+		/* recently drained segment kept to avoid allocations at steady state */
+		Segment *_spare = nullptr;
+
+		/* number of buffered bytes */
+		size_t _avail = 0;
+
+		/* destination buffers of blocked readers */
+		List<Read_offer> _read_offers;
 
 		Signal_context_capability _read_ready_sigh;
 		Signal_context_capability _write_ready_sigh;
@@ -44,21 +72,11 @@ class Noux::Pipe : public Reference_counter
 		/**
 		 * Return space available in the buffer for writing, in bytes
 		 */
-		size_t _avail_buffer_space() const
-		{
-			if (_read_offset < _write_offset)
-				return (BUFFER_SIZE - _write_offset) + _read_offset - 1;
-
-			if (_read_offset > _write_offset)
-				return _read_offset - _write_offset - 1;
-
-			/* _read_offset == _write_offset */
-			return BUFFER_SIZE - 1;
-		}
+		size_t _avail_buffer_space() const { return _capacity - _avail; }
 
 		bool _any_space_avail_for_writing() const
 		{
-			return _avail_buffer_space() > 0;;
+			return _avail_buffer_space() > 0;
 		}
 
 		void _wake_up_reader()
@@ -73,14 +91,62 @@ class Noux::Pipe : public Reference_counter
 				Signal_transmitter(_write_ready_sigh).submit();
 		}
 
+		/**
+		 * Append empty segment to the queue
+		 *
+		 * \return  false if the segment could not be allocated
+		 */
+		bool _append_segment()
+		{
+			Segment *s = _spare;
+			_spare = nullptr;
+
+			if (!s) {
+				try { s = new (_alloc) Segment; }
+				catch (...) { return false; }
+			}
+			s->next = nullptr; s->start = s->end = 0;
+
+			if (_tail) _tail->next = s;
+			else       _head       = s;
+			_tail = s;
+			return true;
+		}
+
+		void _release_head_segment()
+		{
+			Segment *s = _head;
+			_head = s->next;
+			if (!_head)
+				_tail = nullptr;
+
+			if (_spare) destroy(_alloc, s);
+			else        _spare = s;
+		}
+
 	public:
 
-		Pipe()
-		: _read_offset(0), _write_offset(0), _writer_is_gone(false) { }
+		/**
+		 * Constructor
+		 *
+		 * \param capacity  maximum number of buffered bytes
+		 */
+		Pipe(Allocator &alloc, size_t capacity = DEFAULT_SIZE)
+		:
+			_alloc(alloc),
+			_capacity(max((size_t)Segment::SIZE, min(capacity, (size_t)MAX_SIZE))),
+			_writer_is_gone(false)
+		{ }
 
 		~Pipe()
 		{
 			Lock::Guard guard(_lock);
+
+			while (_head)
+				_release_head_segment();
+
+			if (_spare)
+				destroy(_alloc, _spare);
 		}
 
 		void writer_close()
@@ -114,91 +180,112 @@ class Noux::Pipe : public Reference_counter
 		{
 			Lock::Guard guard(_lock);
 
-			return _read_offset != _write_offset;
+			return _avail > 0;
 		}
 
-		size_t read(char *dst, size_t dst_len)
+		void offer_read(Read_offer &offer)
 		{
 			Lock::Guard guard(_lock);
+			_read_offers.insert(&offer);
+		}
 
-			if (_read_offset < _write_offset) {
+		void withdraw_read(Read_offer &offer)
+		{
+			Lock::Guard guard(_lock);
+			_read_offers.remove(&offer);
+		}
 
-				size_t len = min(dst_len, _write_offset - _read_offset);
-				memcpy(dst, &_buffer[_read_offset], len);
+		size_t read(char *dst, size_t dst_len)
+		{
+			Lock::Guard guard(_lock);
 
-				_read_offset += len;
-				_wake_up_writer();
+			bool const pipe_was_full = !_any_space_avail_for_writing();
 
-				return len;
-			}
+			size_t const total = min(dst_len, _avail);
 
-			if (_read_offset > _write_offset) {
+			size_t count = 0;
+			while (count < total) {
 
-				size_t const upper_len = min(dst_len, BUFFER_SIZE - _read_offset);
-				memcpy(dst, &_buffer[_read_offset], upper_len);
+				Segment &s = *_head;
+				size_t const len = min(total - count, s.end - s.start);
 
-				size_t const lower_len = min(dst_len - upper_len, _write_offset);
-				if (lower_len) {
-					memcpy(dst + upper_len, &_buffer[0], lower_len);
-					_read_offset = lower_len;
-				} else {
-					_read_offset += upper_len;
-				}
-				_wake_up_writer();
+				memcpy(dst + count, s.data + s.start, len);
+				s.start += len;
+				count   += len;
 
-				return upper_len + lower_len;
+				if (s.start < s.end)
+					continue;
+
+				/* keep the last segment for further writes */
+				if (&s == _tail) s.start = s.end = 0;
+				else             _release_head_segment();
 			}
+			_avail -= count;
+
+			/* a writer blocks only if the pipe is full */
+			if (count && pipe_was_full)
+				_wake_up_writer();
 
-			/* _read_offset == _write_offset */
-			return 0;
+			return count;
 		}
 
 		/**
 		 * Write to pipe buffer
 		 *
+		 * If a reader is blocked at the empty pipe, the data is copied
+		 * directly into the reader's buffer.
+		 *
 		 * \return number of written bytes (may be less than 'len')
 		 */
 		size_t write(char *src, size_t len)
 		{
 			Lock::Guard guard(_lock);
 
-			/* trim write request to the available buffer space */
-			size_t const trimmed_len = min(len, _avail_buffer_space());
+			if (!_avail) {
+				for (Read_offer *o = _read_offers.first(); o; o = o->next()) {
+					if (o->count || !o->max)
+						continue;
+
+					o->count = min(len, o->max);
+					memcpy(o->dst, src, o->count);
+					_read_offers.remove(o);
+					_wake_up_reader();
+					return o->count;
+				}
+			}
 
 			/*
 			 * Remember pipe state prior writing to see whether a reader
 			 * must be unblocked after writing.
 			 */
-			bool const pipe_was_empty = (_read_offset == _write_offset);
+			bool const pipe_was_empty = (_avail == 0);
 
-			/* write data up to the upper boundary of the pipe buffer */
-			size_t const upper_len = min(BUFFER_SIZE - _write_offset, trimmed_len);
-			memcpy(&_buffer[_write_offset], src, upper_len);
+			/* trim write request to the available buffer space */
+			size_t const trimmed_len = min(len, _avail_buffer_space());
 
-			_write_offset += upper_len;
+			size_t count = 0;
+			while (count < trimmed_len) {
 
-			/*
-			 * Determine number of remaining bytes beyond the buffer boundary.
-			 * The buffer wraps. So this data will end up in the lower part
-			 * of the pipe buffer.
-			 */
-			size_t const lower_len = trimmed_len - upper_len;
+				if ((!_tail || _tail->end == Segment::SIZE) && !_append_segment())
+					break;
 
-			if (lower_len > 0) {
+				Segment &s = *_tail;
+				size_t const curr_len = min(trimmed_len - count, Segment::SIZE - s.end);
 
-				/* pipe buffer wrap-around, write remaining data to the lower part */
-				memcpy(&_buffer[0], src + upper_len, lower_len);
-				_write_offset = lower_len;
+				memcpy(s.data + s.end, src + count, curr_len);
+				s.end += curr_len;
+				count += curr_len;
 			}
+			_avail += count;
 
 			/*
 			 * Wake up reader who may block for incoming data.
 			 */
-			if (pipe_was_empty || !_any_space_avail_for_writing())
+			if (count && (pipe_was_empty || !_any_space_avail_for_writing()))
 				_wake_up_reader();
 
 			/* return number of written bytes */
-			return trimmed_len;
+			return count;
 		}
 
 		void register_write_ready_sigh(Signal_context_capability sigh)
@@ -303,6 +390,10 @@ class Noux::Pipe_source_io_channel : public Io_channel
 
 		~Pipe_source_io_channel() { _pipe->reader_close(); }
 
+		void offer_read(Read_offer &offer) override { _pipe->offer_read(offer); }
+
+		void withdraw_read(Read_offer &offer) override { _pipe->withdraw_read(offer); }
+
 		bool check_unblock(bool rd, bool wr, bool ex) const override
 		{
 			/* unblock if the writer has already closed its pipe end */
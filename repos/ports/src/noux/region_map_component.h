@@ -161,13 +161,16 @@ class Noux::Region_map_component : public Rpc_object<Region_map>,
 		 *                     of newly created dataspaces
 		 * \param ep           entrypoint used to serve the RPC interface
 		 *                     of forked managed dataspaces
+		 * \param lazy_fork    creator of RAM dataspace copies populated on
+		 *                     demand, or nullptr for copying eagerly
 		 */
 		void replay(Ram_allocator      &dst_ram,
 		            Region_map         &dst_rm,
 		            Region_map         &local_rm,
 		            Allocator          &alloc,
 		            Dataspace_registry &ds_registry,
-		            Rpc_entrypoint     &ep)
+		            Rpc_entrypoint     &ep,
+		            Lazy_fork          *lazy_fork = nullptr)
 		{
 			Lock::Guard guard(_region_lock);
 			for (Region *curr = _regions.first(); curr; curr = curr->next_region()) {
@@ -177,7 +180,11 @@ class Noux::Region_map_component : public Rpc_object<Region_map>,
 					Dataspace_capability ds;
 					if (info) {
 
-						ds = info->fork(dst_ram, local_rm, alloc, ds_registry, ep);
+						if (lazy_fork)
+							ds = info->fork_lazily(*lazy_fork);
+
+						if (!ds.valid())
+							ds = info->fork(dst_ram, local_rm, alloc, ds_registry, ep);
 
 						/*
 						 * XXX We could detect dataspaces that are attached
@@ -38,13 +38,63 @@ namespace Noux {
 };
 
 
+void Noux::Child::_execute_batch()
+{
+	Sysio::Batch &batch = _sysio.batch;
+
+	unsigned const num = min(batch.count, (unsigned)Sysio::Batch::MAX_ENTRIES);
+
+	/* reset the queue before executing the entries via 'syscall' */
+	batch.count = 0;
+
+	if (!num)
+		return;
+
+	size_t const args_size = _sysio.args_size();
+
+	if (!_saved_args)
+		_saved_args = (char *)_heap.alloc(args_size);
+
+	memcpy(_saved_args, _sysio.args(), args_size);
+
+	for (unsigned i = 0; i < num; i++) {
+
+		Sysio::Batch::Entry &entry = batch.entries[i];
+		Syscall const sc = (Syscall)entry.syscall;
+
+		if (!_batchable(sc)) {
+			error("syscall ", Noux::Session::syscall_name(sc), " cannot be batched");
+			entry.result = false;
+			continue;
+		}
+
+		memcpy(_sysio.args(), entry.args, sizeof(entry.args));
+
+		entry.result = syscall(sc);
+		entry.error  = _sysio.error;
+
+		memcpy(entry.args, _sysio.args(), sizeof(entry.args));
+	}
+
+	memcpy(_sysio.args(), _saved_args, args_size);
+}
+
+
 bool Noux::Child::syscall(Noux::Session::Syscall sc)
 {
+	/* execute syscalls queued in front of this one */
+	if (_sysio.batch.count)
+		_execute_batch();
+
 	if (_verbose.syscalls())
 		log("PID ", pid(), " -> SYSCALL ", Noux::Session::syscall_name(sc));
 
 	bool result = false;
 
+	/* let the parent resume before interacting with other processes */
+	if (_lazy_fork && !_vforked && !_harmless_for_lazy_fork(sc))
+		_release_lazy_fork(true);
+
 	try {
 		switch (sc) {
 
@@ -82,10 +132,21 @@ bool Noux::Child::syscall(Noux::Session::Syscall sc)
 			{
 				Shared_pointer<Io_channel> io = _lookup_channel(_sysio.read_in.fd);
 
-				if (!io->nonblocking())
-					_block_for_io_channel(io, true, false, false);
+				Read_offer offer(_sysio.read_out.chunk,
+				                 min(_sysio.read_in.count,
+				                     sizeof(_sysio.read_out.chunk)));
+
+				if (!io->nonblocking()) {
+					io->offer_read(offer);
+					_block_for_io_channel(io, true, false, false, &offer);
+					io->withdraw_read(offer);
+				}
 
-				if (io->check_unblock(true, false, false))
+				if (offer.count) {
+					_sysio.read_out.count = offer.count;
+					result = true;
+				}
+				else if (io->check_unblock(true, false, false))
 					result = io->read(_sysio);
 				else
 					_sysio.error.read = Vfs::File_io_service::READ_ERR_INTERRUPT;
@@ -511,10 +572,24 @@ bool Noux::Child::syscall(Noux::Session::Syscall sc)
 
 				_assign_io_channels_to(child);
 
+				/*
+				 * Copy RAM dataspaces on demand if possible, the eager copy
+				 * is used as fallback
+				 */
+				Lazy_fork_state *lazy_fork = nullptr;
+				if (lazy_fork_enabled())
+					try { lazy_fork = new (_heap) Lazy_fork_state(_env, _heap, child->pd()); }
+					catch (...) { warning("lazy fork unavailable, copying eagerly"); }
+
+				bool const vfork = _sysio.fork_in.vfork;
+
 				/* copy our address space into the new child */
 				try {
 					_pd.replay(child->pd(), _env.rm(), _heap,
-					           child->ds_registry(), _ep);
+					           child->ds_registry(), _ep, lazy_fork);
+
+					if (lazy_fork)
+						child->lazy_fork(*lazy_fork, vfork);
 
 					/* start executing the main thread of the new process */
 					child->start_forked_main_thread(ip, sp, parent_cap_addr);
@@ -529,6 +604,22 @@ bool Noux::Child::syscall(Noux::Session::Syscall sc)
 				catch (Region_map::Region_conflict) {
 					error("region conflict while replaying the address space"); }
 
+				if (!lazy_fork)
+					break;
+
+				/* our memory serves as source of the copy until released */
+				if (result)
+					lazy_fork->wait_for_release(_timeout_scheduler, vfork);
+				else
+					lazy_fork->abandon();
+
+				if (_verbose.enabled()) {
+					Lazy_fork_state::Stats const stats = lazy_fork->stats();
+					log("fork: copied ", stats.copied/1024, " of ",
+					    stats.total/1024, " KiB");
+				}
+				lazy_fork->unref();
+
 				break;
 			}
 
@@ -564,7 +655,7 @@ bool Noux::Child::syscall(Noux::Session::Syscall sc)
 
 		case SYSCALL_PIPE:
 			{
-				Shared_pointer<Pipe>       pipe       (new (_heap) Pipe,                                    _heap);
+				Shared_pointer<Pipe>       pipe       (new (_heap) Pipe(_heap, pipe_size()),                _heap);
 				Shared_pointer<Io_channel> pipe_sink  (new (_heap) Pipe_sink_io_channel  (pipe, _env.ep()), _heap);
 				Shared_pointer<Io_channel> pipe_source(new (_heap) Pipe_source_io_channel(pipe, _env.ep()), _heap);
 
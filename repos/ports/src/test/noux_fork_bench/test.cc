@@ -0,0 +1,132 @@
+/*
+ * \brief  Fork latency benchmark
+ * \author Norman Feske
+ * \date   2017-06-22
+ *
+ * The benchmark measures the time of fork-exit-wait cycles for parents of
+ * different memory footprints, once with a child that exits immediately
+ * and once with a child that touches all memory of the parent. The child
+ * checks the content of the inherited memory and reports a mismatch via its
+ * exit status.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+enum { ITERATIONS = 20, PAGE_SIZE = 4096 };
+
+enum Child_action { EXIT, TOUCH };
+
+
+static unsigned long long now_us()
+{
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
+	return tv.tv_sec*1000000ULL + tv.tv_usec;
+}
+
+
+static unsigned char pattern(size_t page) { return (unsigned char)(page*7 + 1); }
+
+
+/**
+ * Return true if the memory holds the pattern written by the parent
+ */
+static bool check(unsigned char const *mem, size_t size)
+{
+	for (size_t i = 0; i < size/PAGE_SIZE; i++)
+		if (mem[i*PAGE_SIZE] != pattern(i))
+			return false;
+	return true;
+}
+
+
+/**
+ * Measure fork-exit-wait cycles
+ *
+ * \return  average duration of a cycle in microseconds, or -1 on error
+ */
+static long measure(unsigned char *mem, size_t size, Child_action action,
+                    bool use_vfork)
+{
+	unsigned long long const start = now_us();
+
+	for (unsigned i = 0; i < ITERATIONS; i++) {
+
+		pid_t const pid = use_vfork ? vfork() : fork();
+		if (pid < 0) {
+			printf("Error: fork returned %d, errno=%d\n", pid, errno);
+			return -1;
+		}
+
+		/* child */
+		if (pid == 0) {
+			if (action == TOUCH) {
+				if (!check(mem, size))
+					_exit(1);
+
+				for (size_t p = 0; p < size; p += PAGE_SIZE)
+					mem[p] = 0;
+			}
+			_exit(0);
+		}
+
+		int status = 0;
+		waitpid(pid, &status, 0);
+		if (WEXITSTATUS(status)) {
+			printf("Error: child observed unexpected memory content\n");
+			return -1;
+		}
+	}
+
+	/* the parent's memory must remain untouched by the children */
+	if (!check(mem, size)) {
+		printf("Error: parent memory got modified by child\n");
+		return -1;
+	}
+
+	return (long)((now_us() - start) / ITERATIONS);
+}
+
+
+int main(int, char **)
+{
+	printf("--- test-noux_fork_bench started ---\n");
+
+	static size_t const footprints_mib[] = { 1, 8, 32, 64 };
+
+	for (size_t mib : footprints_mib) {
+
+		size_t const size = mib*1024*1024;
+
+		unsigned char *mem = (unsigned char *)malloc(size);
+		if (!mem) {
+			printf("Error: could not allocate %zu MiB\n", mib);
+			return -1;
+		}
+
+		/* touch all pages so that they are backed by RAM */
+		for (size_t i = 0; i < size/PAGE_SIZE; i++)
+			memset(mem + i*PAGE_SIZE, pattern(i), PAGE_SIZE);
+
+		long const exit_us  = measure(mem, size, EXIT,  false);
+		long const vfork_us = measure(mem, size, EXIT,  true);
+		long const touch_us = measure(mem, size, TOUCH, false);
+
+		if (exit_us < 0 || vfork_us < 0 || touch_us < 0)
+			return -1;
+
+		printf("footprint %3zu MiB: fork+exit %6ld us, vfork+exit %6ld us, "
+		       "fork+touch+exit %6ld us\n", mib, exit_us, vfork_us, touch_us);
+
+		free(mem);
+	}
+
+	printf("--- test-noux_fork_bench finished ---\n");
+	return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * \brief  Benchmark of syscall-heavy access patterns
+ * \author Norman Feske
+ * \date   2017-06-26
+ *
+ * The patterns resemble the file-system traversal of tools like 'find' or
+ * 'ls -l' and the header lookup of compilers. Each pattern is executed
+ * for a fixed number of iterations and reported as average duration per
+ * iteration.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+enum { ITERATIONS = 2000 };
+
+
+static unsigned long long now_us()
+{
+	struct timeval tv;
+	gettimeofday(&tv, nullptr);
+	return tv.tv_sec*1000000ULL + tv.tv_usec;
+}
+
+
+template <typename FN>
+static bool measure(char const *name, FN const &fn)
+{
+	unsigned long long const start = now_us();
+
+	for (unsigned i = 0; i < ITERATIONS; i++)
+		if (!fn()) {
+			printf("Error: %s failed, errno=%d\n", name, errno);
+			return false;
+		}
+
+	unsigned long long const duration = now_us() - start;
+
+	printf("%-24s %6llu.%02llu us\n", name, duration / ITERATIONS,
+	       (duration % ITERATIONS) * 100 / ITERATIONS);
+	return true;
+}
+
+
+int main(int argc, char **argv)
+{
+	printf("--- test-noux_syscall_bench started ---\n");
+
+	/* batching is disabled via the environment, see the run script */
+	char const *batch = getenv("NOUX_SYSCALL_BATCH");
+	printf("syscall batching %s\n",
+	       batch && strcmp(batch, "no") == 0 ? "disabled" : "enabled");
+
+	/* the benchmark operates on its own binary, which is always present */
+	char const *file = argc > 0 ? argv[0] : "test-noux_syscall_bench";
+	char        buf[64];
+	struct stat st;
+
+	bool ok = true;
+
+	ok = ok && measure("getpid", [&] () { return getpid() > 0; });
+
+	ok = ok && measure("stat", [&] () { return stat(file, &st) == 0; });
+
+	ok = ok && measure("open+close", [&] () {
+		int fd = open(file, O_RDONLY);
+		return fd >= 0 && close(fd) == 0; });
+
+	ok = ok && measure("open+fstat+read+close", [&] () {
+		int fd = open(file, O_RDONLY);
+		bool const result = fd >= 0
+		                 && fstat(fd, &st) == 0
+		                 && read(fd, buf, sizeof(buf)) > 0;
+		return close(fd) == 0 && result; });
+
+	ok = ok && measure("open+cloexec+close", [&] () {
+		int fd = open(file, O_RDONLY);
+		return fd >= 0
+		    && fcntl(fd, F_SETFD, FD_CLOEXEC) == 0
+		    && close(fd) == 0; });
+
+	ok = ok && measure("opendir+readdir+closedir", [&] () {
+		DIR *dir = opendir("/");
+		if (!dir)
+			return false;
+		while (readdir(dir));
+		return closedir(dir) == 0; });
+
+	/* the lowest free fd is reused after a deferred close */
+	int const fd_1 = open(file, O_RDONLY);
+	close(fd_1);
+	int const fd_2 = open(file, O_RDONLY);
+	close(fd_2);
+	if (fd_1 != fd_2) {
+		printf("Error: fd %d not reused after close, got %d\n", fd_1, fd_2);
+		ok = false;
+	}
+
+	if (!ok)
+		return -1;
+
+	printf("--- test-noux_syscall_bench finished ---\n");
+	return 0;
+}